@@ -0,0 +1,498 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Microbenchmarks of firmware hot paths, run on the host.
+ *
+ * Each benchmark reports the time and number of allocations per operation.
+ * Results can be compared against a baseline file so that a significant
+ * slowdown (or any new allocation) is reported as a failure.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scales/buffered_write.h"
+#include "scales/compressor.h"
+#include "scales/form.h"
+#include "scales/hx711_hardware.h"
+#include "scales/recording.h"
+#include "scales/sample_clock.h"
+#include "scales/segment_pool.h"
+#include "scales/session.h"
+#include "scales/step_detector.h"
+#include "scales/trace_buffer.h"
+
+using namespace scales;
+
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void *ptr = std::malloc(size ? size : 1))
+		return ptr;
+
+	throw std::bad_alloc{};
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace {
+
+/* Prevent the compiler from optimising away a result */
+template <class T>
+inline void keep(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result {
+	std::string name;
+	double ns_per_op;
+	double allocations_per_op;
+};
+
+/*
+ * Run a function that performs a number of operations, increasing the
+ * number until it takes long enough to measure, and report the fastest
+ * of several runs.
+ */
+Result measure(const std::string &name, const std::function<void(uint64_t operations)> &func) {
+	static constexpr auto MIN_DURATION = std::chrono::milliseconds(50);
+	static constexpr int RUNS = 5;
+	uint64_t operations = 1;
+
+	while (true) {
+		auto start = std::chrono::steady_clock::now();
+		func(operations);
+		if (std::chrono::steady_clock::now() - start >= MIN_DURATION)
+			break;
+		operations *= 2;
+	}
+
+	double best_ns = 0;
+	uint64_t allocated = 0;
+
+	for (int i = 0; i < RUNS; i++) {
+		uint64_t allocations_before = allocations.load();
+		auto start = std::chrono::steady_clock::now();
+
+		func(operations);
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		allocated = allocations.load() - allocations_before;
+		if (i == 0 || elapsed.count() < best_ns)
+			best_ns = elapsed.count();
+	}
+
+	return {name, best_ns / operations, (double)allocated / operations};
+}
+
+/* Outputs a fixed conversion with no delays */
+class PatternHardware: public HX711Hardware {
+public:
+	explicit PatternHardware(uint32_t value) : value_(value & 0xFFFFFF) {}
+
+	void init() override {}
+
+	bool data() override {
+		if (pulses_ == 0)
+			return false;
+		if (pulses_ <= 24)
+			return (value_ >> (24 - pulses_)) & 1;
+		return true;
+	}
+
+	void sck(bool level) override {
+		if (level && ++pulses_ > 25)
+			pulses_ = 1;
+		else if (!level && pulses_ == 25)
+			pulses_ = 0;
+	}
+
+	void delay_us(uint32_t) override {}
+	uint64_t now_us() override { return now_us_ += 11111; }
+	void disable_interrupts() override {}
+	void enable_interrupts() override {}
+
+private:
+	const uint32_t value_;
+	unsigned int pulses_{0};
+	uint64_t now_us_{0};
+};
+
+/* Writes CBOR to memory in the same way as the qindesign CBOR writer */
+class MemoryWriter {
+public:
+	explicit MemoryWriter(size_t capacity) { data_.reserve(capacity); }
+
+	void clear() { data_.clear(); }
+	size_t size() const { return data_.size(); }
+
+	void beginArray(size_t size) { head(4, size); }
+	void writeUnsignedInt(uint64_t value) { head(0, value); }
+
+	void writeInt(int64_t value) {
+		if (value < 0) {
+			head(1, -1 - value);
+		} else {
+			head(0, value);
+		}
+	}
+
+	void writeText(const char *text) {
+		size_t length = std::strlen(text);
+
+		head(3, length);
+		data_.insert(data_.end(), text, text + length);
+	}
+
+private:
+	void head(uint8_t major, uint64_t value) {
+		major <<= 5;
+
+		if (value < 24) {
+			data_.push_back(major | value);
+		} else if (value <= 0xFF) {
+			data_.push_back(major | 24);
+			data_.push_back(value);
+		} else if (value <= 0xFFFF) {
+			data_.push_back(major | 25);
+			data_.push_back(value >> 8);
+			data_.push_back(value);
+		} else {
+			data_.push_back(major | 26);
+			data_.push_back(value >> 24);
+			data_.push_back(value >> 16);
+			data_.push_back(value >> 8);
+			data_.push_back(value);
+		}
+	}
+
+	std::vector<uint8_t> data_;
+};
+
+std::vector<Result> run_benchmarks() {
+	static constexpr size_t BUFFER_SIZE = 90 * 900;
+	static constexpr size_t WEB_BUFFER_SIZE = 1436 - 7;
+	std::vector<Result> results;
+
+	/* HX711::loop() */
+	results.push_back(measure("hx711_read", [] (uint64_t operations) {
+		PatternHardware hardware{0xFEDCBA};
+
+		for (uint64_t i = 0; i < operations; i++) {
+			uint32_t reading = hardware.read();
+
+			if ((reading & 1) == 1)
+				keep(recording::sign_extend(reading >> 1));
+		}
+	}));
+
+	results.push_back(measure("sample_clock", [] (uint64_t operations) {
+		SampleClock clock;
+		uint64_t time_us = 1000000;
+
+		for (uint64_t i = 0; i < operations; i++) {
+			/* 88.5Hz with up to 255us of polling jitter */
+			keep(clock.update(time_us + (i * 0x9E3779B9U >> 24)));
+			time_us += 11299;
+		}
+
+		keep(clock.jitter_ns());
+	}));
+
+	results.push_back(measure("step_detector", [] (uint64_t operations) {
+		StepDetector detector;
+
+		for (uint64_t i = 0; i < operations; i++) {
+			/* Noise of up to 255 with a step of 50000 every 1024 readings */
+			int32_t value = (i & 0x400) ? 50000 : 0;
+
+			keep(detector.update(i * 11299, value + (int32_t)(i * 0x9E3779B9U >> 24)));
+		}
+
+		keep(detector.level());
+	}));
+
+	results.push_back(measure("compressor", [] (uint64_t operations) {
+		Compressor compressor{{Compressor::Mode::SWINGING_DOOR, 128}};
+
+		for (uint64_t i = 0; i < operations; i++) {
+			/* Noise of up to 255 with a step of 50000 every 1024 readings */
+			int32_t value = (i & 0x400) ? 50000 : 0;
+
+			keep(compressor.add(i * 11299, value + (int32_t)(i * 0x9E3779B9U >> 24), false));
+		}
+	}));
+
+	static trace::Buffer::Slot trace_slots[4096];
+	trace::Buffer trace_buffer;
+
+	trace_buffer.init(trace_slots, std::size(trace_slots));
+
+	results.push_back(measure("trace_event", [&trace_buffer] (uint64_t operations) {
+		trace::Event event{};
+
+		event.name = "read";
+		event.category = trace::Category::HX711;
+
+		for (uint64_t i = 0; i < operations; i++) {
+			event.time_us = i * 11111;
+			event.phase = (i & 1) ? trace::Phase::END : trace::Phase::BEGIN;
+			trace_buffer.add(event);
+		}
+
+		keep(trace_buffer.count());
+	}));
+
+	/* HX711::append() */
+	static constexpr size_t POOL_SEGMENTS = (BUFFER_SIZE + SegmentPool::SEGMENT_READINGS - 1)
+		/ SegmentPool::SEGMENT_READINGS;
+	SegmentPool pool;
+
+	pool.init(MemoryAllocation{static_cast<Data*>(
+		std::malloc(POOL_SEGMENTS * SegmentPool::SEGMENT_BYTES))}, POOL_SEGMENTS);
+
+	Session session{pool};
+
+	results.push_back(measure("buffer_append", [&session] (uint64_t operations) {
+		session.clear();
+
+		for (uint64_t i = 0; i < operations; i++) {
+			Data data = recording::make_data(i * 11111, (i - 1) * 11111,
+				(i & 0xFFF) == 0 ? Type::TARE : Type::READING, -(int32_t)i);
+
+			if (!session.append(data)) {
+				session.clear();
+				session.append(data);
+			}
+		}
+
+		keep(session.count());
+	}));
+
+	session.clear();
+	std::vector<Data> buffer(BUFFER_SIZE);
+
+	/* HX711::save() */
+	for (size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = recording::make_data(11111 + (i % 7), 0,
+			(i % 10000) == 0 ? Type::TARE : Type::READING,
+			100000 + (int32_t)(i % 1000) - (int32_t)(i % 333));
+
+	MemoryWriter writer{buffer.size() * 8};
+
+	results.push_back(measure("save_encode", [&buffer, &writer] (uint64_t operations) {
+		while (operations > 0) {
+			size_t count = std::min(operations, (uint64_t)buffer.size());
+
+			writer.clear();
+			recording::write_readings(writer,
+				[] (MemoryWriter &writer, const char *text) { writer.writeText(text); },
+				buffer.data(), count);
+			keep(writer.size());
+			operations -= count;
+		}
+	}));
+
+	/* WebServer::Request::write() */
+	for (size_t size : {32, 512}) {
+		results.push_back(measure("request_write_" + std::to_string(size), [size] (uint64_t operations) {
+			char buffer[WEB_BUFFER_SIZE];
+			uint8_t data[512] = { 'x' };
+			size_t length = 0;
+			size_t sent = 0;
+
+			for (uint64_t i = 0; i < operations; i++) {
+				buffered_write(buffer, sizeof(buffer), length, data, size, [&] {
+					sent += length;
+					length = 0;
+				});
+			}
+
+			keep(sent);
+		}));
+	}
+
+	/* WebInterface */
+	results.push_back(measure("parse_form", [] (uint64_t operations) {
+		static constexpr std::string_view text = "f=1735689600.cbor&f=1735690500.cbor&f=1735691400.cbor&action=delete";
+		size_t count = 0;
+
+		for (uint64_t i = 0; i < operations; i++) {
+			parse_form(text, [&count] (std::string_view name, std::string_view value) {
+				count += name.size() + value.size();
+			});
+		}
+
+		keep(count);
+	}));
+
+	results.push_back(measure("file_name", [] (uint64_t operations) {
+		char buffer[32];
+
+		for (uint64_t i = 0; i < operations; i++)
+			keep(recording::file_name("1735689600.cbor", (i & 1) == 1, buffer, sizeof(buffer)));
+	}));
+
+	return results;
+}
+
+std::map<std::string, Result> read_baseline(const char *filename) {
+	std::map<std::string, Result> baseline;
+	std::ifstream f{filename};
+	std::string line;
+
+	while (std::getline(f, line)) {
+		std::istringstream fields{line};
+		Result result;
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		if (fields >> result.name >> result.ns_per_op >> result.allocations_per_op)
+			baseline[result.name] = result;
+	}
+
+	return baseline;
+}
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-b baseline] [-w baseline] [-t tolerance]\n", name);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	const char *baseline_filename = nullptr;
+	const char *write_filename = nullptr;
+	double tolerance = 0.25;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:w:t:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			baseline_filename = optarg;
+			break;
+
+		case 'w':
+			write_filename = optarg;
+			break;
+
+		case 't':
+			tolerance = std::strtod(optarg, nullptr);
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::map<std::string, Result> baseline;
+	bool failed = false;
+
+	if (baseline_filename) {
+		baseline = read_baseline(baseline_filename);
+
+		if (baseline.empty()) {
+			std::fprintf(stderr, "%s: no baseline results\n", baseline_filename);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<Result> results = run_benchmarks();
+
+	std::printf("%-20s %12s %12s %12s %8s\n", "Benchmark", "ns/op", "allocs/op", "baseline", "change");
+
+	for (const auto &result : results) {
+		auto it = baseline.find(result.name);
+
+		std::printf("%-20s %12.2f %12.3f", result.name.c_str(),
+			result.ns_per_op, result.allocations_per_op);
+
+		if (it != baseline.end()) {
+			const Result &base = it->second;
+			double change = result.ns_per_op / base.ns_per_op - 1;
+			bool slower = change > tolerance;
+			bool allocates = result.allocations_per_op > base.allocations_per_op + 0.001;
+
+			std::printf(" %12.2f %+7.1f%%%s%s", base.ns_per_op, change * 100,
+				slower ? " SLOWER" : "", allocates ? " ALLOCATES" : "");
+			failed |= slower || allocates;
+		}
+
+		std::printf("\n");
+	}
+
+	if (write_filename) {
+		std::ofstream f{write_filename};
+
+		f << "# name ns/op allocs/op\n";
+		for (const auto &result : results)
+			f << result.name << " " << result.ns_per_op << " " << result.allocations_per_op << "\n";
+
+		if (!f) {
+			std::perror(write_filename);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (failed) {
+		std::fprintf(stderr, "Performance regression (tolerance %.0f%%)\n", tolerance * 100);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Round trip test of the gzip encoder, run on the host.
+ *
+ * Varied inputs are compressed with random write sizes and decompressed
+ * with zlib, which must give back the original data. The encoder is reused
+ * with reset() so that leftover state would also be found.
+ */
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scales/gzip.h"
+
+using namespace scales;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes random_bytes(std::mt19937 &rng, size_t length) {
+	Bytes data(length);
+
+	for (auto &value : data)
+		value = rng();
+
+	return data;
+}
+
+/* Repeats of a short random pattern, with occasional changes */
+Bytes repetitive(std::mt19937 &rng, size_t length) {
+	Bytes pattern = random_bytes(rng, 1 + rng() % 300);
+	Bytes data(length);
+
+	for (size_t i = 0; i < length; i++) {
+		data[i] = pattern[i % pattern.size()];
+
+		if (rng() % 1000 == 0)
+			data[i] = rng();
+	}
+
+	return data;
+}
+
+Bytes xml(std::mt19937 &rng, size_t length) {
+	std::string text = "<?xml version=\"1.0\"?><files>";
+
+	while (text.size() < length) {
+		text += "<f n=\"" + std::to_string(1700000000 + rng() % 100000000) + ".cbor\" s=\""
+			+ std::to_string(rng() % 1000000) + "\" t=\"2025-01-0" + std::to_string(1 + rng() % 9)
+			+ "T12:" + std::to_string(10 + rng() % 50) + "\"/>";
+	}
+
+	text += "</files>";
+	return Bytes(text.begin(), text.end());
+}
+
+/* Small values with a few large ones, like the offsets in a recording */
+Bytes readings(std::mt19937 &rng, size_t length) {
+	Bytes data(length);
+
+	for (size_t i = 0; i < length; i++)
+		data[i] = (rng() % 8 == 0) ? rng() : 0x19 + rng() % 4;
+
+	return data;
+}
+
+Bytes compress(GzipEncoder &encoder, std::mt19937 &rng, const Bytes &input) {
+	Bytes output;
+	size_t pos = 0;
+
+	encoder.reset([&output] (const uint8_t *data, size_t length) {
+		output.insert(output.end(), data, data + length);
+	});
+
+	while (pos < input.size()) {
+		size_t max_length = (rng() % 4 == 0) ? 20000 : 64;
+		size_t length = std::min(input.size() - pos, (size_t)(rng() % (max_length + 1)));
+
+		encoder.write(input.data() + pos, length);
+		pos += length;
+	}
+
+	encoder.finish();
+	return output;
+}
+
+bool decompress(const Bytes &input, Bytes &output) {
+	z_stream stream{};
+	uint8_t buffer[4096];
+	int ret;
+
+	if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+		return false;
+
+	stream.next_in = const_cast<uint8_t*>(input.data());
+	stream.avail_in = input.size();
+
+	do {
+		stream.next_out = buffer;
+		stream.avail_out = sizeof(buffer);
+		ret = inflate(&stream, Z_NO_FLUSH);
+		output.insert(output.end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+	} while (ret == Z_OK);
+
+	inflateEnd(&stream);
+
+	/* There must be nothing after the end of the stream */
+	return ret == Z_STREAM_END && stream.avail_in == 0;
+}
+
+} // namespace
+
+int main() {
+	static constexpr unsigned int TESTS = 200;
+	std::mt19937 rng{1};
+	auto encoder = std::make_unique<GzipEncoder>(nullptr);
+	size_t input_bytes = 0;
+	size_t output_bytes = 0;
+	unsigned int failed = 0;
+
+	for (unsigned int i = 0; i < TESTS; i++) {
+		/* Include empty and tiny inputs, and inputs that are many windows long */
+		size_t length = (i < 4) ? i : rng() % ((i % 10 == 0) ? 200000 : 20000);
+		Bytes input;
+		const char *type;
+
+		switch (i % 4) {
+		case 0:
+			type = "random";
+			input = random_bytes(rng, length);
+			break;
+
+		case 1:
+			type = "repetitive";
+			input = repetitive(rng, length);
+			break;
+
+		case 2:
+			type = "xml";
+			input = xml(rng, length);
+			break;
+
+		default:
+			type = "readings";
+			input = readings(rng, length);
+			break;
+		}
+
+		Bytes compressed = compress(*encoder, rng, input);
+		Bytes output;
+
+		if (!decompress(compressed, output) || output != input) {
+			std::fprintf(stderr, "Test %u (%s, %zu bytes): round trip failed\n",
+				i, type, input.size());
+			failed++;
+		}
+
+		input_bytes += input.size();
+		output_bytes += compressed.size();
+	}
+
+	std::printf("%u/%u gzip round trips passed, %zu bytes compressed to %zu\n",
+		TESTS - failed, TESTS, input_bytes, output_bytes);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,416 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "analysis.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "columnar.h"
+#include "decoder.h"
+
+namespace scales {
+
+namespace analysis {
+
+namespace {
+
+using File = std::unique_ptr<FILE, decltype(&std::fclose)>;
+
+class SamplesOutput: public RecordingOutput {
+public:
+	explicit SamplesOutput(Samples &samples) : samples_(samples) {}
+
+	void header(uint64_t realtime_s, uint32_t realtime_us,
+			uint64_t start_us, uint64_t stop_us) override {
+		samples_.realtime_s = realtime_s;
+		samples_.realtime_us = realtime_us;
+		samples_.start_us = start_us;
+		samples_.stop_us = stop_us;
+	}
+
+	void reading(uint64_t time_us, int64_t value, uint8_t flags) override {
+		samples_.time_us.push_back(time_us);
+		samples_.value.push_back(value);
+		samples_.flags.push_back(flags);
+	}
+
+	void finish() override {}
+
+private:
+	Samples &samples_;
+};
+
+bool read(FILE *f, void *data, size_t length, std::string &error) {
+	if (std::fread(data, 1, length, f) != length) {
+		error = std::ferror(f) ? std::strerror(errno) : "unexpected end of file";
+		return false;
+	}
+	return true;
+}
+
+bool load_columnar(FILE *f, Samples &samples, std::string &error) {
+	columnar::FileHeader header;
+
+	if (!read(f, &header, sizeof(header), error))
+		return false;
+
+	if (std::memcmp(header.magic, columnar::MAGIC, sizeof(header.magic))
+			|| header.version != columnar::VERSION) {
+		error = "unsupported file format";
+		return false;
+	}
+
+	samples.realtime_s = header.realtime_s;
+	samples.realtime_us = header.realtime_us;
+	samples.start_us = header.start_us;
+	samples.stop_us = header.stop_us;
+
+	while (true) {
+		columnar::BlockHeader block;
+		uint8_t padding[8];
+
+		if (!read(f, &block, sizeof(block), error))
+			return false;
+
+		if (!block.rows)
+			return true;
+
+		if (block.rows > columnar::MAX_BLOCK_ROWS) {
+			error = "invalid block size";
+			return false;
+		}
+
+		size_t offset = samples.size();
+		size_t length = block.rows * (sizeof(samples.time_us[0])
+			+ sizeof(samples.value[0]) + sizeof(samples.flags[0]));
+
+		samples.time_us.resize(offset + block.rows);
+		samples.value.resize(offset + block.rows);
+		samples.flags.resize(offset + block.rows);
+
+		if (!read(f, &samples.time_us[offset], block.rows * sizeof(samples.time_us[0]), error)
+				|| !read(f, &samples.value[offset], block.rows * sizeof(samples.value[0]), error)
+				|| !read(f, &samples.flags[offset], block.rows * sizeof(samples.flags[0]), error)
+				|| !read(f, padding, columnar::block_size(block.rows) - length, error))
+			return false;
+	}
+}
+
+} // namespace
+
+void Samples::clear() {
+	realtime_s = 0;
+	realtime_us = 0;
+	start_us = 0;
+	stop_us = 0;
+	time_us.clear();
+	value.clear();
+	flags.clear();
+}
+
+bool load(const std::string &filename, Samples &samples, std::string &error) {
+	File f{std::fopen(filename.c_str(), "rb"), &std::fclose};
+
+	samples.clear();
+
+	if (!f) {
+		error = std::strerror(errno);
+		return false;
+	}
+
+	if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".col") == 0)
+		return load_columnar(f.get(), samples, error);
+
+	try {
+		SamplesOutput output{samples};
+
+		decode_recording(f.get(), output);
+		return true;
+	} catch (const std::exception &e) {
+		error = e.what();
+		return false;
+	}
+}
+
+void delta(const int32_t *__restrict in, size_t n, int32_t *__restrict out) {
+	if (!n)
+		return;
+
+	out[0] = 0;
+
+	for (size_t i = 1; i < n; i++)
+		out[i] = in[i] - in[i - 1];
+}
+
+void prefix_sum(const int32_t *__restrict in, size_t n, int64_t *__restrict out) {
+	int64_t sum = 0;
+
+	/* This is a sequential dependency but it's cheap compared to memory access */
+	for (size_t i = 0; i < n; i++) {
+		sum += in[i];
+		out[i] = sum;
+	}
+}
+
+void rolling_mean_variance(const int32_t *__restrict in, size_t n, size_t window,
+		double *__restrict mean, double *__restrict variance) {
+	/*
+	 * The sum and sum of squares are calculated using exact integer
+	 * arithmetic by adding the difference between the reading entering
+	 * the window and the reading leaving it. The readings are 24-bit so
+	 * the sum of squares over a window can't overflow.
+	 */
+	static constexpr size_t CHUNK = 1024;
+	int64_t sum[CHUNK];
+	int64_t sum2[CHUNK];
+	int64_t total = 0;
+	int64_t total2 = 0;
+
+	window = std::max(window, (size_t)1);
+
+	for (size_t start = 0; start < n; start += CHUNK) {
+		size_t length = std::min(CHUNK, n - start);
+		size_t partial = start < window ? std::min(window - start, length) : 0;
+
+		for (size_t i = 0; i < partial; i++) {
+			int64_t value = in[start + i];
+
+			sum[i] = value;
+			sum2[i] = value * value;
+		}
+
+		for (size_t i = partial; i < length; i++) {
+			int64_t value = in[start + i];
+			int64_t old = in[start + i - window];
+
+			sum[i] = value - old;
+			sum2[i] = value * value - old * old;
+		}
+
+		for (size_t i = 0; i < length; i++) {
+			total += sum[i];
+			total2 += sum2[i];
+			sum[i] = total;
+			sum2[i] = total2;
+		}
+
+		for (size_t i = 0; i < partial; i++) {
+			double count = start + i + 1;
+			double m = sum[i] / count;
+
+			mean[start + i] = m;
+			variance[start + i] = std::max(0.0, sum2[i] / count - m * m);
+		}
+
+		for (size_t i = partial; i < length; i++) {
+			double m = sum[i] / (double)window;
+
+			mean[start + i] = m;
+			variance[start + i] = std::max(0.0, sum2[i] / (double)window - m * m);
+		}
+	}
+}
+
+size_t threshold_crossings(const double *__restrict in, size_t n, double threshold) {
+	size_t count = 0;
+
+	for (size_t i = 1; i < n; i++)
+		count += (in[i - 1] < threshold) & (in[i] >= threshold);
+
+	return count;
+}
+
+void min_max(const int32_t *__restrict in, size_t n, int32_t &min, int32_t &max) {
+	int32_t lo = n ? in[0] : 0;
+	int32_t hi = lo;
+
+	for (size_t i = 0; i < n; i++) {
+		int32_t value = in[i];
+
+		lo = value < lo ? value : lo;
+		hi = value > hi ? value : hi;
+	}
+
+	min = lo;
+	max = hi;
+}
+
+Summary Analyser::analyse(const Samples &samples) {
+	const size_t n = samples.size();
+	const size_t window = std::max(parameters_.window, (size_t)1);
+	const int32_t *value = samples.value.data();
+	Summary summary;
+
+	summary.readings = n;
+	if (!n)
+		return summary;
+
+	summary.duration_s = (samples.time_us[n - 1] - samples.time_us[0]) / 1e6;
+	min_max(value, n, summary.min, summary.max);
+
+	mean_.resize(n);
+	variance_.resize(n);
+	step_.resize(n);
+	scratch_.resize(n);
+	delta_.resize(n);
+	sum_.resize(n);
+
+	prefix_sum(value, n, sum_.data());
+	summary.mean = sum_[n - 1] / (double)n;
+
+	/*
+	 * Estimate the noise from the median absolute difference between
+	 * readings, which isn't affected by steps in the value.
+	 */
+	delta(value, n, delta_.data());
+	for (size_t i = 0; i < n; i++)
+		scratch_[i] = std::abs((double)delta_[i]);
+
+	if (n > 1) {
+		auto median = scratch_.begin() + n / 2;
+
+		std::nth_element(scratch_.begin() + 1, median, scratch_.end());
+		summary.noise_rms = *median / (0.6745 * std::sqrt(2.0));
+	}
+
+	rolling_mean_variance(value, n, window, mean_.data(), variance_.data());
+
+	/* Difference between adjacent windows */
+	const size_t first = std::min(2 * window - 1, n);
+
+	std::fill(step_.begin(), step_.begin() + first, 0.0);
+	for (size_t i = first; i < n; i++)
+		step_[i] = mean_[i] - mean_[i - window];
+
+	for (size_t i = 0; i < n; i++)
+		scratch_[i] = std::abs(step_[i]);
+
+	summary.steps = threshold_crossings(scratch_.data(), n, parameters_.step_threshold);
+
+	double total_settling_ms = 0;
+	size_t settled_steps = 0;
+
+	/*
+	 * Drift is estimated from the slope of the readings over the settled
+	 * segments between steps, fitted to all of them at once with a separate
+	 * level for each segment so that the steps don't affect it.
+	 */
+	double drift_sxx = 0;
+	double drift_sxy = 0;
+	size_t segment_start = 0;
+
+	auto fit_segment = [&] (size_t begin, size_t end) {
+		if (end <= begin + 1)
+			return;
+
+		const double t0 = samples.time_us[begin] / 1e6;
+		const size_t count = end - begin;
+		double mean_t = 0;
+		double mean_v = (sum_[end - 1] - (begin ? sum_[begin - 1] : 0)) / (double)count;
+
+		for (size_t i = begin; i < end; i++)
+			mean_t += samples.time_us[i] / 1e6 - t0;
+		mean_t /= count;
+
+		for (size_t i = begin; i < end; i++) {
+			double t = samples.time_us[i] / 1e6 - t0 - mean_t;
+
+			drift_sxx += t * t;
+			drift_sxy += t * (value[i] - mean_v);
+		}
+	};
+
+	if (summary.steps) {
+		const double settled_difference = parameters_.settle_factor
+			* std::max(summary.noise_rms, 1.0);
+		const double settled_variance = settled_difference * settled_difference;
+		size_t i = 1;
+
+		while (i < n) {
+			if (scratch_[i] < parameters_.step_threshold) {
+				i++;
+				continue;
+			}
+
+			/*
+			 * The step started at approximately the first reading of the
+			 * window that exceeded the threshold. It has settled when a
+			 * window after that has a low enough variance and its mean is
+			 * close to that of the previous window.
+			 */
+			const size_t begin = i;
+			const size_t step_pos = begin + 1 - window;
+			size_t peak = i;
+
+			for (; i < n && scratch_[i] >= parameters_.step_threshold; i++) {
+				if (scratch_[i] > scratch_[peak])
+					peak = i;
+			}
+
+			size_t settled = peak;
+
+			while (settled < n && (variance_[settled] > settled_variance
+					|| scratch_[settled] > settled_difference))
+				settled++;
+
+			double step;
+
+			if (segment_start < step_pos)
+				fit_segment(segment_start, step_pos);
+
+			if (settled < n) {
+				double settling_ms = (samples.time_us[settled + 1 - window]
+					- samples.time_us[step_pos]) / 1e3;
+
+				step = mean_[settled] - mean_[begin - window];
+				total_settling_ms += settling_ms;
+				summary.max_settling_ms = std::max(summary.max_settling_ms, settling_ms);
+				settled_steps++;
+				segment_start = settled + 1 - window;
+			} else {
+				/* Use the largest difference between windows instead */
+				step = step_[peak];
+				segment_start = n;
+			}
+
+			summary.max_step = std::max(summary.max_step, std::abs(step));
+		}
+	}
+
+	if (settled_steps)
+		summary.mean_settling_ms = total_settling_ms / settled_steps;
+
+	if (segment_start < n)
+		fit_segment(segment_start, n);
+
+	if (drift_sxx > 0)
+		summary.drift_per_hour = drift_sxy / drift_sxx * 3600;
+
+	return summary;
+}
+
+} // namespace analysis
+
+} // namespace scales
@@ -0,0 +1,117 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Batch analysis of recordings.
+ *
+ * Readings are loaded into contiguous structure-of-arrays buffers and
+ * processed by simple kernels without branches in their inner loops, so
+ * that the compiler can vectorise them.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace scales {
+
+namespace analysis {
+
+struct Samples {
+	uint64_t realtime_s{0};
+	uint32_t realtime_us{0};
+	uint64_t start_us{0};
+	uint64_t stop_us{0};
+
+	std::vector<uint64_t> time_us;
+	std::vector<int32_t> value;
+	std::vector<uint8_t> flags;
+
+	inline size_t size() const { return value.size(); }
+
+	/* Remove all readings but keep the allocated memory */
+	void clear();
+};
+
+/*
+ * Load a recording (.cbor) or converted columnar file (.col), reusing the
+ * memory already allocated by the samples.
+ */
+bool load(const std::string &filename, Samples &samples, std::string &error);
+
+/* out[i] = in[i] - in[i - 1], out[0] = 0 */
+void delta(const int32_t *in, size_t n, int32_t *out);
+
+/* out[i] = in[0] + ... + in[i] */
+void prefix_sum(const int32_t *in, size_t n, int64_t *out);
+
+/*
+ * Mean and variance of the window ending at each reading. The first
+ * (window - 1) outputs use all of the readings so far.
+ */
+void rolling_mean_variance(const int32_t *in, size_t n, size_t window,
+	double *mean, double *variance);
+
+/* Number of times the input changes from below to at/above the threshold */
+size_t threshold_crossings(const double *in, size_t n, double threshold);
+
+void min_max(const int32_t *in, size_t n, int32_t &min, int32_t &max);
+
+struct Parameters {
+	size_t window{16};              /* Readings per window */
+	double step_threshold{1000};    /* Minimum step size */
+	double settle_factor{3};        /* Settled when stddev < factor * noise */
+};
+
+struct Summary {
+	size_t readings{0};
+	double duration_s{0};
+	int32_t min{0};
+	int32_t max{0};
+	double mean{0};
+	double noise_rms{0};
+	double drift_per_hour{0};
+	size_t steps{0};
+	double max_step{0};
+	double mean_settling_ms{0};
+	double max_settling_ms{0};
+};
+
+/* Analyses recordings, reusing temporary buffers between calls */
+class Analyser {
+public:
+	explicit Analyser(const Parameters &parameters) : parameters_(parameters) {}
+
+	Summary analyse(const Samples &samples);
+
+private:
+	Parameters parameters_;
+	std::vector<double> mean_;
+	std::vector<double> variance_;
+	std::vector<double> step_;
+	std::vector<double> scratch_;
+	std::vector<int32_t> delta_;
+	std::vector<int64_t> sum_;
+};
+
+} // namespace analysis
+
+} // namespace scales
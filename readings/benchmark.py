@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# hx711-weigh-scales-logger - HX711 weigh scales data logger
+# Copyright 2025  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Compare decode.py with hx711-convert on generated recordings.
+#
+# Usage: benchmark.py [--files 8] [--readings 81000] [--jobs N]
+#
+# Recordings are generated in the same format as HX711::save() (including
+# the indefinite length readings array) and the CSV output of both tools is
+# checked to be identical.
+
+import argparse
+import filecmp
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+BASE = os.path.dirname(os.path.abspath(__file__))
+
+
+def head(major, value):
+	if value < 24:
+		return bytes([major << 5 | value])
+	elif value < 0x100:
+		return bytes([major << 5 | 24, value])
+	elif value < 0x10000:
+		return bytes([major << 5 | 25]) + struct.pack(">H", value)
+	elif value < 0x100000000:
+		return bytes([major << 5 | 26]) + struct.pack(">I", value)
+	else:
+		return bytes([major << 5 | 27]) + struct.pack(">Q", value)
+
+
+def uint(value):
+	return head(0, value)
+
+
+def int_(value):
+	return head(0, value) if value >= 0 else head(1, -1 - value)
+
+
+def text(value):
+	value = value.encode("utf-8")
+	return head(3, len(value)) + value
+
+
+def recording(f, readings, rng):
+	f.write(bytes([0xD9, 0xD9, 0xF7]))
+	f.write(head(5, 5))
+	f.write(text("realtime_s_us") + head(4, 2) + uint(1735689600) + uint(rng.randrange(1000000)))
+	f.write(text("start_us") + uint(1000000))
+	f.write(text("stop_us") + uint(1000000 + readings * 11111))
+	f.write(text("readings_format") + head(4, 3)
+		+ text("[flags:text]") + text("<offset_time_us:uint>") + text("<offset_value:int>"))
+	f.write(text("readings") + bytes([0x9F]))
+
+	data = bytearray()
+	value = 0
+	previous = 0
+	for i in range(readings):
+		if i % 10000 == 0:
+			data += text("tare")
+		elif i % 10000 == 5000:
+			# Events, so that the Event column is compared too
+			data += text(("applied", "settled", "removed")[i // 10000 % 3])
+		value = max(-0x800000, min(0x7FFFFF, value + rng.randint(-2000, 2000)))
+		data += uint(11111 + rng.randint(-50, 50)) + int_(value - previous)
+		previous = value
+	f.write(data)
+	f.write(bytes([0xFF]))
+
+
+def run(name, args):
+	start = time.monotonic()
+	subprocess.run(args, check=True)
+	elapsed = time.monotonic() - start
+	print(f"{name}: {elapsed:.2f}s")
+	return elapsed
+
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Recording converter benchmark")
+	parser.add_argument("--files", type=int, default=8, help="Number of recordings")
+	parser.add_argument("--readings", type=int, default=81000, help="Readings per recording")
+	parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="hx711-convert jobs")
+	args = parser.parse_args()
+
+	subprocess.run(["make", "-C", BASE, "-s", "hx711-convert"], check=True)
+	rng = random.Random(0)
+
+	with tempfile.TemporaryDirectory() as tmp:
+		native = os.path.join(tmp, "native")
+		os.mkdir(native)
+
+		filenames = []
+		for i in range(args.files):
+			filename = os.path.join(tmp, f"{i:04d}.cbor")
+			with open(filename, "wb") as f:
+				recording(f, args.readings, rng)
+			filenames.append(filename)
+
+		size = sum(os.path.getsize(filename) for filename in filenames)
+		print(f"{args.files} recordings, {args.readings} readings each, {size} bytes")
+
+		python = run("decode.py", [sys.executable, os.path.join(BASE, "decode.py")] + filenames)
+		csv = run(f"hx711-convert -f csv -j {args.jobs}", [os.path.join(BASE, "hx711-convert"),
+			"-f", "csv", "-j", str(args.jobs), "-o", native] + filenames)
+		col = run(f"hx711-convert -f col -j {args.jobs}", [os.path.join(BASE, "hx711-convert"),
+			"-f", "col", "-j", str(args.jobs), "-o", native] + filenames)
+
+		for filename in filenames:
+			name = os.path.basename(filename)[:-4] + "csv"
+			if not filecmp.cmp(filename[:-4] + "csv", os.path.join(native, name), shallow=False):
+				print(f"{name}: CSV output differs", file=sys.stderr)
+				sys.exit(1)
+
+		print(f"CSV output identical, {python / csv:.1f}x faster (CSV), {python / col:.1f}x faster (columnar)")
@@ -0,0 +1,96 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+/*
+ * Minimal CBOR writer for the host tools that generate recordings.
+ *
+ * It provides the methods of cbor::Writer that recording::write_readings()
+ * needs, so readings are written the same way as the firmware.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace scales {
+
+class CBORWriter {
+public:
+	explicit CBORWriter(FILE *f) : f_(f) {}
+
+	void head(uint8_t major, uint64_t value) {
+		uint8_t data[9];
+		size_t length;
+
+		if (value < 24) {
+			data[0] = major << 5 | value;
+			length = 1;
+		} else {
+			unsigned int bytes = value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFFFF ? 4 : 8;
+
+			data[0] = major << 5 | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27);
+			for (unsigned int i = 0; i < bytes; i++)
+				data[1 + i] = value >> ((bytes - 1 - i) * 8);
+			length = 1 + bytes;
+		}
+
+		std::fwrite(data, 1, length, f_);
+	}
+
+	void write_uint(uint64_t value) { head(0, value); }
+
+	void write_int(int64_t value) {
+		if (value >= 0) {
+			head(0, value);
+		} else {
+			head(1, -1 - value);
+		}
+	}
+
+	void write_float(float value) {
+		uint32_t bits;
+
+		std::memcpy(&bits, &value, sizeof(bits));
+		write_byte(0xFA);
+		for (unsigned int i = 0; i < 4; i++)
+			write_byte(bits >> ((3 - i) * 8));
+	}
+
+	void write_text(const char *text) {
+		size_t length = std::strlen(text);
+
+		head(3, length);
+		std::fwrite(text, 1, length, f_);
+	}
+
+	void write_byte(uint8_t value) { std::fputc(value, f_); }
+
+	/* For recording::write_readings() */
+	void beginArray(size_t length) { head(4, length); }
+	void writeUnsignedInt(uint32_t value) { write_uint(value); }
+	void writeInt(int32_t value) { write_int(value); }
+
+private:
+	FILE *f_;
+};
+
+} // namespace scales
@@ -0,0 +1,80 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Columnar binary output format of hx711-convert.
+ *
+ * All values are little-endian. The file starts with a FileHeader,
+ * followed by blocks of readings. Each block starts with a BlockHeader
+ * and is followed by the columns for that block:
+ *
+ *   uint64_t time_us[rows]
+ *   int32_t value[rows]
+ *   uint8_t flags[rows]
+ *
+ * and then padded with zeros to a multiple of 8 bytes. A block with
+ * zero rows marks the end of the file.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scales {
+
+namespace columnar {
+
+constexpr char MAGIC[8] = {'H', 'X', '7', '1', '1', 'C', 'O', 'L'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t MAX_BLOCK_ROWS = 65536;
+
+enum Flags : uint8_t {
+	TARE = 1U << 0,
+	APPLIED = 1U << 1,
+	REMOVED = 1U << 2,
+	SETTLED = 1U << 3,
+	ZERO = 1U << 4,
+};
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t realtime_s;
+	uint32_t realtime_us;
+	uint32_t reserved2;
+	uint64_t start_us;
+	uint64_t stop_us;
+};
+
+struct BlockHeader {
+	uint32_t rows;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 48);
+static_assert(sizeof(BlockHeader) == 8);
+
+constexpr inline size_t block_size(uint32_t rows) {
+	return (rows * (sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint8_t)) + 7) & ~(size_t)7;
+}
+
+} // namespace columnar
+
+} // namespace scales
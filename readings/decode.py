@@ -21,11 +21,14 @@ import sys
 
 
 def decode(f):
-	data = cbor2.load(f)
-	assert data["readings_format"] == ['[flags:text]', '<offset_time_us:uint>', '<offset_value:int>'], data["readings_format"]
+	data = dict(cbor2.load(f))
+	legacy = list(data["readings_format"]) == ['[flags:text]', '<offset_time_us:uint>', '<offset_value:int>']
+	assert legacy or list(data["readings_format"]) == ['[flags:text]', '[tare_value:[int]]', '<offset_time_us:uint>', '<offset_value:int>'], data["readings_format"]
 
 	now_us = 0
 	value = 0
+	tare = 0
+	tare_value = None
 	flags = set()
 
 	readings = []
@@ -34,6 +37,9 @@ def decode(f):
 	for reading in data["readings"]:
 		if isinstance(reading, str):
 			flags.add(reading)
+		elif isinstance(reading, (list, tuple)):
+			assert not legacy and len(reading) == 1, reading
+			tare_value = reading[0]
 		elif offset_time_us is None:
 			offset_time_us = reading
 		else:
@@ -43,20 +49,34 @@ def decode(f):
 			now_us += offset_time_us
 			value += offset_value
 
-			readings.append({"time_us": now_us, "value": value, "flags": flags.copy()})
+			if tare_value is not None:
+				tare = tare_value
+			elif legacy and "tare" in flags:
+				tare = value
+
+			readings.append({"time_us": now_us, "value": value, "tare": tare, "flags": flags.copy()})
 
 			offset_time_us = None
+			tare_value = None
 			flags.clear()
 
 	data["readings"] = readings
 	return data
 
 
+def event_name(flags):
+	for name in ("applied", "removed", "settled", "zero"):
+		if name in flags:
+			return name
+	return ""
+
+
 def encode_csv(data, f):
 	writer = csv.writer(f, dialect="unix", quoting=csv.QUOTE_MINIMAL)
-	writer.writerow(["Time (us)", "Value", "Tare"])
+	writer.writerow(["Time (us)", "Value", "Tare", "Event", "Net"])
 	for reading in data["readings"]:
-		writer.writerow([reading["time_us"], reading["value"], 1 if "tare" in reading["flags"] else 0])
+		writer.writerow([reading["time_us"], reading["value"], 1 if "tare" in reading["flags"] else 0,
+			event_name(reading["flags"]), reading["value"] - reading["tare"]])
 
 
 if __name__ == "__main__":
@@ -0,0 +1,392 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "decoder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "scales/recording.h"
+#include "columnar.h"
+
+namespace scales {
+
+namespace {
+
+/* Minimal streaming CBOR decoder for the subset used by recordings */
+class CBORReader {
+public:
+	enum Major : uint8_t {
+		UINT = 0,
+		NEGINT = 1,
+		BYTES = 2,
+		TEXT = 3,
+		ARRAY = 4,
+		MAP = 5,
+		TAG = 6,
+		SIMPLE = 7,
+	};
+
+	static constexpr uint64_t INDEFINITE = UINT64_MAX;
+
+	struct Head {
+		Major major;
+		uint64_t value;
+	};
+
+	explicit CBORReader(FILE *f) : f_(f) {}
+
+	Head read_head() {
+		uint8_t initial = read_byte();
+		Head head{static_cast<Major>(initial >> 5), 0};
+		uint8_t info = initial & 0x1F;
+
+		if (info < 24) {
+			head.value = info;
+		} else if (info <= 27) {
+			unsigned int length = 1U << (info - 24);
+
+			for (unsigned int i = 0; i < length; i++)
+				head.value = (head.value << 8) | read_byte();
+		} else if (info == 31 && head.major != UINT && head.major != NEGINT
+				&& head.major != TAG) {
+			head.value = INDEFINITE;
+		} else {
+			throw DecodeError("invalid CBOR item");
+		}
+
+		return head;
+	}
+
+	/* Returns true if the next item is the break marker (and consumes it) */
+	bool read_break() {
+		if (peek_byte() == 0xFF) {
+			read_byte();
+			return true;
+		}
+		return false;
+	}
+
+	Head read_untagged() {
+		Head head = read_head();
+
+		while (head.major == TAG)
+			head = read_head();
+
+		return head;
+	}
+
+	uint64_t read_uint() {
+		Head head = read_untagged();
+
+		if (head.major != UINT)
+			throw DecodeError("expected unsigned integer");
+
+		return head.value;
+	}
+
+	std::string_view read_text(const Head &head) {
+		if (head.major != TEXT || head.value == INDEFINITE)
+			throw DecodeError("expected text string");
+
+		if (head.value > sizeof(text_))
+			throw DecodeError("text string too long");
+
+		read(text_, head.value);
+		return {text_, static_cast<size_t>(head.value)};
+	}
+
+	std::string_view read_text() {
+		return read_text(read_untagged());
+	}
+
+	void skip(const Head &head) {
+		switch (head.major) {
+		case UINT:
+		case NEGINT:
+		case SIMPLE:
+			break;
+
+		case BYTES:
+		case TEXT:
+			if (head.value == INDEFINITE) {
+				while (!read_break())
+					skip(read_head());
+			} else {
+				for (uint64_t i = 0; i < head.value; i++)
+					read_byte();
+			}
+			break;
+
+		case ARRAY:
+		case MAP:
+			if (head.value == INDEFINITE) {
+				while (!read_break())
+					skip(read_head());
+			} else {
+				uint64_t items = head.major == MAP ? head.value * 2 : head.value;
+
+				for (uint64_t i = 0; i < items; i++)
+					skip(read_head());
+			}
+			break;
+
+		case TAG:
+			skip(read_head());
+			break;
+		}
+	}
+
+private:
+	uint8_t read_byte() {
+		uint8_t value = peek_byte();
+		pos_++;
+		return value;
+	}
+
+	uint8_t peek_byte() {
+		if (pos_ == len_) {
+			len_ = fread(buffer_, 1, sizeof(buffer_), f_);
+			pos_ = 0;
+
+			if (len_ == 0)
+				throw DecodeError(ferror(f_) ? std::strerror(errno) : "unexpected end of file");
+		}
+
+		return buffer_[pos_];
+	}
+
+	void read(char *data, size_t length) {
+		for (size_t i = 0; i < length; i++)
+			data[i] = read_byte();
+	}
+
+	FILE *f_;
+	uint8_t buffer_[65536];
+	size_t pos_{0};
+	size_t len_{0};
+	char text_[256];
+};
+
+} // namespace
+
+static int64_t read_int(const CBORReader::Head &head) {
+	if (head.major == CBORReader::UINT) {
+		if (head.value > INT64_MAX)
+			throw DecodeError("integer out of range");
+		return head.value;
+	} else if (head.major == CBORReader::NEGINT) {
+		if (head.value > INT64_MAX)
+			throw DecodeError("integer out of range");
+		return -1 - static_cast<int64_t>(head.value);
+	} else {
+		throw DecodeError("expected integer");
+	}
+}
+
+static void decode_readings(CBORReader &reader, RecordingOutput &output, bool legacy) {
+	auto array = reader.read_untagged();
+
+	if (array.major != CBORReader::ARRAY)
+		throw DecodeError("readings is not an array");
+
+	uint64_t time_us = 0;
+	int64_t value = 0;
+	uint8_t flags = 0;
+	bool have_tare_value = false;
+	int64_t tare_value = 0;
+	bool have_offset_time = false;
+	uint64_t offset_time_us = 0;
+
+	for (uint64_t i = 0; array.value == CBORReader::INDEFINITE
+			? !reader.read_break() : i < array.value; i++) {
+		auto item = reader.read_untagged();
+
+		if (item.major == CBORReader::TEXT) {
+			auto flag = reader.read_text(item);
+
+			if (flag == recording::FLAG_TARE) {
+				flags |= columnar::TARE;
+			} else if (flag == recording::FLAG_APPLIED) {
+				flags |= columnar::APPLIED;
+			} else if (flag == recording::FLAG_REMOVED) {
+				flags |= columnar::REMOVED;
+			} else if (flag == recording::FLAG_SETTLED) {
+				flags |= columnar::SETTLED;
+			} else if (flag == recording::FLAG_ZERO) {
+				flags |= columnar::ZERO;
+			}
+		} else if (item.major == CBORReader::ARRAY) {
+			if (legacy || item.value != 1)
+				throw DecodeError("invalid tare value");
+
+			tare_value = read_int(reader.read_untagged());
+			have_tare_value = true;
+		} else if (!have_offset_time) {
+			if (item.major != CBORReader::UINT)
+				throw DecodeError("negative time offset");
+
+			offset_time_us = item.value;
+			have_offset_time = true;
+		} else {
+			time_us += offset_time_us;
+			value += read_int(item);
+
+			if (have_tare_value) {
+				output.tare(tare_value);
+			} else if (legacy && (flags & columnar::TARE)) {
+				output.tare(value);
+			}
+
+			output.reading(time_us, value, flags);
+
+			have_offset_time = false;
+			have_tare_value = false;
+			flags = 0;
+		}
+	}
+}
+
+void WallClock::add(uint64_t realtime_us, uint64_t time_us) {
+	auto it = std::lower_bound(anchors_.begin(), anchors_.end(), time_us,
+		[] (const Anchor &anchor, uint64_t time_us) { return anchor.time_us < time_us; });
+
+	if (it != anchors_.end() && it->time_us == time_us)
+		return;
+
+	anchors_.insert(it, {realtime_us, time_us});
+	index_ = 0;
+}
+
+void WallClock::clear() {
+	anchors_.clear();
+	index_ = 0;
+}
+
+uint64_t WallClock::realtime_us(uint64_t time_us) {
+	if (anchors_.empty())
+		return time_us;
+
+	if (anchors_.size() == 1)
+		return anchors_[0].realtime_us + (int64_t)(time_us - anchors_[0].time_us);
+
+	while (index_ + 2 < anchors_.size() && time_us >= anchors_[index_ + 1].time_us)
+		index_++;
+
+	while (index_ > 0 && time_us < anchors_[index_].time_us)
+		index_--;
+
+	const Anchor &a = anchors_[index_];
+	const Anchor &b = anchors_[index_ + 1];
+	double slope = (double)(int64_t)(b.realtime_us - a.realtime_us) / (b.time_us - a.time_us);
+
+	return a.realtime_us + std::llround((double)(int64_t)(time_us - a.time_us) * slope);
+}
+
+void decode_recording(FILE *f, RecordingOutput &output) {
+	CBORReader reader{f};
+	auto map = reader.read_untagged();
+	uint64_t realtime_s = 0;
+	uint32_t realtime_us = 0;
+	uint64_t start_us = 0;
+	uint64_t stop_us = 0;
+	bool format_ok = false;
+	bool legacy = false;
+
+	if (map.major != CBORReader::MAP)
+		throw DecodeError("recording is not a map");
+
+	for (uint64_t i = 0; map.value == CBORReader::INDEFINITE
+			? !reader.read_break() : i < map.value; i++) {
+		std::string key{reader.read_text()};
+
+		if (key == recording::KEY_REALTIME_S_US) {
+			auto array = reader.read_untagged();
+
+			if (array.major != CBORReader::ARRAY || array.value != 2)
+				throw DecodeError("invalid realtime");
+
+			realtime_s = reader.read_uint();
+			realtime_us = reader.read_uint();
+
+			output.anchor(realtime_s * 1000000 + realtime_us, 0);
+		} else if (key == recording::KEY_ANCHORS) {
+			auto anchors = reader.read_untagged();
+
+			if (anchors.major != CBORReader::ARRAY)
+				throw DecodeError("anchors is not an array");
+
+			for (uint64_t j = 0; anchors.value == CBORReader::INDEFINITE
+					? !reader.read_break() : j < anchors.value; j++) {
+				auto anchor = reader.read_untagged();
+
+				if (anchor.major != CBORReader::ARRAY || anchor.value != 2)
+					throw DecodeError("invalid anchor");
+
+				uint64_t anchor_realtime_us = reader.read_uint();
+
+				output.anchor(anchor_realtime_us, reader.read_uint());
+			}
+		} else if (key == recording::KEY_START_US) {
+			start_us = reader.read_uint();
+		} else if (key == recording::KEY_STOP_US) {
+			stop_us = reader.read_uint();
+		} else if (key == recording::KEY_READINGS_FORMAT) {
+			auto array = reader.read_untagged();
+
+			if (array.major != CBORReader::ARRAY)
+				throw DecodeError("unsupported readings format");
+
+			if (array.value == recording::READINGS_FORMAT.size()) {
+				for (const char *format : recording::READINGS_FORMAT) {
+					if (reader.read_text() != format)
+						throw DecodeError("unsupported readings format");
+				}
+			} else if (array.value == recording::LEGACY_READINGS_FORMAT.size()) {
+				for (const char *format : recording::LEGACY_READINGS_FORMAT) {
+					if (reader.read_text() != format)
+						throw DecodeError("unsupported readings format");
+				}
+
+				legacy = true;
+			} else {
+				throw DecodeError("unsupported readings format");
+			}
+
+			format_ok = true;
+		} else if (key == recording::KEY_READINGS) {
+			if (!format_ok)
+				throw DecodeError("readings before readings format");
+
+			decode_readings(reader, output, legacy);
+		} else {
+			reader.skip(reader.read_head());
+		}
+	}
+
+	output.header(realtime_s, realtime_us, start_us, stop_us);
+	output.finish();
+}
+
+} // namespace scales
@@ -0,0 +1,85 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace scales {
+
+class DecodeError: public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/* Receives the contents of a recording as it is decoded (flags are columnar::Flags) */
+class RecordingOutput {
+public:
+	virtual ~RecordingOutput() = default;
+
+	virtual void header(uint64_t realtime_s, uint32_t realtime_us,
+		uint64_t start_us, uint64_t stop_us) = 0;
+	/*
+	 * Wall clock time in microseconds at a time in the recording. The start
+	 * time is the first anchor, and these are normally output before the
+	 * readings.
+	 */
+	virtual void anchor(uint64_t /* realtime_us */, uint64_t /* time_us */) {}
+	/*
+	 * New tare value, from the reading with the TARE or ZERO flag that is
+	 * output next. The tare value is 0 until then.
+	 */
+	virtual void tare(int64_t /* value */) {}
+	virtual void reading(uint64_t time_us, int64_t value, uint8_t flags) = 0;
+	virtual void finish() = 0;
+};
+
+/*
+ * Maps times in a recording to wall clock time by interpolating between
+ * anchors, so that drift between the device clock and the wall clock is
+ * corrected. Times outside the anchors are extrapolated from the nearest
+ * pair. Lookups are fastest when times are increasing.
+ */
+class WallClock {
+public:
+	void add(uint64_t realtime_us, uint64_t time_us);
+	inline bool empty() const { return anchors_.empty(); }
+	void clear();
+	uint64_t realtime_us(uint64_t time_us);
+
+private:
+	struct Anchor {
+		uint64_t realtime_us;
+		uint64_t time_us;
+	};
+
+	std::vector<Anchor> anchors_;
+	size_t index_{0};
+};
+
+/*
+ * Decode a recording from a file using a fixed amount of memory, throwing
+ * DecodeError if the file is not a valid recording. The header is output
+ * after all the readings.
+ */
+void decode_recording(FILE *f, RecordingOutput &output);
+
+} // namespace scales
@@ -0,0 +1,173 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Output a summary table of recordings (.cbor or .col) as CSV.
+ *
+ * Files are analysed in parallel, with each thread reusing its buffers.
+ *
+ * With -d, fail unless the drift of every file is within 10% of the
+ * expected drift (to check the analysis of simulated recordings).
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis.h"
+
+using namespace scales;
+
+namespace {
+
+struct Result {
+	bool ok{false};
+	std::string error;
+	analysis::Summary summary;
+};
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-j jobs] [-w window] [-s step threshold] [-f settle factor] [-d expected drift/h] [-t] <file>...\n", name);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	analysis::Parameters parameters;
+	unsigned int jobs = 0;
+	bool timing = false;
+	double expected_drift = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:w:s:f:d:th")) != -1) {
+		switch (opt) {
+		case 'j':
+			jobs = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'w':
+			parameters.window = std::max(1UL, std::strtoul(optarg, nullptr, 10));
+			break;
+
+		case 's':
+			parameters.step_threshold = std::strtod(optarg, nullptr);
+			break;
+
+		case 'f':
+			parameters.settle_factor = std::strtod(optarg, nullptr);
+			break;
+
+		case 'd':
+			expected_drift = std::strtod(optarg, nullptr);
+			break;
+
+		case 't':
+			timing = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<std::string> filenames{argv + optind, argv + argc};
+
+	if (filenames.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!jobs)
+		jobs = std::max(1U, std::thread::hardware_concurrency());
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<Result> results(filenames.size());
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> total_readings{0};
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 0; i < std::min<size_t>(jobs, filenames.size()); i++) {
+		threads.emplace_back([&] {
+			analysis::Samples samples;
+			analysis::Analyser analyser{parameters};
+			size_t index;
+
+			while ((index = next++) < filenames.size()) {
+				Result &result = results[index];
+
+				result.ok = analysis::load(filenames[index], samples, result.error);
+				if (result.ok) {
+					result.summary = analyser.analyse(samples);
+					total_readings += samples.size();
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	bool failed = false;
+
+	std::printf("File,Readings,Duration (s),Min,Max,Mean,Noise RMS,Drift (/h),"
+		"Steps,Max step,Mean settling (ms),Max settling (ms)\n");
+
+	for (size_t i = 0; i < filenames.size(); i++) {
+		const Result &result = results[i];
+		const analysis::Summary &summary = result.summary;
+
+		if (!result.ok) {
+			std::fprintf(stderr, "%s: %s\n", filenames[i].c_str(), result.error.c_str());
+			failed = true;
+			continue;
+		}
+
+		std::printf("%s,%zu,%.3f,%d,%d,%.1f,%.2f,%.1f,%zu,%.1f,%.1f,%.1f\n",
+			filenames[i].c_str(), summary.readings, summary.duration_s,
+			summary.min, summary.max, summary.mean, summary.noise_rms,
+			summary.drift_per_hour, summary.steps, summary.max_step,
+			summary.mean_settling_ms, summary.max_settling_ms);
+
+		if (expected_drift != 0 && std::abs(summary.drift_per_hour - expected_drift)
+				> std::abs(expected_drift) * 0.1) {
+			std::fprintf(stderr, "%s: drift %.1f/h, expected %.1f/h\n",
+				filenames[i].c_str(), summary.drift_per_hour, expected_drift);
+			failed = true;
+		}
+	}
+
+	if (timing) {
+		std::fprintf(stderr, "%zu files, %zu readings in %.3fs (%.1fM readings/s)\n",
+			filenames.size(), total_readings.load(), elapsed.count(),
+			total_readings / elapsed.count() / 1e6);
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Convert recordings to CSV or columnar binary format.
+ *
+ * Recordings are decoded as a stream so memory usage does not depend on
+ * the size of the recording, and multiple files are converted in parallel.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "columnar.h"
+#include "decoder.h"
+#include "scales/recording.h"
+
+using namespace scales;
+
+namespace {
+
+enum class Format {
+	CSV,
+	COLUMNAR,
+};
+
+class CSVOutput: public RecordingOutput {
+public:
+	CSVOutput(FILE *f, bool realtime) : f_(f), realtime_(realtime) {
+		std::fputs(realtime_ ? "Time (us),Value,Tare,Event,Net,Realtime (us)\n"
+			: "Time (us),Value,Tare,Event,Net\n", f_);
+	}
+
+	void header(uint64_t, uint32_t, uint64_t, uint64_t) override {}
+
+	void anchor(uint64_t realtime_us, uint64_t time_us) override {
+		wall_clock_.add(realtime_us, time_us);
+	}
+
+	void tare(int64_t value) override {
+		tare_ = value;
+	}
+
+	void reading(uint64_t time_us, int64_t value, uint8_t flags) override {
+		if (realtime_) {
+			if (wall_clock_.empty())
+				throw DecodeError("readings before wall clock time");
+
+			std::fprintf(f_, "%" PRIu64 ",%" PRId64 ",%u,%s,%" PRId64 ",%" PRIu64 "\n",
+				time_us, value, (flags & columnar::TARE) ? 1U : 0U, event_name(flags),
+				value - tare_, wall_clock_.realtime_us(time_us));
+		} else {
+			std::fprintf(f_, "%" PRIu64 ",%" PRId64 ",%u,%s,%" PRId64 "\n",
+				time_us, value, (flags & columnar::TARE) ? 1U : 0U, event_name(flags),
+				value - tare_);
+		}
+	}
+
+	void finish() override {}
+
+private:
+	static const char *event_name(uint8_t flags) {
+		if (flags & columnar::APPLIED)
+			return recording::FLAG_APPLIED;
+		if (flags & columnar::REMOVED)
+			return recording::FLAG_REMOVED;
+		if (flags & columnar::SETTLED)
+			return recording::FLAG_SETTLED;
+		if (flags & columnar::ZERO)
+			return recording::FLAG_ZERO;
+		return "";
+	}
+
+	FILE *f_;
+	const bool realtime_;
+	WallClock wall_clock_;
+	int64_t tare_{0};
+};
+
+class ColumnarOutput: public RecordingOutput {
+public:
+	explicit ColumnarOutput(FILE *f) : f_(f) {
+		std::memcpy(header_.magic, columnar::MAGIC, sizeof(header_.magic));
+		header_.version = columnar::VERSION;
+		write(&header_, sizeof(header_));
+	}
+
+	void header(uint64_t realtime_s, uint32_t realtime_us,
+			uint64_t start_us, uint64_t stop_us) override {
+		header_.realtime_s = realtime_s;
+		header_.realtime_us = realtime_us;
+		header_.start_us = start_us;
+		header_.stop_us = stop_us;
+	}
+
+	void reading(uint64_t time_us, int64_t value, uint8_t flags) override {
+		time_us_[rows_] = time_us;
+		value_[rows_] = value;
+		flags_[rows_] = flags;
+
+		if (++rows_ == columnar::MAX_BLOCK_ROWS)
+			flush();
+	}
+
+	void finish() override {
+		static const columnar::BlockHeader end{};
+
+		flush();
+		write(&end, sizeof(end));
+
+		/* The header values are not known until the whole file is read */
+		if (std::fseek(f_, 0, SEEK_SET))
+			throw std::runtime_error(std::strerror(errno));
+
+		write(&header_, sizeof(header_));
+	}
+
+private:
+	void flush() {
+		static const uint8_t padding[8]{};
+
+		if (!rows_)
+			return;
+
+		columnar::BlockHeader block{rows_, 0};
+		size_t length = rows_ * (sizeof(time_us_[0]) + sizeof(value_[0]) + sizeof(flags_[0]));
+
+		write(&block, sizeof(block));
+		write(time_us_, rows_ * sizeof(time_us_[0]));
+		write(value_, rows_ * sizeof(value_[0]));
+		write(flags_, rows_ * sizeof(flags_[0]));
+		write(padding, columnar::block_size(rows_) - length);
+		rows_ = 0;
+	}
+
+	void write(const void *data, size_t length) {
+		if (std::fwrite(data, 1, length, f_) != length)
+			throw std::runtime_error(std::strerror(errno));
+	}
+
+	FILE *f_;
+	columnar::FileHeader header_{};
+	uint32_t rows_{0};
+	uint64_t time_us_[columnar::MAX_BLOCK_ROWS];
+	int32_t value_[columnar::MAX_BLOCK_ROWS];
+	uint8_t flags_[columnar::MAX_BLOCK_ROWS];
+};
+
+struct Options {
+	Format format{Format::CSV};
+	std::string output_dir;
+	unsigned int jobs{0};
+	bool realtime{false};
+};
+
+std::string output_filename(const Options &options, const std::string &filename) {
+	std::string name = filename.substr(0, filename.size() - 5);
+
+	if (!options.output_dir.empty()) {
+		auto pos = name.rfind('/');
+
+		if (pos != std::string::npos)
+			name = name.substr(pos + 1);
+
+		name = options.output_dir + "/" + name;
+	}
+
+	return name + (options.format == Format::CSV ? ".csv" : ".col");
+}
+
+bool convert(const Options &options, const std::string &filename, std::string &error) {
+	std::string out_filename = output_filename(options, filename);
+	std::unique_ptr<FILE, decltype(&std::fclose)> in{std::fopen(filename.c_str(), "rb"), &std::fclose};
+
+	if (!in) {
+		error = std::strerror(errno);
+		return false;
+	}
+
+	std::unique_ptr<FILE, decltype(&std::fclose)> out{std::fopen(out_filename.c_str(), "wb"), &std::fclose};
+
+	if (!out) {
+		error = out_filename + ": " + std::strerror(errno);
+		return false;
+	}
+
+	std::vector<char> out_buffer(1 << 20);
+	std::setvbuf(out.get(), out_buffer.data(), _IOFBF, out_buffer.size());
+
+	try {
+		std::unique_ptr<RecordingOutput> output;
+
+		if (options.format == Format::CSV) {
+			output = std::make_unique<CSVOutput>(out.get(), options.realtime);
+		} else {
+			output = std::make_unique<ColumnarOutput>(out.get());
+		}
+
+		decode_recording(in.get(), *output);
+
+		if (std::fflush(out.get()))
+			throw std::runtime_error(std::strerror(errno));
+	} catch (const std::exception &e) {
+		error = e.what();
+		out.reset();
+		std::remove(out_filename.c_str());
+		return false;
+	}
+
+	if (std::fclose(out.release())) {
+		error = out_filename + ": " + std::strerror(errno);
+		std::remove(out_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-f csv|col] [-j jobs] [-o output dir] [-w] <file.cbor>...\n", name);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	Options options;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:j:o:wh")) != -1) {
+		switch (opt) {
+		case 'f':
+			if (!std::strcmp(optarg, "csv")) {
+				options.format = Format::CSV;
+			} else if (!std::strcmp(optarg, "col")) {
+				options.format = Format::COLUMNAR;
+			} else {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'j':
+			options.jobs = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'o':
+			options.output_dir = optarg;
+			break;
+
+		case 'w':
+			options.realtime = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<std::string> filenames;
+
+	for (int i = optind; i < argc; i++) {
+		std::string_view filename{argv[i]};
+
+		if (filename.size() > 5 && filename.substr(filename.size() - 5) == ".cbor")
+			filenames.emplace_back(filename);
+	}
+
+	if (filenames.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!options.jobs)
+		options.jobs = std::max(1U, std::thread::hardware_concurrency());
+
+	std::atomic<size_t> next{0};
+	std::atomic<bool> failed{false};
+	std::mutex stderr_mutex;
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 0; i < std::min<size_t>(options.jobs, filenames.size()); i++) {
+		threads.emplace_back([&] {
+			size_t index;
+
+			while ((index = next++) < filenames.size()) {
+				std::string error;
+
+				if (!convert(options, filenames[index], error)) {
+					std::lock_guard lock{stderr_mutex};
+
+					std::fprintf(stderr, "%s: %s\n", filenames[index].c_str(), error.c_str());
+					failed = true;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
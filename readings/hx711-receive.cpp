@@ -0,0 +1,401 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Capture the live readings that a device sends as telemetry and reassemble
+ * them into a recording, reporting any packet loss.
+ *
+ * Readings in lost packets are missing from the recording, with the time
+ * offset of the next reading covering the gap. Packets that arrive late
+ * are discarded.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "cbor_writer.h"
+#include "scales/recording.h"
+#include "scales/telemetry.h"
+
+using namespace scales;
+
+namespace {
+
+/* Record the wall clock time this often, the same as the firmware */
+constexpr uint64_t ANCHOR_INTERVAL_US = 60 * 1000000ULL;
+constexpr int RECEIVE_BUFFER_BYTES = 1024 * 1024;
+
+volatile sig_atomic_t stop = 0;
+
+struct Anchor {
+	uint64_t realtime_us;
+	uint64_t offset_us;
+};
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-p port] [-g group] [-D device] [-d duration s] [-n readings] <file.cbor>\n", name);
+}
+
+void handle_signal(int) {
+	stop = 1;
+}
+
+bool parse_device(const char *text, std::array<uint8_t,6> &device) {
+	unsigned int values[6];
+	char end;
+
+	if (std::sscanf(text, "%x:%x:%x:%x:%x:%x%c", &values[0], &values[1], &values[2],
+			&values[3], &values[4], &values[5], &end) != 6)
+		return false;
+
+	for (size_t i = 0; i < device.size(); i++) {
+		if (values[i] > 0xFF)
+			return false;
+		device[i] = values[i];
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	unsigned long port = telemetry::DEFAULT_PORT;
+	const char *group = nullptr;
+	std::array<uint8_t,6> device{};
+	bool device_set = false;
+	double duration_s = 0;
+	unsigned long max_readings = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:g:D:d:n:h")) != -1) {
+		switch (opt) {
+		case 'p':
+			port = std::strtoul(optarg, nullptr, 10);
+			if (port == 0 || port > UINT16_MAX) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'g':
+			group = optarg;
+			break;
+
+		case 'D':
+			if (!parse_device(optarg, device)) {
+				std::fprintf(stderr, "Invalid device: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			device_set = true;
+			break;
+
+		case 'd':
+			duration_s = std::strtod(optarg, nullptr);
+			break;
+
+		case 'n':
+			max_readings = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int fd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (fd < 0) {
+		std::perror("socket");
+		return EXIT_FAILURE;
+	}
+
+	/* Allow several listeners on the same host for multicast */
+	int reuse = 1;
+	int rcvbuf = RECEIVE_BUFFER_BYTES;
+	struct timeval timeout{1, 0};
+
+	::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	sockaddr_in address{};
+
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+
+	if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+		std::perror("bind");
+		return EXIT_FAILURE;
+	}
+
+	if (group) {
+		ip_mreq membership{};
+
+		if (!::inet_aton(group, &membership.imr_multiaddr)) {
+			std::fprintf(stderr, "Invalid group: %s\n", group);
+			return EXIT_FAILURE;
+		}
+
+		membership.imr_interface.s_addr = htonl(INADDR_ANY);
+
+		if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+			std::perror("IP_ADD_MEMBERSHIP");
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::unique_ptr<FILE, decltype(&std::fclose)> f{std::fopen(argv[optind], "wb"), &std::fclose};
+
+	if (!f) {
+		std::perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	struct sigaction action{};
+
+	action.sa_handler = handle_signal;
+	::sigaction(SIGINT, &action, nullptr);
+	::sigaction(SIGTERM, &action, nullptr);
+
+	/* The header is written after the readings so the stop time is known */
+	std::unique_ptr<FILE, decltype(&std::fclose)> tmp{std::tmpfile(), &std::fclose};
+	CBORWriter readings_writer{tmp.get()};
+	auto write_text = [] (CBORWriter &writer, const char *text) { writer.write_text(text); };
+	std::array<uint8_t,telemetry::MAX_PACKET_SIZE + 1> buffer;
+	std::array<Data,telemetry::MAX_ENTRIES> entries;
+	telemetry::Header header;
+	std::chrono::steady_clock::time_point start;
+	std::vector<Anchor> anchors;
+	recording::Statistics statistics;
+	bool started = false;
+	uint64_t start_us = 0;
+	uint64_t realtime_us = 0;
+	uint64_t previous_us = 0;
+	uint64_t anchor_us = 0;
+	uint32_t period_ns = 0;
+	int32_t previous_value = 0;
+	int32_t tare_value = 0;
+	uint32_t next_sequence = 0;
+	uint32_t next_index = 0;
+	unsigned long packets = 0;
+	unsigned long lost_packets = 0;
+	unsigned long late_packets = 0;
+	unsigned long invalid_packets = 0;
+	unsigned long other_packets = 0;
+	unsigned long readings = 0;
+	unsigned long lost_readings = 0;
+
+	while (!stop) {
+		if (started && duration_s > 0) {
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			if (elapsed.count() >= duration_s)
+				break;
+		}
+
+		ssize_t length = ::recv(fd, buffer.data(), buffer.size(), 0);
+
+		if (length < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				continue;
+
+			std::perror("recv");
+			break;
+		}
+
+		if (!telemetry::decode(buffer.data(), length, header, entries)) {
+			invalid_packets++;
+			continue;
+		}
+
+		if (!device_set) {
+			device = header.device;
+			device_set = true;
+		} else if (header.device != device) {
+			other_packets++;
+			continue;
+		}
+
+		if (!started) {
+			std::fprintf(stderr, "Receiving from %02x:%02x:%02x:%02x:%02x:%02x\n",
+				device[0], device[1], device[2], device[3], device[4], device[5]);
+			start = std::chrono::steady_clock::now();
+			start_us = header.time_us;
+			realtime_us = header.realtime_us;
+			previous_us = header.time_us;
+			next_sequence = header.sequence;
+			next_index = header.index;
+			anchors.push_back({header.realtime_us, 0});
+			anchor_us = header.time_us;
+			started = true;
+		}
+
+		int32_t sequence_gap = header.sequence - next_sequence;
+		int32_t index_gap = header.index - next_index;
+
+		if (sequence_gap < 0 || index_gap < 0) {
+			late_packets++;
+			continue;
+		}
+
+		packets++;
+		lost_packets += sequence_gap;
+		lost_readings += index_gap;
+		next_sequence = header.sequence + 1;
+		next_index = header.index + header.count;
+		period_ns = header.period_ns;
+
+		if (header.time_us >= anchor_us + ANCHOR_INTERVAL_US) {
+			anchors.push_back({header.realtime_us, header.time_us - start_us});
+			anchor_us = header.time_us;
+		}
+
+		/* The tare value may have changed in a lost packet */
+		if (header.tare_value != tare_value) {
+			Data data = recording::make_tare_data(Type::READING, header.tare_value);
+
+			recording::write_readings(readings_writer, write_text, &data, 1, previous_value);
+			tare_value = header.tare_value;
+		}
+
+		uint64_t time_us = header.time_us;
+
+		for (size_t i = 0; i < header.count; i++) {
+			Data &data = entries[i];
+
+			time_us += data.offset_us;
+
+			if (data.type & Type::TARE_VALUE) {
+				tare_value = recording::sign_extend(data.value);
+
+				if (data.type & Type::TARE)
+					statistics.tares++;
+			} else {
+				/* Relative to the previous reading that was received */
+				data.offset_us = recording::make_data(time_us, previous_us, 0, 0).offset_us;
+				previous_us = time_us;
+				statistics.add(recording::sign_extend(data.value));
+				readings++;
+			}
+		}
+
+		previous_value = recording::write_readings(readings_writer, write_text,
+			entries.data(), header.count, previous_value);
+
+		if (max_readings && readings >= max_readings)
+			break;
+	}
+
+	::close(fd);
+
+	CBORWriter writer{f.get()};
+
+	writer.write_byte(0xD9);
+	writer.write_byte(0xD9);
+	writer.write_byte(0xF7);
+	writer.head(5, 8);
+
+	writer.write_text(recording::KEY_REALTIME_S_US);
+	writer.head(4, 2);
+	writer.write_uint(realtime_us / 1000000ULL);
+	writer.write_uint(realtime_us % 1000000ULL);
+
+	writer.write_text(recording::KEY_START_US);
+	writer.write_uint(start_us);
+
+	writer.write_text(recording::KEY_STOP_US);
+	writer.write_uint(previous_us);
+
+	writer.write_text(recording::KEY_PERIOD_NS);
+	writer.write_uint(period_ns);
+
+	writer.write_text(recording::KEY_READINGS_FORMAT);
+	writer.head(4, recording::READINGS_FORMAT.size());
+	for (const char *format : recording::READINGS_FORMAT)
+		writer.write_text(format);
+
+	writer.write_text(recording::KEY_STATISTICS);
+	writer.head(5, 6);
+	writer.write_text(recording::KEY_STATISTICS_COUNT);
+	writer.write_uint(statistics.count);
+	writer.write_text(recording::KEY_STATISTICS_TARES);
+	writer.write_uint(statistics.tares);
+	writer.write_text(recording::KEY_STATISTICS_MIN);
+	writer.write_int(statistics.min);
+	writer.write_text(recording::KEY_STATISTICS_MAX);
+	writer.write_int(statistics.max);
+	writer.write_text(recording::KEY_STATISTICS_MEAN);
+	writer.write_float(statistics.mean);
+	writer.write_text(recording::KEY_STATISTICS_STDDEV);
+	writer.write_float(statistics.stddev());
+
+	writer.write_text(recording::KEY_ANCHORS);
+	writer.head(4, anchors.size());
+	for (const auto &anchor : anchors) {
+		writer.head(4, 2);
+		writer.write_uint(anchor.realtime_us);
+		writer.write_uint(anchor.offset_us);
+	}
+
+	writer.write_text(recording::KEY_READINGS);
+	writer.write_byte(0x9F);
+
+	std::rewind(tmp.get());
+	char copy[65536];
+	size_t copy_length;
+
+	while ((copy_length = std::fread(copy, 1, sizeof(copy), tmp.get())) > 0)
+		std::fwrite(copy, 1, copy_length, f.get());
+
+	writer.write_byte(0xFF);
+
+	if (std::ferror(f.get()) || std::fclose(f.release())) {
+		std::perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	unsigned long expected = packets + lost_packets;
+
+	std::fprintf(stderr, "%lu packets (%lu lost, %.2f%%; %lu late, %lu invalid, %lu from other devices)\n",
+		packets, lost_packets, expected ? lost_packets * 100.0 / expected : 0.0,
+		late_packets, invalid_packets, other_packets);
+	std::fprintf(stderr, "%lu readings (%lu lost)\n", readings, lost_readings);
+
+	return EXIT_SUCCESS;
+}
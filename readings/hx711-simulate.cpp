@@ -0,0 +1,449 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Generate a recording from the virtual HX711 in virtual time.
+ *
+ * Readings are clocked out of the emulator using the same serial protocol
+ * as the firmware so this also measures the acquisition overhead.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cbor_writer.h"
+#include "scales/compressor.h"
+#include "scales/recording.h"
+#include "scales/sample_clock.h"
+#include "scales/step_detector.h"
+#include "scales/telemetry.h"
+#include "scales/virtual_hx711.h"
+
+using namespace scales;
+
+namespace {
+
+/*
+ * Send the readings as telemetry packets in the same way as the firmware,
+ * optionally dropping some of them to test the receiver.
+ */
+class TelemetryStream {
+public:
+	/* Readings per packet, the firmware sends them every 100ms */
+	static constexpr size_t BATCH_READINGS = 8;
+	/* Avoid overrunning the receive buffer of the listener */
+	static constexpr useconds_t PACKET_INTERVAL_US = 200;
+
+	TelemetryStream(int fd, const sockaddr_in &destination, double loss, uint32_t seed)
+			: fd_(fd), destination_(destination), loss_(loss), random_(seed) {
+		header_.device = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+		realtime_us_ = (uint64_t)std::time(nullptr) * 1000000ULL;
+	}
+
+	void add(uint64_t time_us, uint8_t flags, int32_t value, uint32_t period_ns) {
+		if (index_ == 0)
+			start_us_ = previous_us_ = time_us;
+
+		if (count_ == 0) {
+			header_.time_us = previous_us_;
+			header_.realtime_us = realtime_us_ + (previous_us_ - start_us_);
+			header_.index = index_;
+		}
+
+		entries_[count_++] = recording::make_data(time_us, previous_us_, flags, value);
+		previous_us_ = time_us;
+		index_++;
+		header_.period_ns = period_ns;
+
+		if (count_ == BATCH_READINGS)
+			flush();
+	}
+
+	void flush() {
+		if (count_ == 0)
+			return;
+
+		std::array<uint8_t,telemetry::MAX_PACKET_SIZE> buffer;
+
+		header_.count = count_;
+
+		size_t length = telemetry::encode(header_, entries_.data(), buffer.data());
+
+		header_.sequence++;
+		count_ = 0;
+
+		if (std::uniform_real_distribution<double>{0, 100}(random_) < loss_) {
+			dropped_++;
+			return;
+		}
+
+		if (::sendto(fd_, buffer.data(), length, 0,
+				reinterpret_cast<const sockaddr*>(&destination_), sizeof(destination_)) < 0) {
+			std::perror("sendto");
+		} else {
+			sent_++;
+		}
+
+		::usleep(PACKET_INTERVAL_US);
+	}
+
+	inline unsigned long sent() const { return sent_; }
+	inline unsigned long dropped() const { return dropped_; }
+
+private:
+	int fd_;
+	sockaddr_in destination_;
+	double loss_;
+	std::mt19937 random_;
+	telemetry::Header header_;
+	std::array<Data,telemetry::MAX_ENTRIES> entries_;
+	size_t count_{0};
+	uint32_t index_{0};
+	uint64_t start_us_{0};
+	uint64_t previous_us_{0};
+	uint64_t realtime_us_{0};
+	unsigned long sent_{0};
+	unsigned long dropped_{0};
+};
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-r rate] [-n noise] [-v Hz:amplitude] [-d duration s] [-p profile] [-s seed]\n"
+		"\t[-c mode:tolerance] [-u address[:port] [-l loss %%]] <file.cbor>\n", name);
+}
+
+bool parse_destination(const char *text, sockaddr_in &destination) {
+	std::string host = text;
+	size_t colon = host.find(':');
+
+	destination = {};
+	destination.sin_family = AF_INET;
+	destination.sin_port = htons(telemetry::DEFAULT_PORT);
+
+	if (colon != std::string::npos) {
+		unsigned long port = std::strtoul(host.c_str() + colon + 1, nullptr, 10);
+
+		if (port == 0 || port > UINT16_MAX)
+			return false;
+
+		destination.sin_port = htons(port);
+		host.resize(colon);
+	}
+
+	return ::inet_aton(host.c_str(), &destination.sin_addr) != 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	unsigned int rate_hz = VirtualHX711::DEFAULT_RATE_HZ;
+	float noise = 0;
+	float vibration_hz = 0;
+	float vibration_amplitude = 0;
+	double duration_s = 900;
+	const char *profile = "";
+	uint32_t seed = 1;
+	const char *destination = nullptr;
+	double loss = 0;
+	Compressor::Parameters compression;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:n:v:d:p:s:c:u:l:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			rate_hz = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'n':
+			noise = std::strtof(optarg, nullptr);
+			break;
+
+		case 'v': {
+				char *end;
+
+				vibration_hz = std::strtof(optarg, &end);
+				if (*end != ':') {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				vibration_amplitude = std::strtof(end + 1, nullptr);
+			}
+			break;
+
+		case 'd':
+			duration_s = std::strtod(optarg, nullptr);
+			break;
+
+		case 'p':
+			profile = optarg;
+			break;
+
+		case 's':
+			seed = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'c': {
+				char *colon = std::strchr(optarg, ':');
+
+				if (colon)
+					*colon = '\0';
+
+				if (!Compressor::mode(optarg, compression.mode)) {
+					std::fprintf(stderr, "Invalid compression mode: %s\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				compression.tolerance = colon ? std::strtoul(colon + 1, nullptr, 10) : 0;
+			}
+			break;
+
+		case 'u':
+			destination = optarg;
+			break;
+
+		case 'l':
+			loss = std::strtod(optarg, nullptr);
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	VirtualHX711 hx711{VirtualHX711::Clock::VIRTUAL, rate_hz, noise, seed};
+
+	hx711.init();
+	hx711.sck(true);
+	hx711.delay_us(100);
+	hx711.sck(false);
+
+	if (!hx711.profile(profile)) {
+		std::fprintf(stderr, "Invalid profile: %s\n", profile);
+		return EXIT_FAILURE;
+	}
+
+	hx711.vibration(vibration_hz, vibration_amplitude);
+
+	std::unique_ptr<FILE, decltype(&std::fclose)> f{std::fopen(argv[optind], "wb"), &std::fclose};
+
+	if (!f) {
+		std::perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	std::unique_ptr<TelemetryStream> stream;
+	int fd = -1;
+
+	if (destination) {
+		sockaddr_in address;
+
+		if (!parse_destination(destination, address)) {
+			std::fprintf(stderr, "Invalid destination: %s\n", destination);
+			return EXIT_FAILURE;
+		}
+
+		fd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (fd < 0) {
+			std::perror("socket");
+			return EXIT_FAILURE;
+		}
+
+		stream = std::make_unique<TelemetryStream>(fd, address, loss, seed);
+	}
+
+	CBORWriter writer{f.get()};
+	auto start = std::chrono::steady_clock::now();
+	uint64_t start_us = hx711.now_us();
+	uint64_t stop_us = start_us + duration_s * 1e6;
+	uint64_t previous_us = start_us;
+	int32_t previous_value = 0;
+	SampleClock clock;
+	StepDetector detector;
+	recording::Statistics statistics;
+	Compressor compressor{compression};
+	unsigned long readings = 0;
+	unsigned long kept = 0;
+	unsigned long events = 0;
+	unsigned long invalid = 0;
+
+	/* The header is written after the readings so the stop time is known */
+	std::unique_ptr<FILE, decltype(&std::fclose)> tmp{std::tmpfile(), &std::fclose};
+	CBORWriter readings_writer{tmp.get()};
+
+	auto write_reading = [&] (uint64_t time_us, uint8_t flags, int32_t value) {
+		for (uint8_t flag = Type::APPLIED; flag <= Type::SETTLED; flag <<= 1) {
+			if (flags & flag) {
+				readings_writer.write_text(recording::flag_name(flag));
+				events++;
+			}
+		}
+
+		readings_writer.write_uint(recording::make_data(time_us, previous_us, flags, value).offset_us);
+		readings_writer.write_int((int64_t)value - previous_value);
+		previous_us = time_us;
+		previous_value = value;
+		kept++;
+	};
+
+	while (hx711.now_us() < stop_us) {
+		if (!hx711.ready())
+			continue;
+
+		uint64_t ready_us = hx711.ready_us();
+		uint32_t reading = hx711.read();
+
+		if ((reading & 1) != 1) {
+			invalid++;
+			continue;
+		}
+
+		int32_t value = recording::sign_extend(reading >> 1);
+		uint64_t time_us = clock.update(ready_us);
+		uint8_t flags = detector.update(time_us, value);
+
+		uint8_t keep = compressor.add(time_us, value, flags != 0);
+
+		if (keep & Compressor::Keep::PREVIOUS)
+			write_reading(compressor.previous().time_us, Type::READING, compressor.previous().value);
+
+		if (keep & Compressor::Keep::CURRENT)
+			write_reading(time_us, flags, value);
+
+		statistics.add(value);
+		readings++;
+
+		if (stream)
+			stream->add(time_us, flags, value, clock.period_ns());
+	}
+
+	Compressor::Point last;
+
+	if (compressor.flush(last))
+		write_reading(last.time_us, Type::READING, last.value);
+
+	if (stream) {
+		stream->flush();
+		::close(fd);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	writer.write_byte(0xD9);
+	writer.write_byte(0xD9);
+	writer.write_byte(0xF7);
+	bool compressed = compression.mode != Compressor::Mode::LOSSLESS;
+
+	writer.head(5, compressed ? 10 : 9);
+
+	writer.write_text(recording::KEY_REALTIME_S_US);
+	writer.head(4, 2);
+	writer.write_uint(std::time(nullptr));
+	writer.write_uint(0);
+
+	writer.write_text(recording::KEY_START_US);
+	writer.write_uint(start_us);
+
+	writer.write_text(recording::KEY_STOP_US);
+	writer.write_uint(hx711.now_us());
+
+	writer.write_text(recording::KEY_PERIOD_NS);
+	writer.write_uint(clock.period_ns());
+
+	writer.write_text(recording::KEY_JITTER_NS);
+	writer.write_uint(clock.jitter_ns());
+
+	writer.write_text(recording::KEY_RATE_HZ);
+	writer.write_uint(rate_hz);
+
+	if (compressed) {
+		writer.write_text(recording::KEY_COMPRESSION);
+		writer.head(5, 2);
+		writer.write_text(recording::KEY_COMPRESSION_MODE);
+		writer.write_text(Compressor::mode_name(compression.mode));
+		writer.write_text(recording::KEY_COMPRESSION_TOLERANCE);
+		writer.write_uint(compression.tolerance);
+	}
+
+	writer.write_text(recording::KEY_READINGS_FORMAT);
+	writer.head(4, recording::READINGS_FORMAT.size());
+	for (const char *format : recording::READINGS_FORMAT)
+		writer.write_text(format);
+
+	writer.write_text(recording::KEY_STATISTICS);
+	writer.head(5, 6);
+	writer.write_text(recording::KEY_STATISTICS_COUNT);
+	writer.write_uint(statistics.count);
+	writer.write_text(recording::KEY_STATISTICS_TARES);
+	writer.write_uint(statistics.tares);
+	writer.write_text(recording::KEY_STATISTICS_MIN);
+	writer.write_int(statistics.min);
+	writer.write_text(recording::KEY_STATISTICS_MAX);
+	writer.write_int(statistics.max);
+	writer.write_text(recording::KEY_STATISTICS_MEAN);
+	writer.write_float(statistics.mean);
+	writer.write_text(recording::KEY_STATISTICS_STDDEV);
+	writer.write_float(statistics.stddev());
+
+	writer.write_text(recording::KEY_READINGS);
+	writer.write_byte(0x9F);
+
+	std::rewind(tmp.get());
+	char buffer[65536];
+	size_t length;
+
+	while ((length = std::fread(buffer, 1, sizeof(buffer), tmp.get())) > 0)
+		std::fwrite(buffer, 1, length, f.get());
+
+	writer.write_byte(0xFF);
+
+	if (std::ferror(f.get()) || std::fclose(f.release())) {
+		std::perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	std::fprintf(stderr, "%lu readings (%lu invalid, %lu overwritten, %lu events) in %.3fs (%.1fk readings/s)\n",
+		readings, invalid, (unsigned long)hx711.overwritten(), events, elapsed.count(),
+		readings / elapsed.count() / 1e3);
+
+	if (compressed)
+		std::fprintf(stderr, "%lu readings kept (%.1f%%)\n", kept, readings ? kept * 100.0 / readings : 0.0);
+
+	if (stream)
+		std::fprintf(stderr, "%lu telemetry packets sent (%lu dropped)\n", stream->sent(), stream->dropped());
+
+	return EXIT_SUCCESS;
+}
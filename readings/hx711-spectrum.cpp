@@ -0,0 +1,163 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Output the vibration spectrum of recordings (.cbor) as CSV, using the
+ * same code as the device.
+ *
+ * With -c, fail unless the largest peak is within one bin of the expected
+ * frequency, to check recordings made with "hx711-simulate -v". With -a,
+ * also fail unless its amplitude is within 10% of the expected amplitude.
+ */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "scales/recording_parser.h"
+#include "scales/spectrum.h"
+
+using namespace scales;
+
+namespace {
+
+void usage(const char *name) {
+	std::fprintf(stderr, "Usage: %s [-p peaks] [-m points] [-c expected Hz [-a expected amplitude]] <file.cbor>...\n", name);
+}
+
+bool analyse(const char *filename, Spectrum &spectrum) {
+	std::unique_ptr<FILE, decltype(&std::fclose)> f{std::fopen(filename, "rb"), &std::fclose};
+	RecordingParser parser{[&spectrum] (uint64_t time_us, int32_t value, uint8_t) {
+		spectrum.add(time_us, value);
+	}};
+	uint8_t buffer[4096];
+	size_t length;
+
+	if (!f) {
+		std::perror(filename);
+		return false;
+	}
+
+	spectrum.reset();
+
+	while ((length = std::fread(buffer, 1, sizeof(buffer), f.get())) > 0) {
+		if (!parser.parse(buffer, length))
+			break;
+	}
+
+	if (!parser.finished()) {
+		std::fprintf(stderr, "%s: invalid recording\n", filename);
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	size_t max_peaks = 5;
+	size_t points = 0;
+	float expected_hz = 0;
+	float expected_amplitude = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:m:c:a:h")) != -1) {
+		switch (opt) {
+		case 'p':
+			max_peaks = std::max(1UL, std::strtoul(optarg, nullptr, 10));
+			break;
+
+		case 'm':
+			points = std::strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'c':
+			expected_hz = std::strtof(optarg, nullptr);
+			break;
+
+		case 'a':
+			expected_amplitude = std::strtof(optarg, nullptr);
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	auto spectrum = std::make_unique<Spectrum>();
+	std::vector<Spectrum::Peak> peaks(std::max(max_peaks, points));
+	bool failed = false;
+
+	if (points) {
+		std::printf("File,Frequency (Hz),Amplitude\n");
+	} else {
+		std::printf("File,Readings,Rate (Hz),Segments,Frequency (Hz),Amplitude\n");
+	}
+
+	for (int i = optind; i < argc; i++) {
+		if (!analyse(argv[i], *spectrum)) {
+			failed = true;
+			continue;
+		}
+
+		if (points) {
+			spectrum->decimate(peaks.data(), points);
+
+			for (size_t j = 0; j < points; j++)
+				std::printf("%s,%.3f,%.2f\n", argv[i], peaks[j].frequency_hz, peaks[j].amplitude);
+		} else {
+			size_t found = spectrum->peaks(peaks.data(), max_peaks);
+
+			for (size_t j = 0; j < found; j++) {
+				std::printf("%s,%lu,%.3f,%lu,%.3f,%.2f\n", argv[i], spectrum->count(),
+					spectrum->rate_hz(), spectrum->segments(),
+					peaks[j].frequency_hz, peaks[j].amplitude);
+			}
+		}
+
+		if (expected_hz > 0) {
+			Spectrum::Peak largest{0, 0};
+
+			if (!spectrum->peaks(&largest, 1)
+					|| std::abs(largest.frequency_hz - expected_hz) > spectrum->resolution_hz()) {
+				std::fprintf(stderr, "%s: largest peak at %.3fHz, expected %.3fHz\n",
+					argv[i], largest.frequency_hz, expected_hz);
+				failed = true;
+			} else if (expected_amplitude > 0
+					&& std::abs(largest.amplitude - expected_amplitude) > expected_amplitude * 0.1f) {
+				std::fprintf(stderr, "%s: largest peak amplitude %.2f, expected %.2f\n",
+					argv[i], largest.amplitude, expected_amplitude);
+				failed = true;
+			}
+		}
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
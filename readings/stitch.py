@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# hx711-weigh-scales-logger - HX711 weigh scales data logger
+# Copyright 2025  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Join the files of a continuous recording back into one recording.
+#
+# Usage: stitch.py <file.cbor> <output.cbor>
+#
+# Any file of the recording can be given, the others are found in the same
+# directory by following the "previous" and "next" filenames of each file.
+# Files that are missing are reported and the output stops at the gap.
+
+import cbor2
+import math
+import os
+import sys
+
+
+def load(filename):
+	with open(filename, "rb") as f:
+		return dict(cbor2.load(f))
+
+
+def chain(filename):
+	directory = os.path.dirname(filename)
+	files = {filename: load(filename)}
+	complete = True
+
+	def follow(name, key):
+		nonlocal complete
+		while True:
+			segment = files[name].get("segment", {})
+			link = segment.get(key)
+			if not link:
+				return name
+			link = os.path.join(directory, link)
+			if not os.path.exists(link):
+				print(f"{name}: {key} file {link} is missing", file=sys.stderr)
+				complete = False
+				return name
+			files[link] = load(link)
+			name = link
+
+	first = follow(filename, "previous")
+	follow(filename, "next")
+
+	names = [first]
+	while True:
+		link = files[names[-1]].get("segment", {}).get("next")
+		link = link and os.path.join(directory, link)
+		if link not in files:
+			break
+		names.append(link)
+
+	for previous, name in zip(names, names[1:]):
+		if files[name]["segment"]["index"] != files[previous]["segment"]["index"] + 1:
+			print(f"{name}: index does not follow {previous}", file=sys.stderr)
+			complete = False
+
+	return [(name, files[name]) for name in names], complete
+
+
+def merge_statistics(a, b):
+	if not a or not b:
+		return a or b
+
+	count = a["count"] + b["count"]
+	if count == 0:
+		return a
+
+	delta = b["mean"] - a["mean"]
+	m2 = sum(s["stddev"] ** 2 * (s["count"] - 1) for s in (a, b) if s["count"] > 1)
+	m2 += delta * delta * a["count"] * b["count"] / count
+
+	return {
+		"count": count,
+		"tares": a["tares"] + b["tares"],
+		"min": min(a["min"], b["min"]),
+		"max": max(a["max"], b["max"]),
+		"mean": a["mean"] + delta * b["count"] / count,
+		"stddev": math.sqrt(m2 / (count - 1)) if count > 1 else 0.0,
+	}
+
+
+def stitch(segments):
+	output = {key: value for key, value in segments[0][1].items()
+		if key not in ("segment", "statistics", "anchors", "readings")}
+	readings = []
+	anchors = []
+	statistics = None
+	now_us = output["start_us"]
+	value = 0
+
+	for name, data in segments:
+		assert list(data["readings_format"]) == list(output["readings_format"]), name
+
+		# Each file starts again from its start time and a value of 0
+		segment_us = data["start_us"]
+		segment_value = 0
+		offset_time_us = None
+
+		for reading in data["readings"]:
+			if isinstance(reading, (str, list, tuple)):
+				readings.append(reading)
+			elif offset_time_us is None:
+				offset_time_us = reading
+			else:
+				segment_us += offset_time_us
+				segment_value += reading
+				readings.append(segment_us - now_us)
+				readings.append(segment_value - value)
+				now_us = segment_us
+				value = segment_value
+				offset_time_us = None
+
+		for realtime_us, offset_us in data.get("anchors", []):
+			offset_us += data["start_us"] - output["start_us"]
+			if not anchors or offset_us > anchors[-1][1]:
+				anchors.append([realtime_us, offset_us])
+
+		statistics = merge_statistics(statistics, data.get("statistics"))
+		output["stop_us"] = data["stop_us"]
+
+	if statistics:
+		output["statistics"] = statistics
+	if anchors:
+		output["anchors"] = anchors
+	output["readings"] = readings
+	return output
+
+
+if __name__ == "__main__":
+	if len(sys.argv) != 3:
+		print(f"Usage: {sys.argv[0]} <file.cbor> <output.cbor>", file=sys.stderr)
+		sys.exit(1)
+
+	segments, complete = chain(sys.argv[1])
+	data = stitch(segments)
+
+	with open(sys.argv[2], "wb") as f:
+		cbor2.dump(cbor2.CBORTag(55799, data), f)
+
+	print(f"{len(segments)} files, {sum(1 for reading in data['readings'] if isinstance(reading, int)) // 2} readings")
+	if not complete:
+		sys.exit(1)
@@ -0,0 +1,111 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/allocations.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace {
+
+struct TaskCounter {
+	std::atomic<TaskHandle_t> task{nullptr};
+	std::atomic<uint32_t> count{0};
+};
+
+std::atomic<uint32_t> allocations{0};
+std::atomic<unsigned int> counting_tasks{0};
+std::array<TaskCounter,scales::TaskAllocations::MAX_TASKS> task_counters;
+
+inline void count_allocation() {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	/* Avoid looking up the current task when nothing is being counted */
+	if (!counting_tasks.load(std::memory_order_relaxed))
+		return;
+
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+	for (auto &counter : task_counters) {
+		if (counter.task.load(std::memory_order_relaxed) == task)
+			counter.count.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+} // namespace
+
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+	count_allocation();
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+	count_allocation();
+	return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	count_allocation();
+	return __real_realloc(ptr, size);
+}
+
+} // extern "C"
+
+namespace scales {
+
+uint32_t allocation_count() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+TaskAllocations::TaskAllocations() {
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+	for (size_t i = 0; i < task_counters.size(); i++) {
+		TaskHandle_t expected = nullptr;
+
+		if (task_counters[i].task.compare_exchange_strong(expected, task)) {
+			task_counters[i].count.store(0, std::memory_order_relaxed);
+			counting_tasks.fetch_add(1, std::memory_order_relaxed);
+			slot_ = i;
+			break;
+		}
+	}
+}
+
+TaskAllocations::~TaskAllocations() {
+	if (slot_ >= 0) {
+		task_counters[slot_].task.store(nullptr);
+		counting_tasks.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+uint32_t TaskAllocations::count() const {
+	return slot_ >= 0 ? task_counters[slot_].count.load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace scales
@@ -22,6 +22,7 @@
 
 #include <memory>
 
+#include "scales/trace.h"
 #include "scales/web_interface.h"
 
 namespace scales {
@@ -31,12 +32,19 @@ App::App() {
 
 void App::start() {
 	app::App::start();
+	trace::init();
 	hx711_.init();
+	uploader_.start();
+	telemetry_.start();
 	web_interface_ = std::make_unique<WebInterface>(*this);
 }
 
 void App::loop() {
+	uint64_t start_us = ::esp_timer_get_time();
+
 	app::App::loop();
+	/* Network, console and log output, if it's slow enough to delay readings */
+	trace::complete(trace::Category::LOOP, "app", start_us, LOOP_TRACE_MIN_US);
 	hx711_.loop();
 }
 
@@ -0,0 +1,141 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "scales/compressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+
+namespace scales {
+
+Compressor::Compressor(const Parameters &parameters) {
+	reset(parameters);
+}
+
+const char *Compressor::mode_name(Mode mode) {
+	switch (mode) {
+	case Mode::DEADBAND: return "deadband";
+	case Mode::SWINGING_DOOR: return "swinging_door";
+	case Mode::LOSSLESS: break;
+	}
+
+	return "lossless";
+}
+
+bool Compressor::mode(std::string_view name, Mode &mode) {
+	for (auto value : {Mode::LOSSLESS, Mode::DEADBAND, Mode::SWINGING_DOOR}) {
+		if (name == mode_name(value)) {
+			mode = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Compressor::reset(const Parameters &parameters) {
+	parameters_ = parameters;
+	started_ = false;
+	held_ = false;
+}
+
+uint8_t Compressor::add(uint64_t time_us, int32_t value, bool keep) {
+	Point point{time_us, value};
+
+	if (parameters_.mode == Mode::LOSSLESS)
+		return Keep::CURRENT;
+
+	if (!started_ || keep || time_us >= archived_.time_us + MAX_INTERVAL_US) {
+		uint8_t result = held_ ? (Keep::PREVIOUS | Keep::CURRENT) : Keep::CURRENT;
+
+		previous_ = last_;
+		archive(point);
+		started_ = true;
+		return result;
+	}
+
+	if (parameters_.mode == Mode::DEADBAND) {
+		if ((uint32_t)std::abs(value - archived_.value) > parameters_.tolerance) {
+			archive(point);
+			return Keep::CURRENT;
+		}
+
+		last_ = point;
+		held_ = true;
+		return Keep::NONE;
+	}
+
+	double point_upper, point_lower;
+
+	open(point, point_upper, point_lower);
+
+	/* Slope of the line from the last kept reading to this one */
+	double slope = (point_upper + point_lower) / 2;
+	double upper = std::min(upper_, point_upper);
+	double lower = std::max(lower_, point_lower);
+
+	/*
+	 * The line must be within the tolerance of every reading since the
+	 * last kept reading, which is not possible once the doors have swung
+	 * past parallel. The previous reading is kept because its line was.
+	 */
+	if (slope > upper || slope < lower) {
+		previous_ = last_;
+		archive(last_);
+		open(point, upper_, lower_);
+		last_ = point;
+		held_ = true;
+		return Keep::PREVIOUS;
+	}
+
+	upper_ = upper;
+	lower_ = lower;
+	last_ = point;
+	held_ = true;
+	return Keep::NONE;
+}
+
+bool Compressor::flush(Point &point) {
+	if (!held_)
+		return false;
+
+	point = last_;
+	held_ = false;
+	return true;
+}
+
+void Compressor::archive(const Point &point) {
+	archived_ = point;
+	held_ = false;
+	upper_ = std::numeric_limits<double>::infinity();
+	lower_ = -std::numeric_limits<double>::infinity();
+}
+
+void Compressor::open(const Point &point, double &upper, double &lower) const {
+	/* Corrected times can be slightly before the previous time */
+	double interval = point.time_us > archived_.time_us ? point.time_us - archived_.time_us : 1;
+
+	upper = ((double)point.value + parameters_.tolerance - archived_.value) / interval;
+	lower = ((double)point.value - parameters_.tolerance - archived_.value) / interval;
+}
+
+} // namespace scales
@@ -18,8 +18,15 @@
 
 #include "scales/console.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <memory>
 #include <string>
+#include <time.h>
 #include <vector>
 
 #include <uuid/console.h>
@@ -28,6 +35,12 @@
 #include "scales/app.h"
 #include "app/config.h"
 #include "app/console.h"
+#include "scales/recording.h"
+#include "scales/spectrum.h"
+#include "scales/step_detector.h"
+#include "scales/telemetry_sender.h"
+#include "scales/trace.h"
+#include "scales/uploader.h"
 
 using ::uuid::flash_string_vector;
 using ::uuid::console::Commands;
@@ -48,6 +61,43 @@ MAKE_PSTR_WORD(readings)
 MAKE_PSTR_WORD(start)
 MAKE_PSTR_WORD(stop)
 MAKE_PSTR_WORD(tare)
+MAKE_PSTR_WORD(watch)
+MAKE_PSTR(interval_ms_optional, "[interval ms]")
+MAKE_PSTR_WORD(events)
+MAKE_PSTR_WORD(threshold)
+MAKE_PSTR_WORD(window)
+MAKE_PSTR_WORD(factor)
+MAKE_PSTR(value_mandatory, "<value>")
+MAKE_PSTR_WORD(zero)
+MAKE_PSTR(range_optional, "[range]")
+MAKE_PSTR_WORD(spectrum)
+MAKE_PSTR(filename_optional, "[filename]")
+MAKE_PSTR_WORD(rate)
+MAKE_PSTR(rate_optional, "[10|80]")
+MAKE_PSTR_WORD(compression)
+MAKE_PSTR(mode_tolerance_optional, "[lossless|deadband|swinging_door] [tolerance]")
+MAKE_PSTR_WORD(rotation)
+MAKE_PSTR(minutes_readings_optional, "[minutes [readings]]")
+MAKE_PSTR_WORD(upload)
+MAKE_PSTR_WORD(url)
+MAKE_PSTR(url_optional, "[url]")
+MAKE_PSTR_WORD(now)
+MAKE_PSTR_WORD(delete)
+MAKE_PSTR_WORD(telemetry)
+MAKE_PSTR_WORD(destination)
+MAKE_PSTR(destination_optional, "[address[:port]]")
+MAKE_PSTR_WORD(trace)
+MAKE_PSTR(on_off_clear_optional, "[on|off|clear]")
+#if defined(SCALES_VIRTUAL_HX711)
+MAKE_PSTR_WORD(virtual)
+MAKE_PSTR_WORD(noise)
+MAKE_PSTR_WORD(profile)
+MAKE_PSTR(hz_mandatory, "<Hz>")
+MAKE_PSTR(stddev_mandatory, "<stddev>")
+MAKE_PSTR(points_mandatory, "<time_s:value,...>")
+MAKE_PSTR_WORD(vibration)
+MAKE_PSTR(amplitude_mandatory, "<amplitude>")
+#endif
 
 namespace scales {
 
@@ -81,6 +131,11 @@ static void readings(Shell &shell, const std::vector<std::string> &arguments) {
 	HX711 &hx711 = to_app(shell).hx711();
 
 	shell.printfln(F("Current: %d"), (int)hx711.reading());
+	shell.printfln(F("Rate: %uHz%s"), hx711.rate(),
+		hx711.rate_selectable() ? "" : " (not selectable)");
+	shell.printfln(F("Period: %.3fus (jitter %luns)"),
+		hx711.stats().period_ns.load(std::memory_order_relaxed) / 1000.0,
+		(unsigned long)hx711.stats().jitter_ns.load(std::memory_order_relaxed));
 
 	if (hx711.start_us() > 0) {
 		shell.printfln(F("Started at %" PRIu64 " (%lu.%06lu)"), hx711.start_us(),
@@ -91,20 +146,680 @@ static void readings(Shell &shell, const std::vector<std::string> &arguments) {
 			shell.printfln(F("Stopped after %" PRIu64), hx711.duration_us());
 		}
 		shell.printfln(F("Readings: %lu/%lu"), hx711.count(), hx711.max_count());
+
+		auto statistics = hx711.statistics();
+
+		if (statistics.count > 0) {
+			shell.printfln(F("Statistics: mean %.1f, stddev %.1f, min %ld, max %ld, %lu tares"),
+				statistics.mean, statistics.stddev(), (long)statistics.min,
+				(long)statistics.max, (unsigned long)statistics.tares);
+		}
+
+		auto compression = hx711.compression();
+
+		if (compression.mode != Compressor::Mode::LOSSLESS && statistics.count > 0) {
+			shell.printfln(F("Compression: %s (tolerance %lu), kept %lu of %lu readings"),
+				Compressor::mode_name(compression.mode), (unsigned long)compression.tolerance,
+				hx711.count(), (unsigned long)statistics.count);
+		}
+
+		auto rotation = hx711.rotation();
+
+		if (rotation.minutes || rotation.readings) {
+			shell.printfln(F("Rotation: every %u minutes, %lu readings, %lu files so far"),
+				rotation.minutes, rotation.readings,
+				(unsigned long)hx711.stats().rotations.load(std::memory_order_relaxed));
+		}
 	} else {
 		shell.printfln(F("Never started"));
 	}
+
+	shell.printfln(F("Buffer: %zuKB, %zu previous recordings"),
+		hx711.buffer_bytes() / 1024, hx711.resident_count());
+	if (hx711.max_duration_us()) {
+		shell.printfln(F("Capacity: %lu readings (%lu min)"), hx711.max_count(),
+			(unsigned long)(hx711.max_duration_us() / 60000000ULL));
+	}
 }
 
 static void stop(Shell &shell, const std::vector<std::string> &arguments) {
 	to_app(shell).hx711().stop();
 }
 
+/*
+ * Statistics over a rolling window of readings, in one second buckets so
+ * that each reading is O(1) and nothing needs to be stored per reading.
+ *
+ * The readings come from the live readings so that none of them are
+ * missed if the shell is slower than the sample rate, and the rate is
+ * from the count of samples over the time covered by the buckets.
+ */
+class WatchWindow {
+public:
+	static constexpr uint64_t BUCKET_MS = 1000;
+	static constexpr size_t BUCKETS = 10;
+
+	WatchWindow(uint64_t now_ms, uint32_t samples) : start_ms_(now_ms) {
+		buckets_[0] = {0, now_ms, samples, true};
+	}
+
+	/* Start new buckets up to now_ms, before adding readings up to now_ms */
+	void advance(uint64_t now_ms, uint32_t samples) {
+		uint64_t index = (now_ms - start_ms_) / BUCKET_MS;
+
+		if (index > index_ + BUCKETS)
+			index_ = index - BUCKETS;
+
+		while (index_ < index) {
+			index_++;
+			buckets_[index_ % BUCKETS] = {index_, now_ms, samples, true};
+		}
+	}
+
+	void add(uint64_t time_ms, int32_t value) {
+		uint64_t index = time_ms > start_ms_ ? (time_ms - start_ms_) / BUCKET_MS : 0;
+
+		/* Too old for the window */
+		if (index + BUCKETS <= index_)
+			return;
+
+		Bucket &bucket = buckets_[std::min(index, index_) % BUCKETS];
+
+		if (bucket.count == 0) {
+			bucket.min = value;
+			bucket.max = value;
+		} else {
+			bucket.min = std::min(bucket.min, value);
+			bucket.max = std::max(bucket.max, value);
+		}
+		bucket.sum += value;
+		bucket.count++;
+	}
+
+	void print(Shell &shell, uint64_t now_ms, uint32_t samples) {
+		advance(now_ms, samples);
+
+		const Bucket *oldest = nullptr;
+		unsigned long count = 0;
+		int64_t sum = 0;
+		int32_t min = 0;
+		int32_t max = 0;
+
+		for (const auto &bucket : buckets_) {
+			if (!bucket.used)
+				continue;
+
+			if (!oldest || bucket.index < oldest->index)
+				oldest = &bucket;
+
+			if (bucket.count == 0)
+				continue;
+
+			if (count == 0) {
+				min = bucket.min;
+				max = bucket.max;
+			} else {
+				min = std::min(min, bucket.min);
+				max = std::max(max, bucket.max);
+			}
+			sum += bucket.sum;
+			count += bucket.count;
+		}
+
+		uint64_t elapsed_ms = now_ms - oldest->start_ms;
+
+		if (count == 0) {
+			shell.printf(F("no readings"));
+		} else {
+			shell.printf(F("%.1fHz min %d max %d mean %.1f (%lus)"),
+				(samples - oldest->start_samples) * 1000.0 / std::max(elapsed_ms, (uint64_t)1),
+				(int)min, (int)max, (double)sum / count,
+				(unsigned long)((elapsed_ms + BUCKET_MS / 2) / BUCKET_MS));
+		}
+	}
+
+private:
+	struct Bucket {
+		uint64_t index{0};
+		uint64_t start_ms{0};
+		uint32_t start_samples{0};
+		bool used{false};
+		unsigned long count{0};
+		int64_t sum{0};
+		int32_t min{0};
+		int32_t max{0};
+	};
+
+	const uint64_t start_ms_;
+	uint64_t index_{0};
+	std::array<Bucket,BUCKETS> buckets_{};
+};
+
+static void watch(Shell &shell, const std::vector<std::string> &arguments) {
+	static constexpr unsigned long MIN_INTERVAL_MS = 100;
+	static constexpr unsigned long DEFAULT_INTERVAL_MS = 1000;
+	unsigned long interval_ms = DEFAULT_INTERVAL_MS;
+
+	if (!arguments.empty()) {
+		interval_ms = std::max(MIN_INTERVAL_MS, ::strtoul(arguments[0].c_str(), nullptr, 10));
+	}
+
+	HX711 &hx711 = to_app(shell).hx711();
+	auto window = std::make_shared<WatchWindow>(hx711.now_us() / 1000,
+		hx711.stats().samples.load(std::memory_order_relaxed));
+	uint32_t index = hx711.live_index();
+	unsigned long last_ms = ::millis();
+
+	shell.printfln(F("Press any key to stop"));
+
+	/*
+	 * Output is limited to one short line per interval so that a slow
+	 * serial console doesn't delay the readings.
+	 */
+	shell.block_with([&hx711, window, index, last_ms, interval_ms]
+			(Shell &shell, bool stop) mutable -> bool {
+		const HX711::Stats &stats = hx711.stats();
+		std::array<HX711::LiveReading,16> readings;
+		uint32_t samples = stats.samples.load(std::memory_order_relaxed);
+		uint64_t now_ms = hx711.now_us() / 1000;
+		size_t count;
+
+		window->advance(now_ms, samples);
+
+		while ((count = hx711.live_readings(index, readings.data(), readings.size())) > 0) {
+			for (size_t i = 0; i < count; i++) {
+				const auto &reading = readings[i];
+
+				if (!(reading.data.type & Type::TARE_VALUE)) {
+					window->add(reading.time_us / 1000,
+						recording::sign_extend(reading.data.value) - reading.tare_value);
+				}
+			}
+
+			index += count;
+		}
+
+		if (stop || shell.available()) {
+			while (shell.available())
+				shell.read();
+			return true;
+		}
+
+		if (::millis() - last_ms < interval_ms)
+			return false;
+
+		last_ms = ::millis();
+		shell.printf(F("%d | "), (int)hx711.reading());
+		window->print(shell, now_ms, samples);
+		shell.printfln(F(" | invalid %lu late %lu dropped %lu"),
+			(unsigned long)stats.invalid_reads.load(std::memory_order_relaxed),
+			(unsigned long)stats.late_reads.load(std::memory_order_relaxed),
+			(unsigned long)stats.dropped_readings.load(std::memory_order_relaxed));
+		return false;
+	});
+}
+
+static void events(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+	auto parameters = hx711.step_parameters();
+	int32_t level;
+	uint32_t noise;
+
+	shell.printfln(F("Window: %u readings at %uHz, threshold: %ld, settle factor: %u"),
+		parameters.window, HX711::FAST_RATE_HZ, (long)parameters.step_threshold,
+		parameters.settle_factor);
+
+	if (hx711.settled(level, noise)) {
+		shell.printfln(F("Settled at %ld, noise %lu"), (long)level, (unsigned long)noise);
+	} else {
+		shell.printfln(F("Not settled, noise %lu"), (unsigned long)noise);
+	}
+
+	shell.println();
+	shell.printfln(F("Time                Event    Level        Step         Settling"));
+
+	hx711.events([&shell] (const HX711::Event &event) {
+		char buffer[32];
+		time_t t = event.realtime.tv_sec;
+		struct tm tm{};
+
+		::localtime_r(&t, &tm);
+		::strftime(buffer, sizeof(buffer), "%F %H:%M:%S", &tm);
+
+		if (event.type == StepDetector::SETTLED) {
+			shell.printfln(F("%s %-8s %-12ld %-12ld %lums"), buffer,
+				recording::flag_name(event.type), (long)event.level,
+				(long)event.step, (unsigned long)event.settling_ms);
+		} else {
+			shell.printfln(F("%s %-8s %ld"), buffer,
+				recording::flag_name(event.type), (long)event.level);
+		}
+	});
+}
+
+static void events_parameter(Shell &shell, const std::vector<std::string> &arguments,
+		std::function<void(StepDetector::Parameters &parameters, long value)> func) {
+	HX711 &hx711 = to_app(shell).hx711();
+	auto parameters = hx711.step_parameters();
+	long value = std::strtol(arguments[0].c_str(), nullptr, 10);
+
+	if (value < 1) {
+		shell.printfln(F("Invalid value"));
+		return;
+	}
+
+	func(parameters, value);
+	hx711.step_parameters(parameters);
+}
+
+static void events_window(Shell &shell, const std::vector<std::string> &arguments) {
+	events_parameter(shell, arguments, [] (StepDetector::Parameters &parameters, long value) {
+		parameters.window = value;
+	});
+}
+
+static void events_threshold(Shell &shell, const std::vector<std::string> &arguments) {
+	events_parameter(shell, arguments, [] (StepDetector::Parameters &parameters, long value) {
+		parameters.step_threshold = value;
+	});
+}
+
+static void events_factor(Shell &shell, const std::vector<std::string> &arguments) {
+	events_parameter(shell, arguments, [] (StepDetector::Parameters &parameters, long value) {
+		parameters.settle_factor = value;
+	});
+}
+
+static void zero(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+
+	if (!arguments.empty()) {
+		long value = std::strtol(arguments[0].c_str(), nullptr, 10);
+
+		if (value < 0) {
+			shell.printfln(F("Invalid range"));
+			return;
+		}
+
+		hx711.zero_tracking(value);
+	}
+
+	if (hx711.zero_tracking()) {
+		shell.printfln(F("Zero tracking within %ld of the tare"), (long)hx711.zero_tracking());
+	} else {
+		shell.printfln(F("Zero tracking disabled"));
+	}
+}
+
+static void rate(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+
+	if (!arguments.empty()) {
+		unsigned long value = std::strtoul(arguments[0].c_str(), nullptr, 10);
+
+		if (value != HX711::SLOW_RATE_HZ && value != HX711::FAST_RATE_HZ) {
+			shell.printfln(F("Invalid rate"));
+			return;
+		}
+
+		if (!hx711.rate(value)) {
+			shell.printfln(F("Unable to change rate"));
+			return;
+		}
+	}
+
+	shell.printfln(F("Rate: %uHz%s"), hx711.rate(),
+		hx711.rate_selectable() ? "" : " (not selectable)");
+}
+
+static void compression(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+
+	if (!arguments.empty()) {
+		Compressor::Parameters parameters;
+
+		if (!Compressor::mode(arguments[0], parameters.mode)) {
+			shell.printfln(F("Invalid mode"));
+			return;
+		}
+
+		if (arguments.size() >= 2) {
+			parameters.tolerance = std::strtoul(arguments[1].c_str(), nullptr, 10);
+		} else if (parameters.mode != Compressor::Mode::LOSSLESS) {
+			shell.printfln(F("Tolerance required"));
+			return;
+		}
+
+		if (!hx711.compression(parameters)) {
+			shell.printfln(F("Unable to change compression"));
+			return;
+		}
+	}
+
+	auto compression = hx711.compression();
+
+	if (compression.mode == Compressor::Mode::LOSSLESS) {
+		shell.printfln(F("Compression: %s"), Compressor::mode_name(compression.mode));
+	} else {
+		shell.printfln(F("Compression: %s (tolerance %lu)"),
+			Compressor::mode_name(compression.mode), (unsigned long)compression.tolerance);
+	}
+}
+
+static void rotation(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+
+	if (!arguments.empty()) {
+		HX711::Rotation rotation;
+
+		rotation.minutes = std::strtoul(arguments[0].c_str(), nullptr, 10);
+		if (arguments.size() >= 2)
+			rotation.readings = std::strtoul(arguments[1].c_str(), nullptr, 10);
+
+		hx711.rotation(rotation);
+	}
+
+	auto rotation = hx711.rotation();
+
+	if (!rotation.minutes && !rotation.readings) {
+		shell.printfln(F("Rotation: disabled"));
+	} else {
+		shell.printfln(F("Rotation: every %u minutes, %lu readings (0 for no limit)"),
+			rotation.minutes, rotation.readings);
+	}
+}
+
+static void upload(Shell &shell, const std::vector<std::string> &arguments) {
+	Uploader &uploader = to_app(shell).uploader();
+	const Uploader::Stats &stats = uploader.stats();
+	std::string url = uploader.url();
+
+	shell.printfln(F("URL: %s"), url.empty() ? "(disabled)" : url.c_str());
+	shell.printfln(F("Pending: %zu recordings"), uploader.pending());
+	shell.printfln(F("Uploaded: %lu recordings, %lu bytes (%lu resumed)"),
+		(unsigned long)stats.files.load(std::memory_order_relaxed),
+		(unsigned long)stats.bytes.load(std::memory_order_relaxed),
+		(unsigned long)stats.resumed.load(std::memory_order_relaxed));
+	shell.printfln(F("Connections: %lu, errors: %lu"),
+		(unsigned long)stats.connections.load(std::memory_order_relaxed),
+		(unsigned long)stats.errors.load(std::memory_order_relaxed));
+}
+
+static void upload_url(Shell &shell, const std::vector<std::string> &arguments) {
+	Uploader &uploader = to_app(shell).uploader();
+
+	if (!arguments.empty()) {
+		if (!arguments[0].empty() && arguments[0].rfind("http://", 0) != 0
+				&& arguments[0].rfind("https://", 0) != 0) {
+			shell.printfln(F("Invalid URL"));
+			return;
+		}
+
+		uploader.url(arguments[0]);
+	}
+
+	std::string url = uploader.url();
+
+	shell.printfln(F("URL: %s"), url.empty() ? "(disabled)" : url.c_str());
+}
+
+static void upload_now(Shell &shell, const std::vector<std::string> &arguments) {
+	to_app(shell).uploader().wake();
+}
+
+static void upload_delete(Shell &shell, const std::vector<std::string> &arguments) {
+	HX711 &hx711 = to_app(shell).hx711();
+	Uploader &uploader = to_app(shell).uploader();
+	std::vector<std::string> filenames;
+
+	hx711.list_files([&uploader, &filenames] (std::string_view filename,
+			std::string_view timestamp, bool resident,
+			const recording::Statistics *statistics) {
+		if (uploader.uploaded(filename))
+			filenames.emplace_back(filename);
+	});
+
+	std::vector<std::string_view> names{filenames.begin(), filenames.end()};
+
+	shell.printfln(F("Deleted %u uploaded recordings"), hx711.delete_files(names));
+}
+
+static void telemetry_status(Shell &shell, const std::vector<std::string> &arguments) {
+	const TelemetrySender &sender = to_app(shell).telemetry();
+	const TelemetrySender::Stats &stats = sender.stats();
+	std::string destination = sender.destination();
+
+	shell.printfln(F("Destination: %s"), destination.empty() ? "(disabled)" : destination.c_str());
+	shell.printfln(F("Sent: %lu packets, %lu readings"),
+		(unsigned long)stats.packets.load(std::memory_order_relaxed),
+		(unsigned long)stats.readings.load(std::memory_order_relaxed));
+	shell.printfln(F("Overruns: %lu readings, errors: %lu"),
+		(unsigned long)stats.overruns.load(std::memory_order_relaxed),
+		(unsigned long)stats.errors.load(std::memory_order_relaxed));
+}
+
+static void telemetry_destination(Shell &shell, const std::vector<std::string> &arguments) {
+	TelemetrySender &sender = to_app(shell).telemetry();
+
+	if (!arguments.empty() && !sender.destination(arguments[0])) {
+		shell.printfln(F("Invalid destination"));
+		return;
+	}
+
+	std::string destination = sender.destination();
+
+	shell.printfln(F("Destination: %s"), destination.empty() ? "(disabled)" : destination.c_str());
+}
+
+static void trace_status(Shell &shell, const std::vector<std::string> &arguments) {
+	if (!arguments.empty()) {
+		if (arguments[0] == "on") {
+			trace::enabled(true);
+		} else if (arguments[0] == "off") {
+			trace::enabled(false);
+		} else if (arguments[0] == "clear") {
+			trace::clear();
+		} else {
+			shell.printfln(F("Invalid argument"));
+			return;
+		}
+	}
+
+	if (!trace::capacity()) {
+		shell.printfln(F("Trace: unavailable"));
+		return;
+	}
+
+	shell.printfln(F("Trace: %s, %lu events (buffer for %zu), %luns per event"),
+		trace::enabled() ? "on" : "off", (unsigned long)trace::count(),
+		trace::capacity(), (unsigned long)trace::overhead_ns());
+}
+
+/* Analysis of a recording, which runs in its own task so that it doesn't delay the readings */
+struct SpectrumJob {
+	static constexpr uint32_t STACK_SIZE = 4096;
+	static constexpr size_t PEAKS = 8;
+	static constexpr size_t POINTS = 32;
+
+	SpectrumJob(HX711 &hx711, std::string filename)
+		: hx711(hx711), filename(std::move(filename)) {}
+
+	static void task(void *arg) {
+		std::unique_ptr<std::shared_ptr<SpectrumJob>> job{
+			static_cast<std::shared_ptr<SpectrumJob>*>(arg)};
+		SpectrumJob &self = **job;
+		Spectrum &spectrum = self.spectrum;
+
+		self.ok = self.hx711.read_readings(self.filename,
+			[&spectrum] (uint64_t time_us, int32_t value, uint8_t) {
+				spectrum.add(time_us, value);
+			});
+		self.done = true;
+
+		job.reset();
+		vTaskDelete(nullptr);
+	}
+
+	HX711 &hx711;
+	const std::string filename;
+	Spectrum spectrum;
+	bool ok{false};
+	std::atomic<bool> done{false};
+};
+
+static void spectrum(Shell &shell, const std::vector<std::string> &arguments) {
+	auto job = std::make_shared<SpectrumJob>(to_app(shell).hx711(),
+		arguments.empty() ? "" : arguments[0]);
+	auto arg = std::make_unique<std::shared_ptr<SpectrumJob>>(job);
+
+	if (xTaskCreate(&SpectrumJob::task, "spectrum", SpectrumJob::STACK_SIZE, arg.get(),
+			uxTaskPriorityGet(nullptr), nullptr) != pdPASS) {
+		shell.printfln(F("Unable to start analysis"));
+		return;
+	}
+
+	arg.release();
+
+	shell.block_with([job] (Shell &shell, bool stop) -> bool {
+		if (!job->done) {
+			if (stop || shell.available()) {
+				while (shell.available())
+					shell.read();
+				return true;
+			}
+
+			return false;
+		}
+
+		if (!job->ok) {
+			shell.printfln(F("Recording not found"));
+			return true;
+		}
+
+		const Spectrum &spectrum = job->spectrum;
+		std::array<Spectrum::Peak,std::max(SpectrumJob::PEAKS, SpectrumJob::POINTS)> peaks;
+
+		shell.printfln(F("%lu readings at %.3fHz, %lu segments of %.3fHz"),
+			spectrum.count(), (double)spectrum.rate_hz(),
+			spectrum.segments(), (double)spectrum.resolution_hz());
+		shell.println();
+
+		size_t found = spectrum.peaks(peaks.data(), SpectrumJob::PEAKS);
+
+		shell.printfln(F("Peak (Hz)   Amplitude"));
+		for (size_t i = 0; i < found; i++) {
+			shell.printfln(F("%9.3f   %9.2f"), (double)peaks[i].frequency_hz,
+				(double)peaks[i].amplitude);
+		}
+		shell.println();
+
+		float max_amplitude = 0;
+
+		spectrum.decimate(peaks.data(), SpectrumJob::POINTS);
+		for (size_t i = 0; i < SpectrumJob::POINTS; i++)
+			max_amplitude = std::max(max_amplitude, peaks[i].amplitude);
+
+		for (size_t i = 0; i < SpectrumJob::POINTS; i++) {
+			static constexpr unsigned int WIDTH = 40;
+			unsigned int width = max_amplitude > 0
+				? std::lround(peaks[i].amplitude * WIDTH / max_amplitude) : 0;
+
+			shell.printfln(F("%7.2fHz %9.2f %s"), (double)peaks[i].frequency_hz,
+				(double)peaks[i].amplitude, std::string(width, '#').c_str());
+		}
+
+		return true;
+	});
+}
+
+#if defined(SCALES_VIRTUAL_HX711)
+static void show_virtual(Shell &shell, const std::vector<std::string> &arguments) {
+	VirtualHX711 &hx711 = to_app(shell).virtual_hx711();
+
+	shell.printfln(F("Rate: %uHz"), hx711.rate());
+	shell.printfln(F("Noise: %.1f"), (double)hx711.noise());
+	shell.printfln(F("Vibration: %.2fHz, amplitude %.1f"), (double)hx711.vibration_hz(),
+		(double)hx711.vibration_amplitude());
+	shell.printfln(F("Profile: %s"), hx711.profile().c_str());
+	shell.printfln(F("Overwritten conversions: %lu"), (unsigned long)hx711.overwritten());
+}
+
+static void virtual_rate(Shell &shell, const std::vector<std::string> &arguments) {
+	unsigned long value = std::strtoul(arguments[0].c_str(), nullptr, 10);
+
+	if (value < 1 || value > 1000) {
+		shell.printfln(F("Invalid rate"));
+		return;
+	}
+
+	to_app(shell).virtual_hx711().rate(value);
+}
+
+static void virtual_noise(Shell &shell, const std::vector<std::string> &arguments) {
+	to_app(shell).virtual_hx711().noise(std::strtof(arguments[0].c_str(), nullptr));
+}
+
+static void virtual_vibration(Shell &shell, const std::vector<std::string> &arguments) {
+	to_app(shell).virtual_hx711().vibration(std::strtof(arguments[0].c_str(), nullptr),
+		std::strtof(arguments[1].c_str(), nullptr));
+}
+
+static void virtual_profile(Shell &shell, const std::vector<std::string> &arguments) {
+	if (!to_app(shell).virtual_hx711().profile(arguments[0])) {
+		shell.printfln(F("Invalid profile"));
+	}
+}
+#endif
+
+/* Trace the execution of the command, using the first two words as the name */
+static void add_command(std::shared_ptr<Commands> &commands, const flash_string_vector &name,
+		const flash_string_vector &arguments, Commands::command_function function) {
+	const char *trace_name = reinterpret_cast<const char*>(name[0]);
+	const char *trace_detail = name.size() > 1 ? reinterpret_cast<const char*>(name[1]) : nullptr;
+
+	commands->add_command(name, arguments, [trace_name, trace_detail, function]
+			(Shell &shell, const std::vector<std::string> &arguments) {
+		trace::Span span{trace::Category::CONSOLE, trace_name, trace_detail};
+
+		function(shell, arguments);
+	});
+}
+
+static void add_command(std::shared_ptr<Commands> &commands, const flash_string_vector &name,
+		Commands::command_function function) {
+	add_command(commands, name, {}, std::move(function));
+}
+
 static inline void setup_commands(std::shared_ptr<Commands> &commands) {
-	commands->add_command({F_(start)}, start);
-	commands->add_command({F_(tare)}, tare);
-	commands->add_command({F_(readings)}, readings);
-	commands->add_command({F_(stop)}, stop);
+	add_command(commands, {F_(start)}, start);
+	add_command(commands, {F_(tare)}, tare);
+	add_command(commands, {F_(readings)}, readings);
+	add_command(commands, {F_(stop)}, stop);
+	add_command(commands, {F_(watch)}, {F_(interval_ms_optional)}, watch);
+	add_command(commands, {F_(events)}, events);
+	add_command(commands, {F_(events), F_(window)}, {F_(value_mandatory)}, events_window);
+	add_command(commands, {F_(events), F_(threshold)}, {F_(value_mandatory)}, events_threshold);
+	add_command(commands, {F_(events), F_(factor)}, {F_(value_mandatory)}, events_factor);
+	add_command(commands, {F_(zero)}, {F_(range_optional)}, zero);
+	add_command(commands, {F_(spectrum)}, {F_(filename_optional)}, spectrum);
+	add_command(commands, {F_(rate)}, {F_(rate_optional)}, rate);
+	add_command(commands, {F_(compression)}, {F_(mode_tolerance_optional)}, compression);
+	add_command(commands, {F_(rotation)}, {F_(minutes_readings_optional)}, rotation);
+	add_command(commands, {F_(upload)}, upload);
+	add_command(commands, {F_(upload), F_(url)}, {F_(url_optional)}, upload_url);
+	add_command(commands, {F_(upload), F_(now)}, upload_now);
+	add_command(commands, {F_(upload), F_(delete)}, upload_delete);
+	add_command(commands, {F_(telemetry)}, telemetry_status);
+	add_command(commands, {F_(telemetry), F_(destination)}, {F_(destination_optional)}, telemetry_destination);
+	add_command(commands, {F_(trace)}, {F_(on_off_clear_optional)}, trace_status);
+#if defined(SCALES_VIRTUAL_HX711)
+	add_command(commands, {F_(virtual)}, show_virtual);
+	add_command(commands, {F_(virtual), F_(rate)}, {F_(hz_mandatory)}, virtual_rate);
+	add_command(commands, {F_(virtual), F_(noise)}, {F_(stddev_mandatory)}, virtual_noise);
+	add_command(commands, {F_(virtual), F_(profile)}, {F_(points_mandatory)}, virtual_profile);
+	add_command(commands, {F_(virtual), F_(vibration)}, {F_(hz_mandatory), F_(amplitude_mandatory)},
+		virtual_vibration);
+#endif
 }
 
 ScalesShell::ScalesShell(app::App &app, Stream &stream, unsigned int context, unsigned int flags)
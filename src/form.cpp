@@ -0,0 +1,50 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/form.h"
+
+#include <functional>
+#include <string_view>
+
+namespace scales {
+
+void parse_form(std::string_view text,
+		const std::function<void(std::string_view name, std::string_view value)> &func) {
+	while (text.length() > 0) {
+		std::string_view value;
+		auto amp_pos = text.find('&');
+
+		if (amp_pos != std::string_view::npos) {
+			value = text.substr(0, amp_pos);
+			text.remove_prefix(amp_pos + 1);
+		} else {
+			value = text;
+			text = {};
+		}
+
+		auto eq_pos = value.find('=');
+
+		if (eq_pos != std::string_view::npos) {
+			func(value.substr(0, eq_pos), value.substr(eq_pos + 1));
+		} else {
+			func(value, {});
+		}
+	}
+}
+
+} // namespace scales
@@ -0,0 +1,339 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/gzip.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+namespace scales {
+
+static constexpr std::array<uint32_t,256> crc32_table = [] {
+	std::array<uint32_t,256> table{};
+
+	for (uint32_t i = 0; i < table.size(); i++) {
+		uint32_t crc = i;
+
+		for (int j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+
+		table[i] = crc;
+	}
+
+	return table;
+}();
+
+static constexpr uint16_t length_base[] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static constexpr uint8_t length_extra[] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static constexpr uint16_t distance_base[] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+static constexpr uint8_t distance_extra[] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static_assert(GzipEncoder::WINDOW_SIZE <= 32768);
+
+GzipEncoder::GzipEncoder(output_function output) {
+	reset(std::move(output));
+}
+
+void GzipEncoder::reset(output_function output) {
+	static constexpr uint8_t header[] = {
+		0x1F, 0x8B, /* magic */
+		0x08, /* deflate */
+		0x00, /* flags */
+		0x00, 0x00, 0x00, 0x00, /* mtime */
+		0x00, /* extra flags */
+		0x03, /* OS (Unix) */
+	};
+
+	output_ = std::move(output);
+	std::fill(std::begin(head_), std::end(head_), 0);
+	pos_ = 0;
+	end_ = 0;
+	bit_buffer_ = 0;
+	bit_count_ = 0;
+	out_len_ = 0;
+	crc_ = 0xFFFFFFFF;
+	input_bytes_ = 0;
+	output_bytes_ = 0;
+	finished_ = false;
+
+	for (auto value : header)
+		put_byte(value);
+
+	/* Everything is written as one non-final fixed Huffman block */
+	put_bits(0, 1);
+	put_bits(1, 2);
+}
+
+bool GzipEncoder::accepted(std::string_view accept_encoding) {
+	while (!accept_encoding.empty()) {
+		auto comma_pos = accept_encoding.find(',');
+		std::string_view coding = accept_encoding.substr(0, comma_pos);
+		std::string_view params;
+
+		if (comma_pos == std::string_view::npos) {
+			accept_encoding = {};
+		} else {
+			accept_encoding.remove_prefix(comma_pos + 1);
+		}
+
+		auto semicolon_pos = coding.find(';');
+		if (semicolon_pos != std::string_view::npos) {
+			params = coding.substr(semicolon_pos + 1);
+			coding = coding.substr(0, semicolon_pos);
+		}
+
+		while (!coding.empty() && coding.front() == ' ')
+			coding.remove_prefix(1);
+
+		while (!coding.empty() && coding.back() == ' ')
+			coding.remove_suffix(1);
+
+		if (coding != "gzip")
+			continue;
+
+		while (!params.empty() && params.front() == ' ')
+			params.remove_prefix(1);
+
+		/* q=0, q=0.0, q=0.00 and q=0.000 all mean not acceptable */
+		if (params.rfind("q=0", 0) == 0
+				&& params.find_first_not_of("0.", 2) == std::string_view::npos)
+			return false;
+
+		return true;
+	}
+
+	return false;
+}
+
+void GzipEncoder::write(const uint8_t *data, size_t length) {
+	if (finished_)
+		return;
+
+	input_bytes_ += length;
+
+	for (size_t i = 0; i < length; i++)
+		crc_ = crc32_table[(crc_ ^ data[i]) & 0xFF] ^ (crc_ >> 8);
+
+	while (length > 0) {
+		if (end_ == BUFFER_SIZE)
+			shift_window();
+
+		size_t available = std::min(length, BUFFER_SIZE - end_);
+
+		std::memcpy(&buffer_[end_], data, available);
+		end_ += available;
+		data += available;
+		length -= available;
+
+		compress(false);
+	}
+}
+
+void GzipEncoder::finish() {
+	if (finished_)
+		return;
+
+	compress(true);
+
+	/* End the current block and add an empty final block */
+	put_literal(256);
+	put_bits(1, 1);
+	put_bits(1, 2);
+	put_literal(256);
+
+	if (bit_count_ > 0)
+		put_bits(0, 8 - bit_count_);
+
+	uint32_t crc = ~crc_;
+
+	for (int i = 0; i < 4; i++)
+		put_byte((crc >> (i * 8)) & 0xFF);
+
+	for (int i = 0; i < 4; i++)
+		put_byte((input_bytes_ >> (i * 8)) & 0xFF);
+
+	flush_output();
+	finished_ = true;
+}
+
+void GzipEncoder::compress(bool flush) {
+	/* Keep enough lookahead for the longest match unless flushing */
+	size_t lookahead = flush ? 0 : MAX_MATCH;
+
+	while (end_ - pos_ > lookahead) {
+		size_t distance = 0;
+		unsigned int length = longest_match(pos_, distance);
+
+		if (length >= MIN_MATCH) {
+			put_match(length, distance);
+
+			for (unsigned int i = 0; i < length; i++)
+				insert(pos_++);
+		} else {
+			put_literal(buffer_[pos_]);
+			insert(pos_++);
+		}
+	}
+}
+
+void GzipEncoder::insert(size_t pos) {
+	if (pos + MIN_MATCH > end_)
+		return;
+
+	unsigned int key = hash(&buffer_[pos]);
+
+	prev_[pos] = head_[key];
+	head_[key] = pos + 1;
+}
+
+void GzipEncoder::shift_window() {
+	std::memmove(&buffer_[0], &buffer_[WINDOW_SIZE], BUFFER_SIZE - WINDOW_SIZE);
+	std::memmove(&prev_[0], &prev_[WINDOW_SIZE], (BUFFER_SIZE - WINDOW_SIZE) * sizeof(prev_[0]));
+
+	for (auto &value : head_)
+		value = value > WINDOW_SIZE ? value - WINDOW_SIZE : 0;
+
+	for (size_t i = 0; i < BUFFER_SIZE - WINDOW_SIZE; i++)
+		prev_[i] = prev_[i] > WINDOW_SIZE ? prev_[i] - WINDOW_SIZE : 0;
+
+	pos_ -= WINDOW_SIZE;
+	end_ -= WINDOW_SIZE;
+}
+
+unsigned int GzipEncoder::longest_match(size_t pos, size_t &distance) {
+	if (pos + MIN_MATCH > end_)
+		return 0;
+
+	unsigned int max_length = std::min(end_ - pos, (size_t)MAX_MATCH);
+	unsigned int best_length = 0;
+	size_t candidate = head_[hash(&buffer_[pos])];
+
+	for (unsigned int chain = 0; candidate > 0 && chain < MAX_CHAIN; chain++) {
+		size_t match = candidate - 1;
+
+		if (pos - match > WINDOW_SIZE)
+			break;
+
+		if (buffer_[match + best_length] == buffer_[pos + best_length]) {
+			unsigned int length = 0;
+
+			while (length < max_length && buffer_[match + length] == buffer_[pos + length])
+				length++;
+
+			if (length > best_length) {
+				best_length = length;
+				distance = pos - match;
+
+				if (length == max_length)
+					break;
+			}
+		}
+
+		candidate = prev_[match];
+	}
+
+	return best_length;
+}
+
+void GzipEncoder::put_bits(uint32_t value, unsigned int bits) {
+	bit_buffer_ |= value << bit_count_;
+	bit_count_ += bits;
+
+	while (bit_count_ >= 8) {
+		put_byte(bit_buffer_ & 0xFF);
+		bit_buffer_ >>= 8;
+		bit_count_ -= 8;
+	}
+}
+
+void GzipEncoder::put_huffman(uint32_t code, unsigned int bits) {
+	uint32_t reversed = 0;
+
+	for (unsigned int i = 0; i < bits; i++) {
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+
+	put_bits(reversed, bits);
+}
+
+void GzipEncoder::put_literal(unsigned int literal) {
+	if (literal <= 143) {
+		put_huffman(0x30 + literal, 8);
+	} else if (literal <= 255) {
+		put_huffman(0x190 + literal - 144, 9);
+	} else if (literal <= 279) {
+		put_huffman(literal - 256, 7);
+	} else {
+		put_huffman(0xC0 + literal - 280, 8);
+	}
+}
+
+void GzipEncoder::put_match(unsigned int length, unsigned int distance) {
+	unsigned int code = sizeof(length_base) / sizeof(length_base[0]) - 1;
+
+	while (length_base[code] > length)
+		code--;
+
+	put_literal(257 + code);
+	put_bits(length - length_base[code], length_extra[code]);
+
+	code = sizeof(distance_base) / sizeof(distance_base[0]) - 1;
+
+	while (distance_base[code] > distance)
+		code--;
+
+	put_huffman(code, 5);
+	put_bits(distance - distance_base[code], distance_extra[code]);
+}
+
+void GzipEncoder::put_byte(uint8_t value) {
+	out_[out_len_++] = value;
+
+	if (out_len_ == OUTPUT_SIZE)
+		flush_output();
+}
+
+void GzipEncoder::flush_output() {
+	if (out_len_ > 0) {
+		output_(out_, out_len_);
+		output_bytes_ += out_len_;
+		out_len_ = 0;
+	}
+}
+
+} // namespace scales
@@ -0,0 +1,3 @@
+#pragma once
+#include <string_view>
+constexpr std::string_view htdocs_files_xml_gz{"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xA5\x56\xCB\x6E\xE3\x36\x14\x5D\x4B\x5F\x71\x47\xAB\x04\xB0\xC2\x78\x06\x83\x36\x1E\xD9\x53\x37\xCD\x0B\x48\x93\xC0\x76\x30\x93\x25\x2D\xD1\x16\x31\x94\x28\x90\x94\x1F\x18\x14\xE8\x1F\x14\x5D\x75\xD9\x5F\x68\x77\x5D\xF7\x57\xFA\x01\xED\x27\xF4\x52\x2F\xCB\x89\xF3\xC0\xCC\x8E\x12\x79\xCF\x3D\xF7\x9C\x7B\x29\x05\xEF\x57\x89\x80\x05\x53\x9A\xCB\xB4\xEF\x75\x0F\x0E\x3D\x60\x69\x28\x23\x9E\xCE\xFB\xDE\xED\xE4\xD4\xFF\xD6\x7B\x3F\x70\x83\x57\xBE\xEF\x3A\xF1\xEA\x9B\x6E\xD7\x5F\x32\x3E\x8F\x7D\x1D\x52\xC1\xB4\x2F\xE4\x7C\xCE\x14\xF8\x70\xFE\x11\xF7\xA0\xD8\x83\x72\x0F\x22\x6A\x28\x94\x07\x5C\xE7\x58\x66\x6B\x85\x9B\x06\x5E\x1F\xBE\x7E\x0B\x30\xE6\x89\x4C\x61\xA8\x84\x34\xC6\x75\x9D\x49\xCC\x35\x64\x4A\xCE\x15\x4D\x00\x97\x33\xC5\x18\x68\x39\x33\x4B\xAA\x58\x0F\xD6\x32\x87\x90\xA6\xA0\x58\xC4\xB5\x51\x7C\x9A\x1B\x06\xDC\x00\x4D\x23\x22\x15\x24\xC8\x77\xB6\x76\x1D\x7C\x93\xA7\x11\xF2\x31\x31\x03\xC3\x54\xA2\x41\xCE\x8A\x87\xB3\xAB\x5B\x18\xCE\x66\x4C\x49\x38\x63\x29\x53\x54\xC0\x4D\x3E\x15\x3C\x84\x4B\x1E\xB2\x54\x33\xA0\x98\xDF\xBE\xD1\x31\x8B\x60\x8A\x60\x36\xEC\xD4\xD2\x18\x57\x34\xE0\x54\x22\x3A\x35\xA8\x54\x07\x18\xC7\x7D\x55\x2B\x07\x6F\xEA\x44\x15\x5C\x07\x24\x16\xBD\x47\x8D\xA5\xAE\x40\x66\x36\x6A\x1F\xF9\xAE\x41\x50\xB3\x09\x3C\xD8\x51\xFB\xA6\xC4\x08\x78\x5A\xA0\xC6\x32\xC3\x82\x62\x84\xC3\x12\x97\x5C\x08\x98\x32\xC8\x35\x9B\xE5\xA2\xE3\x3A\x78\x14\x3E\x5C\x4C\xCE\xAF\x6F\x27\x30\xBC\xBA\x83\x0F\xC3\xD1\x68\x78\x35\xB9\x7B\x87\x47\x4D\x2C\x71\x97\x2D\x58\x09\xC4\x93\x4C\x70\xC4\xC5\x7A\x14\x4D\xCD\x1A\x69\xBB\xCE\x8F\x27\xA3\xE3\x73\x0C\x18\x7E\x7F\x71\x79\x31\xB9\x43\xEA\x70\x7A\x31\xB9\x3A\x19\x8F\xE1\xF4\x7A\x04\x43\xB8\x19\x8E\x26\x17\xC7\xB7\x97\xC3\x11\xDC\xDC\x8E\x6E\xAE\xC7\x27\x07\xE8\x20\xB3\x94\x98\xEB\x3C\xAF\xED\xAC\xF0\x08\x15\x8C\x98\xA1\x5C\x68\x5B\xF5\x1D\x5A\xAA\x91\x9C\x88\x20\xA6\x0B\x86\xD6\x86\x8C\x2F\x90\x1A\x85\x10\x7B\xE5\xC5\xC6\xB9\x0E\x15\x32\x9D\x17\xA5\x62\xC4\x46\x4A\xA4\x78\x31\x83\x54\x9A\x0E\x68\xA4\x1A\xC4\xC6\x64\x3D\x42\x96\xCB\xE5\xC1\x3C\xCD\x0F\xA4\x9A\x13\x51\x42\x68\x32\x38\x70\x7D\x1F\xDB\x7C\xA5\x45\x4F\x9B\x35\x76\x6F\xCC\x98\x01\x9C\x8D\x54\xF7\xF0\x65\xDF\x6B\x45\x2F\xDF\x14\xC1\xDD\xA3\xA3\x23\xF2\x71\x7C\x49\x26\xA8\xA4\xC6\x12\x13\x6F\x7B\x90\x06\xAE\x53\x00\xA2\x01\x19\x7A\x90\x30\xF4\x22\xB2\x48\x89\x68\x9D\x7C\xBB\x6B\xE4\xD0\xF7\x88\xA5\xA6\xEF\xAD\x99\xF6\xC8\xC0\xAD\x90\x0C\x43\xFB\xB0\x7D\x20\xA1\x26\x8C\xFB\x1E\x51\x36\x89\x13\x58\x48\xBB\xC0\x15\xA3\x51\xB1\x72\x02\xCC\x47\x21\xA5\x09\xEB\x7B\x0B\xCE\x96\x99\x54\xC6\x43\x69\x53\x53\x00\x2F\x79\x64\xE2\x7E\xC4\x16\x28\x81\x5F\x3C\x74\x30\x29\x37\x9C\x8A\x72\xB6\xFB\x5D\x9B\xB8\x40\x2A\x14\x01\xB3\xCE\x10\xCA\xB0\x95\x21\xA1\xD6\x5E\xB9\xE7\xE4\x02\x3E\x97\x2B\x27\xA1\x6A\xCE\xD3\x1E\x1C\xBE\xAB\x5E\x64\x34\xB2\x45\xB5\xDE\xE0\x78\x19\xBF\x80\xF3\x2D\x5C\x0F\xED\x49\x59\xB5\xF9\x53\x99\x8C\x14\xDB\x55\x66\xC1\xD3\x4F\xD8\x19\xA8\x3F\x47\xE6\x1E\xC4\x8A\xCD\xFA\x9E\xBD\x58\x7A\x9D\x8A\x5E\x40\x9A\x9A\x83\xA9\x8C\xD6\x55\x24\x1A\x8B\x63\x56\x91\x0C\xAC\x3B\x8D\x01\x67\x27\x13\x0F\x68\x68\x0A\xF9\x09\x55\x61\x8C\x7D\x57\xD7\xE3\x04\xB9\xA8\x97\xA5\xE8\x34\xCB\xC4\xDA\xAF\xA5\xD7\xD8\x4C\x82\x85\xA8\xE0\xCC\xB3\xF7\x0E\xAB\x0C\x25\x4D\x3C\xB1\x00\xF5\x43\x06\xA1\xA0\x5A\xF7\xBD\x32\x8A\x45\xDE\x06\x9C\xA7\xB6\x2D\x4A\x59\x75\x3E\x4D\x38\xFA\xB3\xA0\x22\xC7\xC7\x1F\xE4\x32\x15\x92\x46\xD0\x84\x91\x6D\x52\xD6\x86\x01\x04\xA4\x59\xBF\x08\x15\xC1\xB0\x79\x1A\xCC\x3A\xC6\xB1\xF2\xD4\xEA\xE0\x74\xA3\x3C\xF6\x4D\x23\x51\x54\xC4\x6D\x1F\xC7\x8E\x2D\x73\x58\x79\x78\x58\xDC\x8A\x64\xE5\xE3\x7C\xF8\x76\xDB\xCF\x95\x28\x9A\xBA\x4D\x3D\x20\x59\x6D\x08\xB1\x87\x6A\x99\x36\x2A\x35\x66\x04\xB4\xF2\x7A\xE3\x4F\xA3\x09\x15\x22\x20\x74\xD0\x42\xDB\xA8\x6C\xA8\xC9\x75\x3B\xDC\x1B\x8C\x8B\x77\x5B\x11\x01\x69\xB5\x47\x40\xEA\xB6\xC1\x56\x2A\x07\xA9\xD6\xB5\xB4\xFC\x89\xF1\x23\xDB\x4D\x50\x80\x08\x5E\xC2\xB6\x8D\x08\x63\x16\x7E\x9A\xCA\x95\x57\x0D\xE4\xAC\x6A\x83\xB2\xC1\x4C\xFD\x45\xAB\xA6\xD5\xBA\x85\x35\xD8\xBD\x62\xED\xE3\x5D\x58\x77\xDD\x77\x29\xEA\x59\xF2\x6B\xE2\xAA\x32\x8A\x84\xE5\xFA\xD1\x16\x09\xE8\x13\x89\xAD\x64\x75\x7F\x92\xA8\x92\x9B\x3C\xC1\xA3\x12\xF3\x21\x19\x67\x77\x90\xA5\xB1\xB7\xDF\x0C\x2E\xDD\x90\xE5\x78\xDB\x33\x6D\x71\x93\xB6\x34\x65\x0D\x7B\xF8\x15\x4C\x18\x7E\x40\xD6\xFB\xF7\xCB\x21\x65\xF0\x2E\xA0\x7C\x07\x50\x9E\xD9\x92\x58\xF4\x3C\xCE\x57\xAA\xA7\x33\x2C\x58\xE5\xC9\x97\xA9\xF7\xCF\xCF\x7F\xFC\xFB\xD7\x2F\x0F\x44\xFA\x5A\x47\x8B\x31\xFE\x32\x46\xFF\xFD\xFE\xDB\xAF\xBB\x28\x6D\xE4\x0E\x6B\xB9\xA7\xAA\xF9\x6E\x24\x38\xAA\xF5\x8C\xEE\xCE\x1A\x36\xB7\x43\xAB\x42\x85\x17\x3A\x7E\x37\xF4\x83\xEB\xED\x5E\x4A\xBA\xB9\xB4\x9B\x83\x9D\x1D\x97\xE2\x23\xB9\x69\xEB\x66\xDA\x24\xFF\xFB\xCF\x97\x23\xE8\x9D\x08\x7B\x2F\x8E\x17\x3B\xE3\x8D\x7C\x39\x83\x78\x17\xC2\xFE\x43\xE1\xDA\xFD\xFD\x8C\x5C\x8F\x64\x32\xBB\x9C\x32\xF8\x5B\xFC\x9C\x4B\x06\x5E\xF5\xA1\xEB\x0D\xF4\x36\x09\xFC\xD0\x37\xED\xD1\xDE\x09\x48\x71\x81\xDE\xBF\x82\xCB\xE7\xCD\xBF\xD9\xC0\xFD\x1F\x1A\x1B\x4B\xBF\xBB\x0C\x00\x00", 1253};
@@ -0,0 +1,3 @@
+#pragma once
+#include <string_view>
+constexpr std::string_view htdocs_spectrum_xml_gz{"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xBD\x56\xDB\x6E\xDB\x46\x10\x7D\x26\xBF\x62\x4A\x20\x85\x5D\x88\xA2\x94\xC0\x4D\xA3\x50\x4A\x54\xC3\x8E\x0D\xB8\xB6\x21\xCB\x48\xFC\xB8\x22\x87\xE2\xC2\x4B\x2E\xB1\xBB\x12\xAD\x14\xFD\xF7\xCE\x2E\x49\xD9\xAA\x2F\x71\x5E\xFA\x24\x72\x76\xE6\xEC\x99\xDB\xA1\xE2\x4F\x77\x85\x80\x35\x2A\xCD\x65\x39\x0E\x86\xFD\x41\x00\x58\x26\x32\xE5\xE5\x72\x1C\x5C\xCF\x8F\xC3\x3F\x82\x4F\x13\x3F\xFE\x25\x0C\x7D\x2F\xBF\x7B\x3F\x1C\x86\x35\xF2\x65\x1E\xEA\x84\x09\xD4\xA1\x90\xCB\x25\x2A\x08\xE1\xE4\x1B\x9D\x81\x3B\x83\xE6\x0C\x52\x66\x18\x34\x0E\xBE\x77\x28\xAB\x8D\xA2\x43\x03\x6F\x07\x6F\x0F\x00\xAE\x78\x21\x4B\x98\x2A\x21\x8D\xF1\x7D\x6F\x9E\x73\x0D\x95\x92\x4B\xC5\x0A\xA0\xC7\x4C\x21\x82\x96\x99\xA9\x99\xC2\x11\x6C\xE4\x0A\x12\x56\x82\xC2\x94\x6B\xA3\xF8\x62\x65\x10\xB8\x01\x56\xA6\x91\x54\x50\x10\xDF\x6C\xE3\x7B\x64\x59\x95\x29\xF1\x31\x39\x82\x41\x55\x68\x90\x99\x7B\xF9\x72\x7E\x0D\xD3\x2C\x43\x25\xE1\x0B\x96\xA8\x98\x80\xCB\xD5\x42\xF0\x04\xCE\x78\x82\xA5\x46\x60\x74\xBF\xB5\xE8\x1C\x53\x58\x10\x98\x0D\x3B\xB6\x34\xAE\x5A\x1A\x70\x2C\x09\x9D\x19\xAA\x54\x0F\x90\xD3\xB9\xEA\x2A\x07\xEF\xBA\x8B\x5A\xB8\x1E\x48\x4A\x7A\x8F\x19\x4B\x5D\x81\xAC\x6C\xD4\x3E\xF1\xDD\x80\x60\xE6\x3E\xB0\xFF\x44\xEE\xF7\x29\xA6\xC0\x4B\x87\x9A\xCB\x8A\x12\xCA\x09\x8E\x52\xAC\xB9\x10\xB0\x40\x58\x69\xCC\x56\xA2\xE7\x7B\xE4\x0A\x5F\x4F\xE7\x27\x17\xD7\x73\x98\x9E\xDF\xC0\xD7\xE9\x6C\x36\x3D\x9F\xDF\x7C\x24\x57\x93\x4B\x3A\xC5\x35\x36\x40\xBC\xA8\x04\x27\x5C\xCA\x47\xB1\xD2\x6C\x88\xB6\xEF\xFD\x75\x34\x3B\x3C\xA1\x80\xE9\x9F\xA7\x67\xA7\xF3\x1B\xA2\x0E\xC7\xA7\xF3\xF3\xA3\xAB\x2B\x38\xBE\x98\xC1\x14\x2E\xA7\xB3\xF9\xE9\xE1\xF5\xD9\x74\x06\x97\xD7\xB3\xCB\x8B\xAB\xA3\x3E\x75\x10\x2D\x25\xF4\xBD\x1F\xD7\x36\x73\x3D\xA2\x0A\xA6\x68\x18\x17\xDA\x66\x7D\x43\x2D\xD5\x44\x4E\xA4\x90\xB3\x35\x52\x6B\x13\xE4\x6B\xA2\xC6\x20\xA1\x59\x79\x75\xE3\x7C\x8F\x09\x59\x2E\x5D\xAA\x14\x71\x5F\x4A\xA2\x78\x9A\x41\x29\x4D\x0F\x34\x51\x8D\x73\x63\xAA\x51\x14\xD5\x75\xDD\x5F\x96\xAB\xBE\x54\xCB\x48\x34\x10\x3A\x9A\xF4\xFD\x30\xA4\x31\xBF\xD3\x62\xA4\xCD\x86\xA6\x37\x47\x34\x40\xBB\x51\xEA\x11\x19\xC7\xC1\x83\xE8\xFA\x9D\x0B\x1E\x7E\xF8\xF0\x21\xFA\x76\x75\x16\xCD\xA9\x92\x9A\x52\x2C\x82\xDD\x45\x9A\xF8\x9E\x03\xA4\x06\x54\xD4\x83\x02\xA9\x17\xA9\x45\x2A\xC4\x03\xCF\x83\xA7\x56\x8E\xFA\x9E\x62\x69\xC6\xC1\x06\x75\x10\x4D\xFC\x16\xC9\x20\xB5\x8F\xC6\x07\x0A\x66\x92\x7C\x1C\x44\xCA\x5E\xE2\xC5\x16\xD2\x3E\xD0\x13\xB2\xD4\x3D\x79\x31\xDD\xC7\xA0\x64\x05\x8E\x83\x35\xC7\xBA\x92\xCA\x04\x54\xDA\xD2\x38\xE0\x9A\xA7\x26\x1F\xA7\xB8\xA6\x12\x84\xEE\xA5\x47\x97\x72\xC3\x99\x68\x76\x7B\x3C\xB4\x17\x3B\x24\x57\x11\x30\x9B\x8A\xA0\x0C\xDE\x99\x28\xD1\x3A\x68\xCE\x3C\xC3\x16\x74\xF6\x77\xF3\xE2\x2D\xA4\xA2\xF5\x0B\x13\x29\x04\xAB\x34\x2D\x6E\xF7\xF4\xB1\x71\xF8\xA7\x0D\x4A\x7B\xD4\xAA\x6D\x54\xC5\x52\x9B\xFC\x08\x06\x30\xE8\x1F\x60\xD1\x3A\x7B\xF6\xAE\x90\x09\xBE\x2C\x47\xE0\xB4\xE3\xBF\x28\xFD\x05\x53\x5B\x14\x97\xC4\x08\x0E\x06\xEB\xFA\x29\x00\x81\xD9\xD3\xF1\xBA\x22\x61\xE9\x40\x68\xF7\xA8\xC2\x9B\x11\xD5\x42\xF0\x12\xC3\x85\x90\xC9\x6D\x07\x97\x5B\x75\x33\x44\xB3\xFF\xFE\x01\xCB\x05\x4B\x6E\x97\xCA\x4A\x83\xCD\x5B\xAA\x11\xE4\x5A\xEC\xBD\x1D\x0E\x7A\x30\x1C\x0C\xDE\xF4\xE0\xF7\x83\x37\xFB\x3B\x37\xC7\x91\xAB\x68\x5B\x5D\xBA\xE7\x96\xA6\x9F\x66\x8C\x53\x77\x02\xC8\x15\x66\xE3\xC0\x8A\xE7\xA8\xD7\xB6\x20\x8E\xB6\x7D\x8D\x17\x32\xDD\xB4\x91\x34\xBC\x24\x25\x6D\x23\xE2\x0A\x12\xC1\xB4\x1E\x07\x19\x17\xD8\xB5\xA7\x99\x9B\x24\x97\x52\x63\x67\x6A\x6C\x75\x6E\x25\x01\x35\xCD\xC2\x67\x13\x4C\x9C\x6D\xCD\xC4\x0A\x43\xDA\x3C\x8D\x02\x93\xE6\x24\x9A\xC4\x51\xE7\xBF\x8B\x20\xAD\x02\xD6\x9C\x80\x0F\x57\x4A\x11\x17\xBB\xC3\x34\x00\xD4\xCA\x26\xE4\xDE\xA1\x23\x13\x3D\x66\x13\x2F\x54\xB4\x43\xF6\x31\x89\x84\x48\x10\x36\xB3\xC8\x1A\x48\x04\x9F\xF1\xCB\xC9\xEF\xE4\x7B\xEF\x65\xB0\xDA\x82\x69\x5C\x16\x44\xD8\x7D\x1E\x9E\xF1\x5B\x38\xB0\xB6\xB6\x51\x65\x77\xD0\x3D\x36\x03\xDF\x96\xBA\x42\x76\xAB\xEF\x6B\x6D\xD4\x24\x36\xF9\xE4\x92\xAC\xB0\x77\xF2\x7D\x3F\x8E\xE8\xCD\x5A\xA6\x56\x76\xCD\x2A\xC5\xC6\x12\x19\xB5\x93\x32\xAB\x2A\xB1\x09\xBB\xED\xD6\x5B\x12\x55\x60\x3F\x6D\xD8\x6A\x46\x57\x26\x0A\xB7\x1C\xB6\x8C\x5C\x01\x9F\x62\xA7\x2B\x42\x51\xAB\xE2\x11\xC1\x93\xEF\xCF\x31\x33\x79\xF4\x7A\x7A\xC5\xAB\xE8\xED\xCC\x25\x15\x2B\x66\xED\x88\x47\xAD\xE1\xD8\xFE\xC4\x11\x9B\xB8\x32\x37\x10\x0F\x46\x3B\x8E\xBA\x91\xA7\x35\x68\x84\xAE\x99\xA3\x8E\xD0\x0B\xF2\x18\xED\x56\xD0\x81\xB4\xC9\xC5\x26\x7D\x6E\xE8\x33\x37\xF4\x26\xFD\x91\x1F\x7B\xE0\xD7\x16\xED\xF5\xCC\x8A\xFF\x8B\x99\xF5\xEB\x5A\x40\x7A\x17\x74\xA2\x4E\xB2\xD7\x75\xCC\x35\xD9\x74\xFF\xAB\x9A\x6F\x86\x93\xA8\x5D\x19\xB1\x72\x3A\x69\x65\xB6\x4B\x94\x2C\x3F\xA1\x34\x94\xF7\xE7\x3B\xF8\x75\x69\x3E\xC2\x60\x8B\xFD\xDC\xAA\x3A\x4D\xDD\xFB\xCC\xE0\x37\x2B\xA4\xF4\xB7\x68\x0D\x2E\x7E\x7F\x3B\x6A\x9D\xA2\xBC\xA4\x4D\x83\x9F\xD1\xA2\x6D\x4E\x6F\x1E\xE5\xD7\x18\xB6\x55\xEA\x06\x75\x5B\xC6\x1F\x0C\x42\xF3\x7E\xFF\xDF\x62\xE2\xFF\x0B\x0D\x86\x7A\xB9\x7B\x0B\x00\x00", 1234};
@@ -0,0 +1,3 @@
+#pragma once
+#include <string_view>
+constexpr std::string_view htdocs_status_xml_gz{"\x1F\x8B\x08\x00\x00\x00\x00\x00\x02\x03\xC5\x58\x5B\x6F\xDB\x36\x14\x7E\xB6\x7F\xC5\x99\x8A\x0E\x09\x66\x5B\x76\x8A\x6C\xA9\x6B\x7B\xF1\x8A\xA6\x0D\xD0\xA5\x41\xE2\xA0\xED\x23\x2D\xD1\x16\x11\x4A\x14\x44\xDA\x8E\x3B\xEC\xBF\xEF\x90\xD4\xCD\xB2\x7C\x49\x31\xB4\x29\x50\x4B\xBC\x9C\xF3\x9D\xEF\xDC\x48\x0D\xFE\x7C\x0A\x39\x2C\x69\x22\x99\x88\x86\x4E\xAF\xD3\x75\x80\x46\x9E\xF0\x59\x34\x1F\x3A\x0F\x93\xAB\xF6\x85\xF3\xE7\xA8\x39\xF8\xA5\xDD\x6E\x36\x82\xA7\x3F\x7A\xBD\xF6\x8A\xB2\x79\xD0\x96\x1E\xE1\x54\xB6\xB9\x98\xCF\x69\x02\x6D\xF8\xF0\x05\xE7\xC0\xCC\x81\x9D\x03\x9F\x28\x02\x76\x41\xB3\xF1\x56\xC4\xEB\x04\x27\x15\x9C\x75\xCF\xCE\x01\xEE\x59\x28\x22\x18\x27\x5C\x28\xD5\x6C\x36\x26\x01\x93\x10\x27\x62\x9E\x90\x10\xF0\x71\x96\x50\x0A\x52\xCC\xD4\x8A\x24\xB4\x0F\x6B\xB1\x00\x8F\x44\x90\x50\x9F\x49\x95\xB0\xE9\x42\x51\x60\x0A\x48\xE4\xBB\x22\x81\x10\xF1\xCE\xD6\xCD\x06\x8E\x2C\x22\x1F\xF1\xA8\x80\x82\xA2\x49\x28\x41\xCC\xCC\xCB\xFB\x9B\x07\x18\xCF\x66\x34\x11\xF0\x9E\x46\x34\x21\x1C\x6E\x17\x53\xCE\x3C\xF8\xC8\x3C\x1A\x49\x0A\x04\xF5\xEB\x11\x19\x50\x1F\xA6\x28\x4C\x6F\xBB\xD2\x30\xEE\x53\x18\x70\x25\x50\x3A\x51\xC8\x54\x0B\x28\xC3\xF9\x24\x63\x0E\x5E\x65\x8A\x52\x71\x2D\x10\x68\xF4\x09\x51\x1A\x7A\x02\x22\xD6\xBB\x4E\x11\xEF\x1A\x38\x51\xC5\xC6\x4E\x8D\xED\x85\x89\x3E\xB0\xC8\x48\x0D\x44\x8C\x06\x05\x28\x0E\x4D\x5C\x31\xCE\x61\x4A\x61\x21\xE9\x6C\xC1\x5B\xCD\x06\x2E\x85\xCF\xD7\x93\x0F\x9F\x1E\x26\x30\xBE\xF9\x0A\x9F\xC7\x77\x77\xE3\x9B\xC9\xD7\x37\xB8\x54\x05\x02\x67\xE9\x92\x5A\x41\x2C\x8C\x39\x43\xB9\x68\x4F\x42\x22\xB5\x46\xD8\xCD\xC6\xDF\xEF\xEE\xDE\x7E\xC0\x0D\xE3\xBF\xAE\x3F\x5E\x4F\xBE\x22\x74\xB8\xBA\x9E\xDC\xBC\xBB\xBF\x87\xAB\x4F\x77\x30\x86\xDB\xF1\xDD\xE4\xFA\xED\xC3\xC7\xF1\x1D\xDC\x3E\xDC\xDD\x7E\xBA\x7F\xD7\x41\x0F\x52\x0D\x89\x36\x1B\x87\xB9\x9D\x19\x1F\x21\x83\x3E\x55\x84\x71\xA9\xAD\xFE\x8A\x2E\x95\x08\x8E\xFB\x10\x90\x25\x45\xD7\x7A\x94\x2D\x11\x1A\x01\x0F\x63\xE5\x68\xC7\x35\x1B\x84\x8B\x68\x6E\x4C\xC5\x1D\x05\x95\x08\xF1\x7A\x06\x91\x50\x2D\x90\x08\x75\x10\x28\x15\xF7\x5D\x77\xB5\x5A\x75\xE6\xD1\xA2\x23\x92\xB9\xCB\xAD\x08\xE9\x8E\x3A\xCD\x76\x1B\xC3\xFC\x49\xF2\xBE\x54\x6B\x8C\xDE\x80\x52\x05\x98\x1B\x91\xEC\xE3\xE0\xD0\x29\xED\x5E\xBD\x32\x9B\x7B\xAF\x5F\xBF\x76\xBF\xDC\x7F\x74\x27\xC8\xA4\x44\x13\x43\x67\x33\x91\x46\xCD\x86\x11\x88\x0E\x88\xD1\x07\x21\x45\x5F\xF8\x5A\x52\xC8\x4B\x2B\xCF\xEB\x52\x0E\xFD\xEE\xD3\x48\x0D\x9D\x35\x95\x8E\x3B\x6A\xA6\x92\x14\x45\xF7\x61\xF8\x40\x48\x94\x17\x0C\x1D\x37\xD1\x4A\x1A\x03\x2D\x52\x3F\xE0\x13\x25\xBE\x79\x6A\x0C\x50\x1F\x81\x88\x84\x74\xE8\x2C\x19\x5D\xC5\x22\x51\x0E\x52\x1B\x29\x23\x78\xC5\x7C\x15\x0C\x7D\xBA\x44\x0A\xDA\xE6\xA5\x85\x4A\x99\x62\x84\xDB\xDC\x1E\xF6\xB4\x62\x23\xC9\x30\x02\x6A\x1D\xA3\x28\x45\x9F\x94\xEB\x49\xE9\xD8\xB9\x86\x56\xDD\x82\xA9\xF0\xD7\x2D\xED\xE6\x10\xFE\xB1\xE3\x8D\x90\x24\x73\x16\xF5\xA1\x47\x43\xE8\xEA\x7F\x6F\xD2\x89\x98\xF8\xDA\xD4\x7E\x3E\xF2\xAF\xFD\x61\x91\x66\xE9\xF8\xED\x67\x66\xC6\xFC\x9F\xCD\x19\x3B\xFA\x70\xDE\x7D\x99\x8D\x4C\x45\x82\xF5\xA0\x8F\x61\x10\xD1\xCD\xB1\xF6\x14\x2B\x8F\x08\x51\x4E\xFC\x84\x95\x86\x33\x1F\x5E\x5C\x99\xBF\x6C\xDD\x0C\xB9\xB2\xD5\x4E\xF5\xD1\x42\xEE\x67\x13\x9E\xE0\x02\x65\xBE\xE8\x9A\xBF\x7C\x74\x91\x48\x3D\x1C\x0B\x86\x1C\x27\x35\xC6\xF5\x03\x81\x6E\xCF\x4D\xD4\x54\xB6\x7D\xEA\x89\xC4\xD4\x94\x3E\xF8\x88\x08\x13\xC0\x94\x30\xCE\x72\xC0\x65\x11\x1D\xA9\x48\x52\xB0\x94\x99\xA7\x59\xB2\x36\x04\x92\x9F\x9C\xF5\xBA\x2D\xE8\x75\xBB\x2F\x5B\xF0\xFB\xF9\xCB\xD3\xDC\x6E\xE2\x3D\xCE\x13\x5D\xC3\xDA\xA9\x05\xBB\x17\xA7\x3A\xB5\x5F\x3B\xC9\x22\x8A\x90\x71\xA8\x05\xB0\x25\xF3\xC5\x6C\x36\xAB\x03\xAE\x74\x05\x3D\x80\xFB\xD5\x33\x60\xBF\x3A\x80\xDA\xE8\xAB\x53\x7D\x34\x62\xA9\x44\x7C\x00\xF1\x91\x3C\x6F\x6B\xA8\x25\xB6\xAC\xAE\xD6\xE8\x3D\x9E\xB2\x01\x46\x3C\x85\x35\xF4\xB0\x14\x2D\x03\xB3\x24\x87\xBC\x15\x8A\x2B\xB2\x5C\xEF\x0A\xC4\xCE\x92\xF0\x45\xA1\x64\x57\x9A\xA4\xAB\x15\x99\x72\xDA\xD1\x0D\x48\xC9\xC3\xD9\x9D\xE6\x26\xA2\xE5\x24\x96\xD8\xF9\xB3\xA7\x3D\x42\x95\x9F\xCB\x2D\x6A\x0B\x74\x3B\xE7\x34\xDC\xB0\x8F\x70\x36\x47\x9D\xE6\x14\xB2\x29\x4E\xC6\x24\xDA\x8C\x12\xEC\xC1\x58\x69\xD7\x7D\xF4\x8D\x26\xA0\x3D\xE5\xC2\x7B\x7C\x03\x19\xEE\x6E\xE7\x4C\x4B\x87\x42\x9F\x1D\xA8\x04\x8B\x1D\xCD\xF2\xFA\x80\x07\x8B\xA8\xDD\x86\x53\x11\x58\x04\xE0\xEB\xDD\x02\x07\xAE\xA9\xDB\x69\x0D\x47\x2B\x1E\xB1\xC7\x62\x27\x63\xD8\x03\x1C\x08\x12\x3A\x1B\x3A\xFA\x88\xD6\x6F\xA5\x85\x7E\xE0\xE6\xDD\x63\xA0\xC1\xA4\x3B\x75\xE3\x21\x2A\x3B\x74\xD9\x86\xE2\x71\x52\xB4\x00\xB3\x82\x61\xBB\xA6\x12\x1B\x8B\x74\x89\x33\x4A\x23\x7B\xE0\xDA\xA9\xF2\x42\xED\x8A\x11\xD8\x19\xF3\x5C\x2F\xE4\x9B\x33\xD2\x0C\x6C\x4A\xB0\x6F\x39\x98\x74\x10\x7B\x38\xD6\xDB\xB2\x1C\x12\xC7\x7C\xDD\xCE\xBA\xA5\xC4\xFE\xCF\xA9\x87\x62\x97\x8E\x3E\x2A\xD2\xB4\x07\xBB\xC7\x6C\x91\xCF\xDF\x12\xED\xDE\x92\x1B\x48\x33\xF2\x1A\x03\x13\xCB\x60\x18\xC5\x71\x13\xD2\xF9\xE4\x7E\x45\xB4\x56\x11\xB2\x64\x44\x66\x7A\x73\x06\xD3\x77\xD3\xA5\xB3\xC3\x08\x9E\xE5\x26\x0E\xE8\xB2\xA1\xCF\x22\xAE\x7D\x28\xB0\xD9\x9E\x6C\x3B\x7F\xC0\x7C\x3C\x93\x38\x69\x04\x54\x56\xD6\x87\x89\x29\x14\xCE\xC8\xB4\x8C\x5A\xDF\x69\x78\x46\x47\xAD\x46\xB9\x98\x86\x4C\x1D\xD0\x91\x86\xE2\x3E\x1D\x7B\xC1\xDD\x1F\x0D\x6E\xE0\x6A\xEA\x7E\x22\x8F\x45\x42\x7C\x0F\x8D\xCF\x51\x98\x92\xBA\x47\xE1\x5E\xA0\x93\x63\x81\xFE\x74\x4A\x75\xD3\xFD\xA1\x94\xEE\x51\x78\x20\x4C\x8F\x04\x5A\xA1\x74\x5F\xFD\x08\xAA\xF5\x23\xDD\x13\x67\xD5\x68\xC6\xF0\x26\x54\x50\x4E\xD2\xAE\xE1\xA6\xE3\x57\xFA\x67\xE0\x92\x7C\xC1\x76\x23\xD8\x30\x6D\x47\xE9\x2F\x4B\x96\x31\x22\x4B\x16\xA1\x8B\x16\xA7\x8F\x65\x05\x95\x7E\xE2\xC6\x59\x5F\x28\xF5\x80\x81\x9B\x35\x2F\x6C\x68\xF6\x62\x94\xA9\xB4\x04\xEC\xB9\x4E\xB9\x9B\x1D\xC2\x08\xB1\x3A\xF6\xF9\xD4\xB8\xA8\xCE\x39\x66\x93\x99\x6D\xE3\x75\x36\xA3\x5D\x9B\x7E\x72\x6A\xEB\xB5\x35\xE1\x78\x7C\xC1\x36\x3E\xBD\xD2\x0B\x84\x90\x25\x9D\xAB\x40\xDF\xF7\x8D\x1B\x2E\xA5\xFE\x4A\xA2\xEF\xC1\x27\xB8\x1F\x9D\x72\x9A\x7A\xE5\x19\xD9\x76\x7C\xB2\xED\x0B\x61\x3C\x5B\xEE\xA8\x0A\x95\x08\xB6\x44\xA5\x9B\xF5\xAE\x42\xBC\xFD\x90\x02\x46\x22\xDE\xB2\xBB\x95\x08\xCB\x83\xCF\x72\x0C\x43\x28\x2F\xA9\x47\x67\xB5\x51\x1F\x73\x33\x7D\xDA\x99\x9F\x9B\xE1\x57\x8E\xEA\x5E\x77\x3B\xAC\x07\xAE\x45\xBB\x03\xFC\xC5\x61\xF0\x17\x3F\x06\xFC\xC5\x61\xF0\x78\x98\x34\xF2\xB7\x4E\x72\x1F\xBE\xD5\x9C\xE5\xEA\x4A\x65\x6A\xF5\x3D\x55\x60\x5C\x9A\x7D\x5C\x48\xCB\x55\x8E\x50\x87\x6E\x11\xC8\x42\x7F\x65\x5B\x31\x99\x9D\xF5\xF2\xD2\x64\xC3\xE2\x40\x82\x95\x61\x96\x50\x66\x75\xC3\x0E\x6D\xA8\xB0\x43\x79\x3A\x1D\x9F\x98\xF2\x7B\x0A\x87\x39\xB4\xD4\xBB\xAC\xDE\xB2\x4B\xA5\xAD\x9A\x26\x6E\xB1\xA6\x94\xFA\x5B\xB9\x5F\x9C\xC4\xF5\xB7\x99\x0A\xBF\x55\x82\x3D\x81\x46\x51\x7D\x51\x21\x33\xAC\xA5\x35\xE4\x54\xD9\xD9\x55\xD6\x77\x60\xF7\x33\xEC\x85\x01\xFA\xA6\x93\x79\x54\x1F\x36\x9C\x12\xB2\xB2\x61\x5B\x96\xA5\xD7\x03\x14\xAE\xAA\x66\x55\xED\x8A\x04\x14\xE7\x98\x6A\x3C\x6D\x19\xE4\x6A\x48\x15\x8A\xB7\x4D\xF1\xD0\x14\x77\xC7\x5C\xE8\x94\xB6\xE6\x39\x7D\xC9\xCB\xB6\x59\xCA\x4E\x0E\x73\xC6\x37\xA2\x18\x42\x16\x9D\x56\xD2\xAD\x9C\xD7\xCF\xED\x26\x51\x4D\xD0\x66\xEE\xD0\x5F\xCC\x2C\xE4\x1B\x81\x17\x47\xA2\xEF\xB9\x72\x9F\x5D\xC6\xB3\xC7\x5A\x01\x1E\x89\x89\xC7\xD4\xFA\x7F\xB4\x86\x6E\x5B\xA3\xD2\x23\x81\xF2\x47\xFB\x12\xCA\x55\xFE\xA1\x75\x8F\x47\xAE\xE3\xD5\x75\xCD\xED\xFA\x7E\xB9\xE3\xEA\x8C\xAD\xFA\xD7\xB9\x7A\x03\x58\xF5\x7F\xAB\xBB\x3A\x6F\x6B\x93\x45\x19\x2D\x2D\x3F\xA8\x3F\x74\xF6\x8B\x0D\x37\xFC\x15\xCA\x6A\x85\xAF\xD5\x86\xBF\x49\x8D\xBF\xEC\x7B\xF1\x51\x7D\xD4\xFC\x0F\xED\xA8\x35\x77\x74\x1A\x00\x00", 1854};
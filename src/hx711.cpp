@@ -21,11 +21,16 @@
 #include <Arduino.h>
 
 #include <algorithm>
-#include <cassert>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <sys/time.h>
+#include <utility>
 #include <vector>
 
 #include <CBOR.h>
@@ -37,91 +42,841 @@
 #include "app/app.h"
 #include "app/fs.h"
 #include "app/util.h"
+#include "scales/trace.h"
 
 namespace cbor = qindesign::cbor;
 using app::FS;
 
+#ifndef SCALES_BUFFER_KB
+# define SCALES_BUFFER_KB 0
+#endif
+
 static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN))) PROGMEM = "hx711";
 
 namespace scales {
 
 uuid::log::Logger HX711::logger_{FPSTR(__pstr__logger_name), uuid::log::Facility::DAEMON};
 
-HX711::HX711(int data_pin, int sck_pin)
-		: data_pin_(data_pin), sck_pin_(sck_pin),
-		buffer_(reinterpret_cast<Data*>(
-				::heap_caps_malloc(BUFFER_SIZE * sizeof(Data),
-					MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT))) {
-	assert(buffer_.get());
+/* Encodes a recording into memory, evicting older recordings if necessary */
+class EncodedPrint: public Print {
+public:
+	EncodedPrint(Session &session, std::function<bool()> evict)
+		: session_(session), evict_(std::move(evict)) {}
+
+	size_t write(uint8_t c) override {
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t *buffer, size_t size) override {
+		if (getWriteError())
+			return 0;
+
+		size_t remaining = size;
+
+		while (true) {
+			size_t appended = session_.append_encoded(buffer, remaining);
+
+			buffer += appended;
+			remaining -= appended;
+
+			if (remaining == 0)
+				return size;
+
+			if (!evict_()) {
+				setWriteError();
+				return size - remaining;
+			}
+		}
+	}
+
+private:
+	Session &session_;
+	std::function<bool()> evict_;
+};
+
+static void write_recording(cbor::Writer &writer, const Session &session) {
+	writer.writeTag(cbor::kSelfDescribeTag);
+	bool compressed = session.compression.mode != Compressor::Mode::LOSSLESS;
+
+	writer.beginMap(9 + (session.rate_hz ? 1 : 0) + (compressed ? 1 : 0)
+		+ (session.continuous ? 1 : 0));
+
+	app::write_text(writer, recording::KEY_REALTIME_S_US);
+	writer.beginArray(2);
+	writer.writeUnsignedInt(session.realtime_us.tv_sec);
+	writer.writeUnsignedInt(session.realtime_us.tv_usec);
+
+	app::write_text(writer, recording::KEY_START_US);
+	writer.writeUnsignedInt(session.start_us);
+
+	app::write_text(writer, recording::KEY_STOP_US);
+	writer.writeUnsignedInt(session.stop_us);
+
+	app::write_text(writer, recording::KEY_PERIOD_NS);
+	writer.writeUnsignedInt(session.period_ns);
+
+	app::write_text(writer, recording::KEY_JITTER_NS);
+	writer.writeUnsignedInt(session.jitter_ns);
+
+	if (session.rate_hz) {
+		app::write_text(writer, recording::KEY_RATE_HZ);
+		writer.writeUnsignedInt(session.rate_hz);
+	}
+
+	if (compressed) {
+		app::write_text(writer, recording::KEY_COMPRESSION);
+		writer.beginMap(2);
+		app::write_text(writer, recording::KEY_COMPRESSION_MODE);
+		app::write_text(writer, Compressor::mode_name(session.compression.mode));
+		app::write_text(writer, recording::KEY_COMPRESSION_TOLERANCE);
+		writer.writeUnsignedInt(session.compression.tolerance);
+	}
+
+	if (session.continuous) {
+		app::write_text(writer, recording::KEY_SEGMENT);
+		writer.beginMap(1 + (session.chain.previous.empty() ? 0 : 1)
+			+ (session.chain.next.empty() ? 0 : 1));
+		app::write_text(writer, recording::KEY_SEGMENT_INDEX);
+		writer.writeUnsignedInt(session.chain.index);
+
+		if (!session.chain.previous.empty()) {
+			app::write_text(writer, recording::KEY_SEGMENT_PREVIOUS);
+			app::write_text(writer, session.chain.previous.c_str());
+		}
+
+		if (!session.chain.next.empty()) {
+			app::write_text(writer, recording::KEY_SEGMENT_NEXT);
+			app::write_text(writer, session.chain.next.c_str());
+		}
+	}
+
+	app::write_text(writer, recording::KEY_READINGS_FORMAT);
+	writer.beginArray(recording::READINGS_FORMAT.size());
+	for (const char *format : recording::READINGS_FORMAT)
+		app::write_text(writer, format);
+
+	app::write_text(writer, recording::KEY_STATISTICS);
+	writer.beginMap(6);
+	app::write_text(writer, recording::KEY_STATISTICS_COUNT);
+	writer.writeUnsignedInt(session.statistics.count);
+	app::write_text(writer, recording::KEY_STATISTICS_TARES);
+	writer.writeUnsignedInt(session.statistics.tares);
+	app::write_text(writer, recording::KEY_STATISTICS_MIN);
+	writer.writeInt(session.statistics.min);
+	app::write_text(writer, recording::KEY_STATISTICS_MAX);
+	writer.writeInt(session.statistics.max);
+	app::write_text(writer, recording::KEY_STATISTICS_MEAN);
+	writer.writeFloat(session.statistics.mean);
+	app::write_text(writer, recording::KEY_STATISTICS_STDDEV);
+	writer.writeFloat(session.statistics.stddev());
+
+	app::write_text(writer, recording::KEY_ANCHORS);
+	writer.beginArray(session.anchors.size());
+	for (const auto &anchor : session.anchors) {
+		writer.beginArray(2);
+		writer.writeUnsignedInt(anchor.realtime_us);
+		writer.writeUnsignedInt(anchor.offset_us);
+	}
+
+	app::write_text(writer, recording::KEY_READINGS);
+	writer.beginIndefiniteArray();
+
+	int32_t previous_value = 0;
+
+	session.for_each([&writer, &previous_value] (const Data *data, size_t count) {
+		previous_value = recording::write_readings(writer,
+			[] (cbor::Writer &writer, const char *text) { app::write_text(writer, text); },
+			data, count, previous_value);
+	});
+
+	writer.endIndefinite();
+}
+
+HX711::HX711(HX711Hardware &hardware) : hardware_(hardware),
+		session_(std::make_shared<Session>(pool_)) {
 }
 
 void HX711::init() {
-	pinMode(sck_pin_, OUTPUT);
-	digitalWrite(sck_pin_, LOW);
-	pinMode(data_pin_, INPUT_PULLUP);
+	{
+		std::lock_guard lock{mutex_};
+
+		if (pool_.init(SCALES_BUFFER_KB * 1024UL, BUFFER_RESERVE_BYTES)) {
+			logger_.info(F("Buffer size %zuKB (%zu readings)"),
+				pool_.segments() * SegmentPool::SEGMENT_BYTES / 1024,
+				pool_.segments() * SegmentPool::SEGMENT_READINGS);
+		} else {
+			logger_.crit(F("Unable to allocate buffer"));
+		}
+	}
+
+	unsigned int rate_hz = load_rate();
+	Compressor::Parameters compression = load_compression();
+	Rotation rotation = load_rotation();
+
+	hardware_.init();
+
+	{
+		std::lock_guard lock{mutex_};
+
+		compression_ = compression;
+		rotation_ = rotation;
+		if (compression.mode != Compressor::Mode::LOSSLESS) {
+			logger_.info(F("Compression %s (%u)"), Compressor::mode_name(compression.mode),
+				compression.tolerance);
+		}
 
-	digitalWrite(sck_pin_, HIGH);
-	delayMicroseconds(100);
-	digitalWrite(sck_pin_, LOW);
+		rate_selectable_ = hardware_.select_rate(rate_hz);
+		if (rate_selectable_) {
+			logger_.info(F("Rate %uHz"), rate_hz);
+			rate_hz_ = rate_hz;
+			detector_.parameters(rate_step_parameters());
+		}
+	}
+
+	hardware_.sck(true);
+	hardware_.delay_us(100);
+	hardware_.sck(false);
+
+	if (xTaskCreate(save_task, "hx711_save", SAVE_STACK_SIZE, this, uxTaskPriorityGet(nullptr),
+			&save_task_) != pdPASS) {
+		logger_.crit(F("Failed to start save task"));
+		save_task_ = nullptr;
+	}
 }
 
-void HX711::loop() {
-	if (digitalRead(data_pin_) == HIGH)
+unsigned int HX711::load_rate() {
+	std::lock_guard lock{app::App::file_mutex()};
+	unsigned int rate_hz = FAST_RATE_HZ;
+
+	if (!FS.exists(RATE_FILENAME))
+		return rate_hz;
+
+	auto file = FS.open(RATE_FILENAME);
+
+	if (file) {
+		char buf[8]{};
+
+		file.readBytes(buf, sizeof(buf) - 1);
+		rate_hz = std::strtoul(buf, nullptr, 10);
+	}
+
+	return rate_hz == SLOW_RATE_HZ ? SLOW_RATE_HZ : FAST_RATE_HZ;
+}
+
+void HX711::save_rate(unsigned int rate_hz) {
+	std::lock_guard lock{app::App::file_mutex()};
+	auto file = FS.open(RATE_FILENAME, "w");
+
+	if (!file || file.printf("%u\n", rate_hz) <= 0)
+		logger_.err(F("Unable to save rate"));
+}
+
+Compressor::Parameters HX711::load_compression() {
+	std::lock_guard lock{app::App::file_mutex()};
+	Compressor::Parameters parameters;
+
+	if (!FS.exists(COMPRESSION_FILENAME))
+		return parameters;
+
+	auto file = FS.open(COMPRESSION_FILENAME);
+
+	if (file) {
+		char buf[32]{};
+
+		file.readBytes(buf, sizeof(buf) - 1);
+
+		char *separator = std::strchr(buf, ' ');
+
+		if (separator) {
+			*separator = '\0';
+
+			if (Compressor::mode(buf, parameters.mode))
+				parameters.tolerance = std::strtoul(separator + 1, nullptr, 10);
+		}
+	}
+
+	return parameters;
+}
+
+void HX711::save_compression(const Compressor::Parameters &parameters) {
+	std::lock_guard lock{app::App::file_mutex()};
+
+	if (parameters.mode == Compressor::Mode::LOSSLESS) {
+		FS.remove(COMPRESSION_FILENAME);
 		return;
+	}
 
-	uint32_t reading = 0;
+	auto file = FS.open(COMPRESSION_FILENAME, "w");
 
-	delayMicroseconds(1); // T1
+	if (!file || file.printf("%s %u\n", Compressor::mode_name(parameters.mode),
+			(unsigned int)parameters.tolerance) <= 0)
+		logger_.err(F("Unable to save compression"));
+}
+
+Compressor::Parameters HX711::compression() const {
+	std::lock_guard lock{mutex_};
+	return compression_;
+}
 
-	noInterrupts();
-	for (int i = 0; i < 25; i++) {
-		digitalWrite(sck_pin_, HIGH);
-		delayMicroseconds(1); // T2 & T3
-		reading |= digitalRead(data_pin_) == HIGH ? 1 : 0;
-		reading <<= 1;
-		digitalWrite(sck_pin_, LOW);
-		delayMicroseconds(1); // T4
+bool HX711::compression(const Compressor::Parameters &parameters) {
+	{
+		std::lock_guard lock{mutex_};
+
+		if (running_) {
+			logger_.warning(F("Unable to change compression while recording"));
+			return false;
+		}
+
+		logger_.info(F("Compression %s (%u)"), Compressor::mode_name(parameters.mode),
+			(unsigned int)parameters.tolerance);
+		compression_ = parameters;
 	}
-	interrupts();
 
-	reading >>= 1;
+	save_compression(parameters);
+	return true;
+}
 
-	if ((reading & 1) != 1)
+HX711::Rotation HX711::load_rotation() {
+	std::lock_guard lock{app::App::file_mutex()};
+	Rotation rotation;
+
+	if (!FS.exists(ROTATION_FILENAME))
+		return rotation;
+
+	auto file = FS.open(ROTATION_FILENAME);
+
+	if (file) {
+		char buf[32]{};
+		char *end;
+
+		file.readBytes(buf, sizeof(buf) - 1);
+		rotation.minutes = std::strtoul(buf, &end, 10);
+		rotation.readings = std::strtoul(end, nullptr, 10);
+	}
+
+	return rotation;
+}
+
+void HX711::save_rotation(const Rotation &rotation) {
+	std::lock_guard lock{app::App::file_mutex()};
+
+	if (!rotation.minutes && !rotation.readings) {
+		FS.remove(ROTATION_FILENAME);
 		return;
+	}
+
+	auto file = FS.open(ROTATION_FILENAME, "w");
 
-	int32_t value = ((reading & 0x1000000) ? 0xFF000000 : 0) | (reading >> 1);
-	uint64_t now = ::esp_timer_get_time();
+	if (!file || file.printf("%u %lu\n", rotation.minutes, rotation.readings) <= 0)
+		logger_.err(F("Unable to save rotation"));
+}
 
+HX711::Rotation HX711::rotation() const {
 	std::lock_guard lock{mutex_};
+	return rotation_;
+}
 
-	if (running_ && buffer_pos_ < BUFFER_SIZE) {
-		Data &data = buffer_.get()[buffer_pos_++];
+void HX711::rotation(const Rotation &rotation) {
+	{
+		std::lock_guard lock{mutex_};
 
-		data.time_us = std::min(now - start_us_, (uint64_t)UINT32_MAX);
-		data.type = tare_ ? Type::TARE : Type::READING;
-		data.value = value;
+		logger_.info(F("Rotation every %u minutes, %lu readings"),
+			rotation.minutes, rotation.readings);
+		rotation_ = rotation;
+	}
 
-		logger_.trace("Reading: %d (%07x) [%lu]", value, reading, buffer_pos_);
+	save_rotation(rotation);
+}
 
-		if (tare_) {
-			buffer_tare_ = true;
+bool HX711::rate(unsigned int rate_hz) {
+	if (rate_hz != SLOW_RATE_HZ && rate_hz != FAST_RATE_HZ)
+		return false;
+
+	{
+		std::lock_guard lock{mutex_};
+
+		if (running_) {
+			logger_.warning(F("Unable to change rate while recording"));
+			return false;
 		}
 
-		if (buffer_pos_ == BUFFER_SIZE) {
+		if (!hardware_.select_rate(rate_hz))
+			return false;
+
+		rate_selectable_ = true;
+
+		if (rate_hz == rate_hz_)
+			return true;
+
+		logger_.info(F("Rate %uHz"), rate_hz);
+		rate_hz_ = rate_hz;
+		rate_changed_ = true;
+		detector_.parameters(rate_step_parameters());
+		stats_.period_ns.store(0, std::memory_order_relaxed);
+		stats_.jitter_ns.store(0, std::memory_order_relaxed);
+	}
+
+	save_rate(rate_hz);
+	return true;
+}
+
+void HX711::loop() {
+	if (rate_changed_.exchange(false)) {
+		clock_.reset();
+		last_read_us_ = 0;
+	}
+
+	if (!hardware_.ready())
+		return;
+
+	trace::Span span{trace::Category::HX711, "read"};
+	uint64_t ready_us = hardware_.ready_us();
+	uint32_t reading = hardware_.read();
+
+	if ((reading & 1) != 1) {
+		stats_.invalid_reads.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	int32_t value = recording::sign_extend(reading >> 1);
+
+	stats_.samples.fetch_add(1, std::memory_order_relaxed);
+
+	if (last_read_us_ != 0) {
+		uint32_t interval = std::min(ready_us - last_read_us_, (uint64_t)UINT32_MAX);
+		uint32_t period_us = clock_.period_ns() / 1000;
+
+		if (period_us != 0 && interval > period_us + period_us / 2)
+			stats_.late_reads.fetch_add(1, std::memory_order_relaxed);
+
+		trace::counter(trace::Category::HX711, "interval_us", interval);
+	}
+
+	uint64_t now = clock_.update(ready_us);
+
+	stats_.period_ns.store(clock_.period_ns(), std::memory_order_relaxed);
+	stats_.jitter_ns.store(clock_.jitter_ns(), std::memory_order_relaxed);
+	last_read_us_ = ready_us;
+
+	std::lock_guard lock{mutex_};
+	uint8_t events = detector_.update(now, value);
+
+	if (events)
+		add_event(now, events);
+
+	if (live_index_ == 0) {
+		live_previous_us_ = now;
+		live_tare_value_ = tare_value_;
+	}
+
+	uint8_t adjustment = adjust_tare(now);
+
+	if (adjustment)
+		add_live(live_previous_us_, recording::make_tare_data(adjustment, tare_value_));
+
+	add_live(now, recording::make_data(now, live_previous_us_, events, value));
+
+	if (running_ && rotation_due(now))
+		rotate();
+
+	if (running_ && !buffer_full_ && record(now, events, adjustment, value)) {
+		session_->statistics.add(value);
+
+		logger_.trace("Reading: %d (%07x) [%lu]", value, reading, session_->count());
+
+		if (adjustment & Type::TARE) {
+			buffer_tare_ = true;
+			session_->statistics.tares++;
+		}
+	} else if (running_) {
+		if (!buffer_full_) {
 			logger_.notice("Maximum readings reached");
+			buffer_full_ = true;
 		}
+
+		stats_.dropped_readings.fetch_add(1, std::memory_order_relaxed);
 	} else {
 		logger_.trace("Reading: %d (%07x)", value, reading);
 	}
 
+	if (running_ && ready_us > anchor_us_ && ready_us - anchor_us_ >= ANCHOR_INTERVAL_US)
+		add_anchor();
+
 	reading_ = value;
+}
+
+uint8_t HX711::adjust_tare(uint64_t now_us) {
 	if (tare_) {
-		logger_.info("Tare: %d", value);
+		bool settled = detector_.settled();
+
+		if (!settled && now_us < tare_us_ + TARE_TIMEOUT_US)
+			return Type::READING;
+
+		int32_t value = settled ? detector_.level() : detector_.mean();
+
+		if (settled) {
+			logger_.info("Tare: %d (%+d)", value, value - tare_value_);
+		} else {
+			logger_.warning("Tare: %d (%+d), readings not stable", value, value - tare_value_);
+		}
+
 		tare_value_ = value;
 		tare_ = false;
+		zero_us_ = now_us;
+		return Type::TARE;
+	}
+
+	if (!zero_range_ || !detector_.settled() || now_us < zero_us_ + ZERO_INTERVAL_US)
+		return Type::READING;
+
+	zero_us_ = now_us;
+
+	int32_t offset = detector_.level() - tare_value_;
+	int32_t magnitude = std::abs(offset);
+
+	/*
+	 * Only follow drift while unloaded, and ignore changes that are within
+	 * the variation of the settled level so that the tare value isn't
+	 * adjusted every time.
+	 */
+	if (magnitude > zero_range_ || magnitude == 0
+			|| (uint32_t)magnitude <= detector_.noise() / ZERO_NOISE_DIVISOR)
+		return Type::READING;
+
+	logger_.debug("Zero: %d (%+d)", tare_value_ + offset, offset);
+	tare_value_ += offset;
+	return Type::ZERO;
+}
+
+bool HX711::record(uint64_t now_us, uint8_t events, uint8_t adjustment, int32_t value) {
+	uint8_t keep = compressor_.add(now_us, value, events || adjustment);
+
+	if (keep & Compressor::Keep::PREVIOUS) {
+		const Compressor::Point &previous = compressor_.previous();
+
+		if (!append(recording::make_data(previous.time_us, previous_us_, Type::READING, previous.value)))
+			return false;
+
+		previous_us_ = previous.time_us;
+	}
+
+	if (adjustment && !append(recording::make_tare_data(adjustment, tare_value_)))
+		return false;
+
+	if (keep & Compressor::Keep::CURRENT) {
+		if (!append(recording::make_data(now_us, previous_us_, events, value)))
+			return false;
+
+		previous_us_ = now_us;
+	}
+
+	return true;
+}
+
+bool HX711::append(const Data &data) {
+	while (!session_->append(data)) {
+		if (!evict_session())
+			return false;
+	}
+
+	return true;
+}
+
+void HX711::add_live(uint64_t time_us, const Data &data) {
+	LiveReading &live = live_[live_index_ % live_.size()];
+
+	live.time_us = time_us;
+	live.tare_value = live_tare_value_;
+	live.data = data;
+	live_index_++;
+
+	if (data.type & Type::TARE_VALUE) {
+		live_tare_value_ = recording::sign_extend(data.value);
+	} else {
+		live_previous_us_ = time_us;
+	}
+}
+
+size_t HX711::live_readings(uint32_t &index, LiveReading *readings, size_t max) const {
+	std::lock_guard lock{mutex_};
+	uint32_t available = live_index_ - index;
+
+	if (available > live_.size()) {
+		index = live_index_ - std::min(live_index_, (uint32_t)live_.size());
+		available = live_index_ - index;
+	}
+
+	size_t count = std::min((size_t)available, max);
+
+	for (size_t i = 0; i < count; i++)
+		readings[i] = live_[(index + i) % live_.size()];
+
+	return count;
+}
+
+void HX711::keep_last() {
+	Compressor::Point last;
+
+	/* Keep the last reading so that the recording doesn't end early */
+	if (compressor_.flush(last) && !buffer_full_
+			&& append(recording::make_data(last.time_us, previous_us_, Type::READING, last.value)))
+		previous_us_ = last.time_us;
+}
+
+void HX711::finish_session(uint64_t stop_us) {
+	add_anchor();
+
+	session_->realtime_us = realtime_us_;
+	session_->start_us = start_us_;
+	session_->stop_us = stop_us;
+	session_->period_ns = stats_.period_ns.load(std::memory_order_relaxed);
+	session_->jitter_ns = stats_.jitter_ns.load(std::memory_order_relaxed);
+	session_->rate_hz = rate_selectable_ ? rate_hz_ : 0;
+	session_->compression = compression_;
+}
+
+bool HX711::rotation_due(uint64_t now_us) const {
+	if (!rotation_.minutes && !rotation_.readings)
+		return false;
+
+	if (now_us < start_us_ + MIN_ROTATION_US)
+		return false;
+
+	return (rotation_.minutes && now_us - start_us_ >= rotation_.minutes * 60000000ULL)
+		|| (rotation_.readings && session_->statistics.count >= rotation_.readings);
+}
+
+void HX711::rotate() {
+	std::shared_ptr<Session> session = session_;
+
+	keep_last();
+
+	/* The next file starts at the last reading of this one */
+	uint64_t boundary_us = previous_us_;
+
+	finish_session(boundary_us);
+
+	struct timeval realtime;
+	uint64_t now_us = hardware_.now_us();
+
+	gettimeofday(&realtime, NULL);
+
+	uint64_t realtime_us = (uint64_t)realtime.tv_sec * 1000000ULL + realtime.tv_usec
+		- (now_us > boundary_us ? now_us - boundary_us : 0);
+
+	session_ = std::make_shared<Session>(pool_);
+	session_->realtime_us.tv_sec = realtime_us / 1000000ULL;
+	session_->realtime_us.tv_usec = realtime_us % 1000000ULL;
+	session_->continuous = true;
+	session_->chain.index = session->chain.index + 1;
+	session_->chain.previous = session_filename(*session);
+	session->continuous = true;
+	session->chain.next = session_filename(*session_);
+
+	realtime_us_ = session_->realtime_us;
+	start_us_ = boundary_us;
+	buffer_full_ = false;
+	buffer_tare_ = false;
+	compressor_.reset(compression_);
+
+	/* So that each file can be used on its own */
+	if (tare_value_ != 0)
+		append(recording::make_tare_data(Type::READING, tare_value_));
+
+	logger_.info(F("Continuing in %s"), session->chain.next.c_str());
+	rotated_.push_back(session);
+	stats_.rotations.fetch_add(1, std::memory_order_relaxed);
+
+	if (save_task_)
+		xTaskNotifyGive(save_task_);
+}
+
+void HX711::save_task(void *arg) {
+	static_cast<HX711*>(arg)->save_rotated();
+}
+
+void HX711::save_rotated() {
+	while (true) {
+		std::shared_ptr<Session> session;
+
+		{
+			std::lock_guard lock{mutex_};
+
+			if (!rotated_.empty())
+				session = rotated_.front();
+		}
+
+		if (!session) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			continue;
+		}
+
+		/*
+		 * Nothing else uses the readings, so they aren't delayed while it's
+		 * encoded. It stays in the list of rotated sessions until it's
+		 * resident or saved so that it can still be listed and deleted.
+		 */
+		bool resident = encode(*session, false);
+
+		{
+			std::lock_guard lock{mutex_};
+			auto it = std::find(rotated_.begin(), rotated_.end(), session);
+
+			/* Available for download while it's being saved (unless it has been deleted) */
+			if (resident && it != rotated_.end()) {
+				rotated_.erase(it);
+				resident_.push_back(session);
+			}
+		}
+
+		bool saved = save(*session);
+
+		std::lock_guard lock{mutex_};
+		auto it = std::find(rotated_.begin(), rotated_.end(), session);
+
+		if (it != rotated_.end())
+			rotated_.erase(it);
+
+		session->saved = saved;
+	}
+}
+
+void HX711::add_anchor() {
+	struct timeval realtime_us;
+	uint64_t before_us = hardware_.now_us();
+
+	gettimeofday(&realtime_us, NULL);
+
+	uint64_t now_us = before_us + (hardware_.now_us() - before_us) / 2;
+
+	session_->anchors.push_back({
+		(uint64_t)realtime_us.tv_sec * 1000000ULL + realtime_us.tv_usec,
+		now_us - start_us_});
+	anchor_us_ = now_us;
+}
+
+bool HX711::evict_session() {
+	for (auto it = resident_.begin(); it != resident_.end(); ++it) {
+		if ((*it)->saved) {
+			logger_.debug(F("Evicting %s from memory"), session_filename(**it).c_str());
+			resident_.erase(it);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+unsigned long HX711::evictable_segments() const {
+	unsigned long segments = 0;
+
+	for (const auto &session : resident_) {
+		if (session->saved)
+			segments += session->segments();
+	}
+
+	return segments;
+}
+
+unsigned long HX711::max_count() const {
+	std::lock_guard lock{mutex_};
+	unsigned long segments = pool_.free_segments() + evictable_segments();
+
+	if (running_ || std::find(resident_.begin(), resident_.end(), session_) == resident_.end()) {
+		/* Released when the next recording starts */
+		segments += session_->segments();
+	}
+
+	return segments * SegmentPool::SEGMENT_READINGS;
+}
+
+uint64_t HX711::max_duration_us() const {
+	uint64_t period_ns = stats_.period_ns.load(std::memory_order_relaxed);
+
+	/* The period isn't known until there have been readings at the current rate */
+	if (!period_ns)
+		period_ns = 1000000000ULL / rate();
+
+	return (uint64_t)max_count() * period_ns / 1000;
+}
+
+void HX711::add_event(uint64_t now_us, uint8_t type) {
+	const auto &detected = detector_.event();
+	Event &event = events_[events_pos_];
+	uint64_t age_us = now_us > detected.time_us ? now_us - detected.time_us : 0;
+
+	gettimeofday(&event.realtime, NULL);
+	event.realtime.tv_sec -= age_us / 1000000;
+	event.realtime.tv_usec -= age_us % 1000000;
+	if (event.realtime.tv_usec < 0) {
+		event.realtime.tv_sec--;
+		event.realtime.tv_usec += 1000000;
+	}
+
+	event.type = type;
+	event.level = detected.level - tare_value_;
+	event.step = detected.step;
+	event.settling_ms = std::min(detected.settling_us / 1000, (uint64_t)UINT32_MAX);
+
+	events_pos_ = (events_pos_ + 1) % events_.size();
+	events_count_ = std::min(events_count_ + 1, events_.size());
+
+	if (type == StepDetector::SETTLED) {
+		logger_.info("Settled: %d (step %d after %lums)", event.level, event.step,
+			(unsigned long)event.settling_ms);
+	} else {
+		logger_.info("Load %s: %d", type == StepDetector::APPLIED ? "applied" : "removed",
+			event.level);
 	}
 }
 
+void HX711::events(std::function<void(const Event &event)> func) const {
+	std::array<Event,MAX_EVENTS> events;
+	size_t count;
+
+	/* Copy the events so that a slow client doesn't block readings */
+	{
+		std::lock_guard lock{mutex_};
+
+		count = events_count_;
+		for (size_t i = 1; i <= count; i++)
+			events[i - 1] = events_[(events_pos_ + events_.size() - i) % events_.size()];
+	}
+
+	for (size_t i = 0; i < count; i++)
+		func(events[i]);
+}
+
+StepDetector::Parameters HX711::step_parameters() const {
+	std::lock_guard lock{mutex_};
+	return step_parameters_;
+}
+
+void HX711::step_parameters(const StepDetector::Parameters &parameters) {
+	std::lock_guard lock{mutex_};
+
+	/* Use the same limits as the detector */
+	detector_.parameters(parameters);
+	step_parameters_ = detector_.parameters();
+	detector_.parameters(rate_step_parameters());
+}
+
+StepDetector::Parameters HX711::rate_step_parameters() const {
+	StepDetector::Parameters parameters = step_parameters_;
+	unsigned int window = (parameters.window * rate_hz_ + FAST_RATE_HZ / 2) / FAST_RATE_HZ;
+
+	parameters.window = std::min(parameters.window, std::max(window, MIN_STEP_WINDOW));
+	return parameters;
+}
+
+bool HX711::settled(int32_t &level, uint32_t &noise) const {
+	std::lock_guard lock{mutex_};
+
+	level = detector_.level() - tare_value_;
+	noise = detector_.noise();
+	return detector_.settled();
+}
+
 int32_t HX711::reading() {
 	std::lock_guard lock{mutex_};
 
@@ -134,7 +889,8 @@ void HX711::start() {
 	gettimeofday(&realtime_us_, NULL);
 	start_us_ = 0;
 	stop_us_ = 0;
-	buffer_pos_ = 0;
+	session_ = std::make_shared<Session>(pool_);
+	buffer_full_ = false;
 	running_ = false;
 
 	if (realtime_us_.tv_sec < 0 || (unsigned long)realtime_us_.tv_sec < EPOCH_S) {
@@ -142,8 +898,10 @@ void HX711::start() {
 	}
 
 	logger_.info("Start");
-	start_us_ = ::esp_timer_get_time();
-	buffer_pos_ = 0;
+	start_us_ = hardware_.now_us();
+	previous_us_ = start_us_;
+	anchor_us_ = start_us_;
+	compressor_.reset(compression_);
 	buffer_tare_ = false;
 	running_ = true;
 	tare_ = false;
@@ -151,104 +909,223 @@ void HX711::start() {
 
 void HX711::tare() {
 	std::lock_guard lock{mutex_};
-	tare_ = true;
+
+	if (!tare_) {
+		tare_ = true;
+		tare_us_ = hardware_.now_us();
+	}
+}
+
+int32_t HX711::zero_tracking() const {
+	std::lock_guard lock{mutex_};
+	return zero_range_;
+}
+
+void HX711::zero_tracking(int32_t range) {
+	std::lock_guard lock{mutex_};
+	zero_range_ = std::max(range, (int32_t)0);
 }
 
 uint64_t HX711::duration_us() const {
 	std::lock_guard lock{mutex_};
 
 	if (running_) {
-		return ::esp_timer_get_time() - start_us_;
+		return hardware_.now_us() - start_us_;
 	} else {
 		return stop_us_ - start_us_;
 	}
 }
 
 void HX711::stop() {
-	std::lock_guard lock{mutex_};
+	std::shared_ptr<Session> session;
 
-	if (running_) {
-		stop_us_ = ::esp_timer_get_time();
+	{
+		std::lock_guard lock{mutex_};
+
+		if (!running_)
+			return;
+
+		keep_last();
+		stop_us_ = hardware_.now_us();
+		finish_session(stop_us_);
+		running_ = false;
 		logger_.info("Stop");
-		save();
+
+		if (!encode(*session_)) {
+			session_->saved = save(*session_);
+			return;
+		}
+
+		/* Available for download while it's being saved */
+		resident_.push_back(session_);
+		session = session_;
 	}
-	running_ = false;
+
+	bool saved = save(*session);
+
+	std::lock_guard lock{mutex_};
+	session->saved = saved;
+}
+
+std::string HX711::session_filename(const Session &session) {
+	return std::to_string(session.realtime_us.tv_sec) + FILENAME_EXT;
+}
+
+bool HX711::encode(Session &session, bool locked) {
+	trace::Span span{trace::Category::SAVE, "encode"};
+	uint64_t encode_start_us = ::esp_timer_get_time();
+	EncodedPrint output{session, [this, locked] {
+		if (locked)
+			return evict_session();
+
+		std::lock_guard lock{mutex_};
+		return evict_session();
+	}};
+	cbor::Writer writer{output};
+
+	write_recording(writer, session);
+
+	if (output.getWriteError()) {
+		logger_.warning(F("Not enough memory to keep %s resident"),
+			session_filename(session).c_str());
+		session.clear_encoded();
+		return false;
+	}
+
+	session.release_readings();
+
+	logger_.debug(F("Encoded %lu readings to %zu bytes in %" PRIu64 "us"),
+		session.count(), session.encoded_size(), ::esp_timer_get_time() - encode_start_us);
+	return true;
 }
 
-void HX711::save() {
+bool HX711::save(const Session &session) {
 	std::string filename;
 
 	filename.append(DIRECTORY_NAME);
 	filename.append("/");
-	filename.append(std::to_string(realtime_us_.tv_sec));
-	filename.append(FILENAME_EXT);
+	filename.append(session_filename(session));
 
+	trace::Span save_span{trace::Category::SAVE, "save"};
 	std::lock_guard lock{app::App::file_mutex()};
+	trace::Span span{trace::Category::FS, "write"};
+
+	/*
+	 * The file is deleted with the mutex held after the session is marked
+	 * as deleted, so it's either removed after this or never written
+	 */
+	if (session.deleted) {
+		logger_.info(F("Not saving deleted recording %s"), filename.c_str());
+		return true;
+	}
+
+	uint64_t save_start_us = ::esp_timer_get_time();
+
+	stats_.saves.fetch_add(1, std::memory_order_relaxed);
+
+	if (FS.exists(filename.c_str()))
+		file_generation_++;
 
 	auto file = FS.open(filename.c_str(), "w", true);
 	if (!file) {
 		logger_.err(F("Unable to open file %s for writing"), filename.c_str());
-		return;
+		stats_.save_errors.fetch_add(1, std::memory_order_relaxed);
+		return false;
 	}
 
 	logger_.info(F("Writing %s"), filename.c_str());
 
-	cbor::Writer writer{file};
+	if (session.encoded_size() > 0) {
+		session.for_each_encoded([&file] (const uint8_t *data, size_t size) {
+			file.write(data, size);
+		});
+	} else {
+		cbor::Writer writer{file};
 
-	writer.writeTag(cbor::kSelfDescribeTag);
-	writer.beginMap(5);
+		write_recording(writer, session);
+	}
 
-	app::write_text(writer, "realtime_s_us");
-	writer.beginArray(2);
-	writer.writeUnsignedInt(realtime_us_.tv_sec);
-	writer.writeUnsignedInt(realtime_us_.tv_usec);
+	uint32_t save_bytes = file.size();
+	uint32_t save_us = ::esp_timer_get_time() - save_start_us;
 
-	app::write_text(writer, "start_us");
-	writer.writeUnsignedInt(start_us_);
+	stats_.save_bytes.store(save_bytes, std::memory_order_relaxed);
+	stats_.save_bytes_total.fetch_add(save_bytes, std::memory_order_relaxed);
+	stats_.save_us.store(save_us, std::memory_order_relaxed);
+	stats_.save_ms_total.fetch_add(save_us / 1000, std::memory_order_relaxed);
 
-	app::write_text(writer, "stop_us");
-	writer.writeUnsignedInt(stop_us_);
+	if (file.getWriteError()) {
+		logger_.err(F("Failed to write file %s: %u"), filename.c_str(), file.getWriteError());
+		stats_.save_errors.fetch_add(1, std::memory_order_relaxed);
+		file.close();
+		FS.remove(filename.c_str());
+		return false;
+	}
 
-	app::write_text(writer, "readings_format");
-	writer.beginArray(3);
-	app::write_text(writer, "[flags:text]");
-	app::write_text(writer, "<offset_time_us:uint>");
-	app::write_text(writer, "<offset_value:int>");
+	logger_.info(F("Saved readings to %s"), filename.c_str());
+	return true;
+}
 
-	app::write_text(writer, "readings");
-	writer.beginIndefiniteArray();
+std::shared_ptr<const Session> HX711::resident_file(const std::string_view filename) {
+	std::lock_guard lock{mutex_};
 
-	uint32_t previous_us = 0;
-	int32_t previous_value = 0;
+	for (const auto &session : resident_) {
+		if (session_filename(*session) == filename)
+			return session;
+	}
 
-	for (unsigned long i = 0; i < buffer_pos_; i++) {
-		const Data &data = buffer_.get()[i];
-		int32_t value = ((data.value & 0x800000) ? 0xFF000000 : 0) | data.value;
+	return {};
+}
 
-		if (data.type == Type::TARE) {
-			app::write_text(writer, "tare");
+bool HX711::remove_resident(const std::string_view filename) {
+	std::lock_guard lock{mutex_};
+
+	for (auto it = resident_.begin(); it != resident_.end(); ++it) {
+		if (session_filename(**it) == filename) {
+			/* It may still be saved by stop() or the save task */
+			(*it)->deleted = true;
+			resident_.erase(it);
+			return true;
 		}
+	}
 
-		writer.writeUnsignedInt(data.time_us - previous_us);
-		previous_us = data.time_us;
-		writer.writeInt(value - previous_value);
-		previous_value = value;
+	for (auto it = rotated_.begin(); it != rotated_.end(); ++it) {
+		if (session_filename(**it) == filename) {
+			(*it)->deleted = true;
+			rotated_.erase(it);
+			return true;
+		}
 	}
 
-	writer.endIndefinite();
+	return false;
+}
 
-	if (file.getWriteError()) {
-		logger_.err(F("Failed to write file %s: %u"), filename.c_str(), file.getWriteError());
-		file.close();
-		FS.remove(filename.c_str());
+void HX711::list_files(std::function<void(std::string_view filename,
+		std::string_view timestamp, bool resident,
+		const recording::Statistics *statistics)> func, bool statistics) {
+	std::vector<std::pair<std::string,recording::Statistics>> resident;
+	std::vector<std::pair<std::string,recording::Statistics>> unsaved;
+	char timestamp[32];
+
+	{
+		std::lock_guard lock{mutex_};
+
+		for (const auto &session : resident_) {
+			(session->saved ? resident : unsaved).emplace_back(
+				session_filename(*session), session->statistics);
+		}
+
+		/* Files of a continuous recording that are waiting to be saved */
+		for (const auto &session : rotated_)
+			unsaved.emplace_back(session_filename(*session), session->statistics);
 	}
 
-	logger_.info(F("Saved readings to %s"), filename.c_str());
-}
+	for (const auto &[filename, file_stats] : unsaved) {
+		func(filename, file_name(filename, false, timestamp, sizeof(timestamp)), true,
+			statistics ? &file_stats : nullptr);
+	}
 
-void HX711::list_files(std::function<void(const std::string &filename,
-		const std::string &timestamp)> func) {
 	std::lock_guard lock{app::App::file_mutex()};
+	trace::Span span{trace::Category::FS, "list"};
 	const char mode[2] = { 'r', '\0' };
 	auto dir = FS.open(DIRECTORY_NAME, mode);
 	size_t len = strlen(DIRECTORY_NAME) + 1;
@@ -256,80 +1133,370 @@ void HX711::list_files(std::function<void(const std::string &filename,
 	while (true) {
 		auto name = dir.getNextFileName();
 		if (name.length() > len) {
-			std::string filename{name.c_str() + len};
+			std::string_view filename{name.c_str() + len};
+			auto match = [&filename] (const auto &file) { return file.first == filename; };
+
+			/* Saved while listing */
+			if (std::find_if(unsaved.begin(), unsaved.end(), match) != unsaved.end())
+				continue;
+
+			auto it = std::find_if(resident.begin(), resident.end(), match);
+			recording::Statistics saved_statistics;
+			const recording::Statistics *file_stats = nullptr;
+
+			if (!statistics) {
+				/* Not requested */
+			} else if (it != resident.end()) {
+				file_stats = &it->second;
+			} else if (file_statistics(name.c_str(), saved_statistics)) {
+				file_stats = &saved_statistics;
+			}
 
-			func(filename, file_name(filename, false));
+			func(filename, file_name(filename, false, timestamp, sizeof(timestamp)),
+				it != resident.end(), file_stats);
 		} else {
 			break;
 		}
 	}
 }
 
+bool HX711::file_statistics(const char *path, recording::Statistics &statistics) {
+	auto file = FS.open(path);
+
+	if (!file)
+		return false;
+
+	RecordingParser parser;
+	char buf[128];
+	size_t total = 0;
+	size_t len;
+
+	/* The statistics are before the anchors, which grow with the length of the recording */
+	while (!parser.statistics() && !parser.readings() && total < HEADER_BYTES
+			&& (len = file.readBytes(buf, sizeof(buf))) > 0) {
+		if (!parser.parse(reinterpret_cast<const uint8_t*>(buf), len))
+			return false;
+
+		total += len;
+	}
+
+	if (!parser.statistics())
+		return false;
+
+	statistics = *parser.statistics();
+	return true;
+}
+
+bool HX711::file_pending(const std::string_view filename) {
+	std::lock_guard lock{mutex_};
+
+	for (const auto &session : rotated_) {
+		if (session_filename(*session) == filename)
+			return true;
+	}
+
+	return false;
+}
+
 bool HX711::file_exists(const std::string_view filename) {
+	if (resident_file(filename) || file_pending(filename))
+		return true;
+
 	std::lock_guard lock{app::App::file_mutex()};
-	std::string path = DIRECTORY_NAME;
+	FilePath path;
 
-	path.append("/");
-	path.append(filename);
+	return !filename.empty() && file_path(filename, path) && FS.open(path.data());
+}
+
+bool HX711::file_path(const std::string_view filename, FilePath &path) {
+	/* Names come from requests, so they must not refer to anything outside the directory */
+	if (filename.empty() || filename[0] == '.'
+			|| filename.find_first_of(std::string_view{"/\\\0", 3}) != std::string_view::npos)
+		return false;
 
-	return !filename.empty() && FS.open(path.c_str());
+	int len = ::snprintf(path.data(), path.size(), "%s/%.*s", DIRECTORY_NAME,
+		(int)filename.size(), filename.data());
+
+	return len > 0 && (size_t)len < path.size();
 }
 
 std::string HX711::file_name(const std::string &filename, bool safe) {
-	std::string timestamp;
-	struct tm tm;
-	time_t t = ::atoi(filename.c_str());
+	char timestamp[32];
 
-	tm.tm_year = 0;
-	::gmtime_r(&t, &tm);
+	return std::string{file_name(filename, safe, timestamp, sizeof(timestamp))};
+}
 
-	if (tm.tm_year != 0) {
-		std::vector<char> tmp(48);
+std::string_view HX711::file_name(const std::string_view filename, bool safe,
+		char *buffer, size_t size) {
+	return recording::file_name(filename, safe, buffer, size);
+}
 
-		::snprintf(tmp.data(), tmp.size(),
-			safe ? "%04u-%02u-%02u_%02u-%02u-%02u" :
-			"%04u-%02u-%02u %02u:%02u:%02u",
-			tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-			tm.tm_hour, tm.tm_min, tm.tm_sec);
+bool HX711::read_readings(const std::string_view filename,
+		RecordingParser::reading_function func) {
+	if (filename.empty())
+		return read_current(func);
 
-		return {tmp.data()};
-	} else {
-		return filename;
+	auto session = resident_file(filename);
+	RecordingParser parser{std::move(func)};
+
+	if (session) {
+		session->for_each_encoded([&parser] (const uint8_t *data, size_t size) {
+			parser.parse(data, size);
+		});
+		return parser.finished();
 	}
-}
 
-void HX711::get_file(const std::string_view filename, Stream &output) {
 	std::lock_guard lock{app::App::file_mutex()};
-	std::string path = DIRECTORY_NAME;
+	trace::Span span{trace::Category::FS, "read"};
+	FilePath path;
 
-	path.append("/");
-	path.append(filename);
+	if (!file_path(filename, path))
+		return false;
 
-	auto file = FS.open(path.c_str());
+	auto file = FS.open(path.data());
 
-	if (file) {
-		std::vector<char> buf(512);
+	if (!file)
+		return false;
 
-		while (true) {
-			size_t len = file.readBytes(buf.data(), buf.size());
+	char buf[512];
+	size_t len;
+
+	while (!parser.finished() && (len = file.readBytes(buf, sizeof(buf))) > 0) {
+		if (!parser.parse(reinterpret_cast<const uint8_t*>(buf), len))
+			break;
+	}
+
+	return parser.finished();
+}
+
+bool HX711::read_current(RecordingParser::reading_function &func) {
+	std::shared_ptr<Session> session;
+	std::array<Data,COPY_READINGS> buffer;
+	unsigned long pos = 0;
+	uint64_t time_us = 0;
+
+	{
+		std::lock_guard lock{mutex_};
+
+		if (!running_)
+			return false;
+
+		session = session_;
+	}
+
+	/*
+	 * Copy a few readings at a time so that the lock isn't held for long,
+	 * until the readings have caught up with the recording (or it stops).
+	 */
+	while (true) {
+		size_t count;
+
+		{
+			std::lock_guard lock{mutex_};
+
+			count = session->copy(pos, buffer.data(), buffer.size());
+		}
+
+		if (count == 0)
+			break;
+
+		for (size_t i = 0; i < count; i++) {
+			if (buffer[i].type & Type::TARE_VALUE)
+				continue;
+
+			time_us += buffer[i].offset_us;
+			func(time_us, recording::sign_extend(buffer[i].value), buffer[i].type);
+		}
+
+		pos += count;
+	}
+
+	return true;
+}
+
+size_t HX711::get_file(const std::string_view filename, Stream &output,
+		std::function<void(size_t size)> open_func) {
+	auto session = resident_file(filename);
+	size_t written = 0;
+
+	if (session) {
+		if (open_func)
+			open_func(session->encoded_size());
+
+		session->for_each_encoded([&output, &written] (const uint8_t *data, size_t size) {
+			written += output.write(data, size);
+		});
+		return written;
+	}
+
+	uint8_t buf[512];
+	uint32_t generation;
+	fs::File file;
+	size_t size;
+
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+		trace::Span span{trace::Category::FS, "open"};
+		FilePath path;
+
+		if (filename.empty() || !file_path(filename, path))
+			return written;
 
-			if (len > 0) {
-				output.write(buf.data(), len);
-			} else {
+		file = FS.open(path.data());
+		if (!file)
+			return written;
+
+		generation = file_generation_.load();
+		size = file.size();
+	}
+
+	if (open_func)
+		open_func(size);
+
+	/*
+	 * Keep the file open but only hold the file mutex while reading each
+	 * chunk, so that a slow client doesn't delay saves and other file
+	 * operations
+	 */
+	while (written < size) {
+		size_t len;
+
+		{
+			std::lock_guard lock{app::App::file_mutex()};
+			trace::Span span{trace::Category::FS, "read"};
+
+			/* Stop if the file has been deleted or replaced */
+			if (file_generation_.load() != generation)
 				break;
-			}
+
+			len = file.readBytes(reinterpret_cast<char*>(buf),
+				std::min(sizeof(buf), size - written));
 		}
+
+		if (len == 0)
+			break;
+
+		output.write(buf, len);
+		written += len;
 	}
+
+	std::lock_guard lock{app::App::file_mutex()};
+	file.close();
+	return written;
+}
+
+size_t HX711::read_file(const std::string_view filename, size_t offset,
+		uint8_t *buffer, size_t length, size_t &size) {
+	std::lock_guard lock{app::App::file_mutex()};
+	trace::Span span{trace::Category::FS, "read"};
+	FilePath path;
+
+	size = 0;
+
+	if (!file_path(filename, path))
+		return 0;
+
+	auto file = FS.open(path.data());
+
+	if (!file)
+		return 0;
+
+	size = file.size();
+
+	if (offset >= size || !file.seek(offset))
+		return 0;
+
+	return file.readBytes(reinterpret_cast<char*>(buffer), std::min(length, size - offset));
 }
 
 void HX711::delete_file(const std::string_view filename) {
+	remove_resident(filename);
+
 	std::lock_guard lock{app::App::file_mutex()};
-	std::string path = DIRECTORY_NAME;
+	trace::Span span{trace::Category::FS, "delete"};
+	FilePath path;
+
+	if (file_path(filename, path) && FS.remove(path.data()))
+		file_generation_++;
+}
+
+unsigned int HX711::delete_files(const std::vector<std::string_view> &filenames) {
+	std::vector<bool> resident;
 
-	path.append("/");
-	path.append(filename);
+	for (const auto &filename : filenames)
+		resident.push_back(remove_resident(filename));
+
+	std::lock_guard lock{app::App::file_mutex()};
+	trace::Span span{trace::Category::FS, "delete"};
+	unsigned int count = 0;
+
+	for (size_t i = 0; i < filenames.size(); i++) {
+		const auto &filename = filenames[i];
+		FilePath path;
+
+		if (!filename.empty() && file_path(filename, path) && FS.remove(path.data())) {
+			file_generation_++;
+			count++;
+		} else if (resident[i]) {
+			count++;
+		}
+	}
+
+	logger_.info(F("Deleted %u/%u files"), count, filenames.size());
+	return count;
+}
+
+unsigned int HX711::delete_all_files() {
+	std::vector<std::string> filenames;
+	unsigned int unsaved = 0;
+
+	{
+		std::lock_guard lock{mutex_};
+
+		for (const auto &session : resident_) {
+			if (!session->saved)
+				unsaved++;
+
+			session->deleted = true;
+		}
+
+		for (const auto &session : rotated_) {
+			unsaved++;
+			session->deleted = true;
+		}
+
+		resident_.clear();
+		rotated_.clear();
+	}
+
+	std::lock_guard lock{app::App::file_mutex()};
+	trace::Span span{trace::Category::FS, "delete"};
+	const char mode[2] = { 'r', '\0' };
+	auto dir = FS.open(DIRECTORY_NAME, mode);
+	size_t len = strlen(DIRECTORY_NAME) + 1;
+	unsigned int count = unsaved;
+
+	while (true) {
+		auto name = dir.getNextFileName();
+		if (name.length() > len) {
+			filenames.emplace_back(name.c_str() + len);
+		} else {
+			break;
+		}
+	}
+	dir.close();
+
+	for (const auto &filename : filenames) {
+		FilePath path;
+
+		if (file_path(filename, path) && FS.remove(path.data())) {
+			file_generation_++;
+			count++;
+		}
+	}
 
-	FS.remove(path.c_str());
+	logger_.info(F("Deleted %u/%u files"), count, filenames.size() + unsaved);
+	return count;
 }
 
 } // namespace scales
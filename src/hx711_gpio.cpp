@@ -0,0 +1,93 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/hx711_gpio.h"
+
+#include <Arduino.h>
+
+namespace scales {
+
+HX711GPIO::HX711GPIO(int data_pin, int sck_pin, int rate_pin)
+		: data_pin_(data_pin), sck_pin_(sck_pin), rate_pin_(rate_pin) {
+}
+
+void HX711GPIO::init() {
+	pinMode(sck_pin_, OUTPUT);
+	digitalWrite(sck_pin_, LOW);
+	if (rate_pin_ >= 0)
+		pinMode(rate_pin_, OUTPUT);
+	pinMode(data_pin_, INPUT_PULLUP);
+	attachInterruptArg(data_pin_, data_interrupt, this, FALLING);
+}
+
+void IRAM_ATTR HX711GPIO::data_interrupt(void *arg) {
+	static_cast<HX711GPIO*>(arg)->edge_us_.store(::esp_timer_get_time(),
+		std::memory_order_relaxed);
+}
+
+bool HX711GPIO::data() {
+	return digitalRead(data_pin_) == HIGH;
+}
+
+void HX711GPIO::sck(bool level) {
+	digitalWrite(sck_pin_, level ? HIGH : LOW);
+}
+
+void HX711GPIO::delay_us(uint32_t us) {
+	delayMicroseconds(us);
+}
+
+uint64_t HX711GPIO::now_us() {
+	return ::esp_timer_get_time();
+}
+
+void HX711GPIO::disable_interrupts() {
+	noInterrupts();
+}
+
+void HX711GPIO::enable_interrupts() {
+	interrupts();
+
+	/*
+	 * Clocking out a reading changes the data pin, so any pending interrupt
+	 * has now been handled and the edge time is before this
+	 */
+	read_us_ = ::esp_timer_get_time();
+}
+
+uint64_t HX711GPIO::ready_us() {
+	uint64_t now = ::esp_timer_get_time();
+	uint32_t since_edge = (uint32_t)now - edge_us_.load(std::memory_order_relaxed);
+	uint32_t since_read = (uint32_t)now - read_us_;
+
+	if (since_edge < since_read)
+		return now - since_edge;
+
+	return now;
+}
+
+bool HX711GPIO::select_rate(unsigned int rate_hz) {
+	if (rate_pin_ < 0)
+		return false;
+
+	/* Low for 10Hz, high for 80Hz */
+	digitalWrite(rate_pin_, rate_hz >= 80 ? HIGH : LOW);
+	return true;
+}
+
+} // namespace scales
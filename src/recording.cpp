@@ -0,0 +1,56 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/recording.h"
+
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <time.h>
+
+namespace scales {
+
+namespace recording {
+
+std::string_view file_name(std::string_view filename, bool safe,
+		char *buffer, size_t size) {
+	struct tm tm;
+	long long value = 0;
+	std::from_chars(filename.data(), filename.data() + filename.size(), value);
+	time_t t = value;
+
+	tm.tm_year = 0;
+	::gmtime_r(&t, &tm);
+
+	if (tm.tm_year != 0) {
+		int len = ::snprintf(buffer, size,
+			safe ? "%04u-%02u-%02u_%02u-%02u-%02u" :
+			"%04u-%02u-%02u %02u:%02u:%02u",
+			tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+			tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+		if (len > 0 && (size_t)len < size)
+			return {buffer, (size_t)len};
+	}
+
+	return filename;
+}
+
+} // namespace recording
+
+} // namespace scales
@@ -0,0 +1,341 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/recording_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+
+#include "scales/recording.h"
+
+namespace scales {
+
+RecordingParser::RecordingParser(reading_function func) : func_(std::move(func)) {
+}
+
+void RecordingParser::reset() {
+	state_ = State::HEAD;
+	depth_ = 0;
+	key_ = false;
+	readings_key_ = false;
+	statistics_key_ = false;
+	statistic_key_ = {};
+	statistics_ = {};
+	have_statistics_ = false;
+	time_us_ = 0;
+	value_ = 0;
+	flags_ = 0;
+	have_offset_ = false;
+	readings_ = false;
+	finished_ = false;
+	failed_ = false;
+}
+
+bool RecordingParser::parse(const uint8_t *data, size_t length) {
+	while (length > 0 && !failed_) {
+		switch (state_) {
+		case State::HEAD: {
+				uint8_t major = *data >> 5;
+				uint8_t info = *data & 0x1F;
+
+				data++;
+				length--;
+
+				if (info < 24) {
+					argument_size_ = 0;
+					head(major, info, false);
+				} else if (info <= 27) {
+					major_ = major;
+					argument_bytes_ = 1U << (info - 24);
+					argument_size_ = argument_bytes_;
+					argument_ = 0;
+					state_ = State::ARGUMENT;
+				} else if (info == 31) {
+					head(major, 0, true);
+				} else {
+					fail();
+				}
+			}
+			break;
+
+		case State::ARGUMENT:
+			argument_ = (argument_ << 8) | *data;
+			data++;
+			length--;
+
+			if (--argument_bytes_ == 0) {
+				state_ = State::HEAD;
+				head(major_, argument_, false);
+			}
+			break;
+
+		case State::STRING: {
+				size_t available = std::min((uint64_t)length, string_remaining_);
+
+				if (capture_text_) {
+					size_t copy = std::min(available, TEXT_SIZE - text_length_);
+
+					std::memcpy(&text_[text_length_], data, copy);
+					text_length_ += copy;
+				}
+
+				data += available;
+				length -= available;
+				string_remaining_ -= available;
+
+				if (string_remaining_ == 0) {
+					state_ = State::HEAD;
+					text();
+				}
+			}
+			break;
+		}
+	}
+
+	return !failed_;
+}
+
+bool RecordingParser::head(uint8_t major, uint64_t value, bool indefinite) {
+	constexpr uint8_t BYTES = 2;
+	constexpr uint8_t TEXT = 3;
+	constexpr uint8_t ARRAY = 4;
+	constexpr uint8_t MAP = 5;
+	constexpr uint8_t TAG = 6;
+	constexpr uint8_t SIMPLE = 7;
+
+	if (finished_)
+		return true;
+
+	if (major == SIMPLE && indefinite) {
+		/* Break */
+		if (depth_ == 0 || stack_[depth_ - 1].remaining != INDEFINITE)
+			return fail();
+
+		if (stack_[depth_ - 1].context == Context::READINGS)
+			finished_ = true;
+
+		depth_--;
+		return complete();
+	}
+
+	if (major == TAG)
+		return !indefinite || fail();
+
+	if (depth_ == 0) {
+		if (major != MAP || indefinite)
+			return fail();
+
+		stack_[depth_++] = {Context::ROOT, value * 2};
+		key_ = true;
+		return value > 0 || fail();
+	}
+
+	const Level &level = stack_[depth_ - 1];
+
+	if (level.context == Context::ROOT && key_ && major != TEXT)
+		return fail();
+
+	switch (major) {
+	case BYTES:
+	case TEXT:
+		if (indefinite)
+			return fail();
+
+		capture_text_ = major == TEXT;
+		text_length_ = 0;
+		string_remaining_ = value;
+
+		if (value == 0)
+			return text();
+
+		state_ = State::STRING;
+		return true;
+
+	case ARRAY:
+	case MAP: {
+			Context context = Context::SKIP;
+
+			if (depth_ == MAX_DEPTH)
+				return fail();
+
+			if (level.context == Context::ROOT && readings_key_ && major == ARRAY) {
+				context = Context::READINGS;
+				readings_ = true;
+			} else if (level.context == Context::ROOT && statistics_key_
+					&& major == MAP && !indefinite) {
+				context = Context::STATISTICS;
+				statistics_ = {};
+				statistic_key_ = {};
+			}
+
+			uint64_t remaining = indefinite ? INDEFINITE : (major == MAP ? value * 2 : value);
+
+			stack_[depth_++] = {context, remaining};
+
+			if (remaining == 0) {
+				if (context == Context::READINGS)
+					finished_ = true;
+				else if (context == Context::STATISTICS)
+					have_statistics_ = true;
+
+				depth_--;
+				return complete();
+			}
+		}
+		return true;
+
+	default:
+		return scalar(major, value);
+	}
+}
+
+bool RecordingParser::scalar(uint8_t major, uint64_t value) {
+	constexpr uint8_t UINT = 0;
+	constexpr uint8_t NEGINT = 1;
+
+	if (stack_[depth_ - 1].context == Context::READINGS) {
+		if (!have_offset_) {
+			if (major != UINT)
+				return fail();
+
+			offset_us_ = value;
+			have_offset_ = true;
+		} else {
+			if (major == UINT) {
+				value_ += (int32_t)value;
+			} else if (major == NEGINT) {
+				value_ -= (int32_t)value + 1;
+			} else {
+				return fail();
+			}
+
+			time_us_ += offset_us_;
+			if (func_)
+				func_(time_us_, value_, flags_);
+			have_offset_ = false;
+			flags_ = 0;
+		}
+	} else if (stack_[depth_ - 1].context == Context::STATISTICS) {
+		statistic(major, value);
+	}
+
+	return complete();
+}
+
+void RecordingParser::statistic(uint8_t major, uint64_t value) {
+	constexpr uint8_t UINT = 0;
+	constexpr uint8_t NEGINT = 1;
+	constexpr uint8_t SIMPLE = 7;
+	double number;
+
+	if (major == UINT) {
+		number = value;
+	} else if (major == NEGINT) {
+		number = -1 - (double)value;
+	} else if (major == SIMPLE && argument_size_ == 4) {
+		uint32_t bits = value;
+		float f;
+
+		std::memcpy(&f, &bits, sizeof(f));
+		number = f;
+	} else if (major == SIMPLE && argument_size_ == 8) {
+		std::memcpy(&number, &value, sizeof(number));
+	} else {
+		return;
+	}
+
+	if (statistic_key_ == recording::KEY_STATISTICS_COUNT) {
+		statistics_.count = number;
+	} else if (statistic_key_ == recording::KEY_STATISTICS_TARES) {
+		statistics_.tares = number;
+	} else if (statistic_key_ == recording::KEY_STATISTICS_MIN) {
+		statistics_.min = number;
+	} else if (statistic_key_ == recording::KEY_STATISTICS_MAX) {
+		statistics_.max = number;
+	} else if (statistic_key_ == recording::KEY_STATISTICS_MEAN) {
+		statistics_.mean = number;
+	} else if (statistic_key_ == recording::KEY_STATISTICS_STDDEV) {
+		/* The count is written first */
+		statistics_.stddev(number);
+	}
+}
+
+bool RecordingParser::text() {
+	std::string_view text{text_.data(), text_length_};
+
+	if (!capture_text_ || depth_ == 0) {
+		/* Bytes are ignored */
+	} else if (stack_[depth_ - 1].context == Context::ROOT && key_) {
+		readings_key_ = text == recording::KEY_READINGS;
+		statistics_key_ = text == recording::KEY_STATISTICS;
+	} else if (stack_[depth_ - 1].context == Context::STATISTICS) {
+		/* Keys are at even positions from the end of the map */
+		statistic_key_ = {};
+
+		for (const char *key : {recording::KEY_STATISTICS_COUNT,
+				recording::KEY_STATISTICS_TARES, recording::KEY_STATISTICS_MIN,
+				recording::KEY_STATISTICS_MAX, recording::KEY_STATISTICS_MEAN,
+				recording::KEY_STATISTICS_STDDEV}) {
+			if (stack_[depth_ - 1].remaining % 2 == 0 && text == key)
+				statistic_key_ = key;
+		}
+	} else if (stack_[depth_ - 1].context == Context::READINGS) {
+		for (uint8_t flag = Type::TARE; flag <= Type::ZERO; flag <<= 1) {
+			if (text == recording::flag_name(flag))
+				flags_ |= flag;
+		}
+	}
+
+	return complete();
+}
+
+bool RecordingParser::complete() {
+	while (depth_ > 0) {
+		Level &level = stack_[depth_ - 1];
+
+		if (level.context == Context::ROOT) {
+			if (!key_) {
+				readings_key_ = false;
+				statistics_key_ = false;
+			}
+			key_ = !key_;
+		} else if (level.context == Context::STATISTICS && level.remaining % 2 == 1) {
+			/* A value has been completed */
+			statistic_key_ = {};
+		}
+
+		if (level.remaining == INDEFINITE || --level.remaining > 0)
+			return true;
+
+		/* The container is complete, which completes an item of its parent */
+		if (level.context == Context::READINGS)
+			finished_ = true;
+		else if (level.context == Context::STATISTICS)
+			have_statistics_ = true;
+
+		depth_--;
+	}
+
+	return true;
+}
+
+} // namespace scales
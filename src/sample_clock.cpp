@@ -0,0 +1,83 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/sample_clock.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace scales {
+
+uint64_t SampleClock::update(uint64_t time_us) {
+	int64_t time_ns = time_us * 1000;
+
+	if (count_ == 0 || time_ns <= phase_ns_) {
+		count_ = 1;
+		phase_ns_ = time_ns;
+		return time_us;
+	}
+
+	int64_t elapsed_ns = time_ns - phase_ns_;
+
+	if (count_ == 1) {
+		count_ = 2;
+		period_ns_ = elapsed_ns;
+		phase_ns_ = time_ns;
+		return time_us;
+	}
+
+	int64_t periods = (elapsed_ns + period_ns_ / 2) / period_ns_;
+
+	if (periods > MAX_MISSED) {
+		/* Keep the period but not the phase */
+		phase_ns_ = time_ns;
+		return time_us;
+	} else if (periods < 1) {
+		periods = 1;
+	}
+
+	int64_t predicted_ns = phase_ns_ + periods * period_ns_;
+	int64_t error_ns = time_ns - predicted_ns;
+	uint64_t error_sq_ns = error_ns * error_ns;
+
+	phase_ns_ = predicted_ns + error_ns / (1 << PHASE_SHIFT);
+	period_ns_ += error_ns / (periods << FREQUENCY_SHIFT);
+
+	if (count_ == 2) {
+		count_ = 3;
+		jitter_sq_ns_ = error_sq_ns;
+	} else {
+		jitter_sq_ns_ = jitter_sq_ns_ - (jitter_sq_ns_ >> JITTER_SHIFT)
+			+ (error_sq_ns >> JITTER_SHIFT);
+	}
+
+	return phase_ns_ / 1000;
+}
+
+void SampleClock::reset() {
+	count_ = 0;
+	phase_ns_ = 0;
+	period_ns_ = 0;
+	jitter_sq_ns_ = 0;
+}
+
+uint32_t SampleClock::jitter_ns() const {
+	return std::sqrt((float)jitter_sq_ns_);
+}
+
+} // namespace scales
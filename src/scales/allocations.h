@@ -0,0 +1,54 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scales {
+
+/*
+ * Number of heap allocations (malloc, calloc and realloc) made by any task
+ * since boot. Requires linking with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+ */
+uint32_t allocation_count();
+
+/*
+ * Counts heap allocations made by the current task while this exists, so
+ * that allocations by other tasks at the same time aren't included. Up to
+ * MAX_TASKS tasks can be counted at once; the count is always 0 for any
+ * more than that.
+ */
+class TaskAllocations {
+public:
+	static constexpr size_t MAX_TASKS = 8;
+
+	TaskAllocations();
+	~TaskAllocations();
+
+	TaskAllocations(const TaskAllocations&) = delete;
+	TaskAllocations& operator=(const TaskAllocations&) = delete;
+
+	uint32_t count() const;
+
+private:
+	int slot_{-1};
+};
+
+} // namespace scales
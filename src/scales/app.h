@@ -24,6 +24,13 @@
 
 #include "app/app.h"
 #include "hx711.h"
+#include "telemetry_sender.h"
+#include "uploader.h"
+#if defined(SCALES_VIRTUAL_HX711)
+# include "virtual_hx711.h"
+#else
+# include "hx711_gpio.h"
+#endif
 
 namespace scales {
 
@@ -36,10 +43,20 @@ private:
 
 	static constexpr int DATA_PIN = 1;
 	static constexpr int SCK_PIN = 2;
+	static constexpr int RATE_PIN = 4;
+#elif defined(SCALES_VIRTUAL_HX711)
+	static constexpr int LED_PIN = -1;
+
+	static constexpr int DATA_PIN = -1;
+	static constexpr int SCK_PIN = -1;
+	static constexpr int RATE_PIN = -1;
 #else
 # error "Unknown board"
 #endif
 
+	/* Minimum duration of the rest of the loop to be traced */
+	static constexpr uint32_t LOOP_TRACE_MIN_US = 1000;
+
 public:
 	App();
 
@@ -49,9 +66,21 @@ public:
 	inline const std::string& immutable_id() const { return app_hash(); }
 
 	HX711& hx711() { return hx711_; }
+	Uploader& uploader() { return uploader_; }
+	TelemetrySender& telemetry() { return telemetry_; }
+#if defined(SCALES_VIRTUAL_HX711)
+	VirtualHX711& virtual_hx711() { return hx711_hardware_; }
+#endif
 
 private:
-	HX711 hx711_{DATA_PIN, SCK_PIN};
+#if defined(SCALES_VIRTUAL_HX711)
+	VirtualHX711 hx711_hardware_;
+#else
+	HX711GPIO hx711_hardware_{DATA_PIN, SCK_PIN, RATE_PIN};
+#endif
+	HX711 hx711_{hx711_hardware_};
+	Uploader uploader_{hx711_};
+	TelemetrySender telemetry_{hx711_};
 	std::unique_ptr<WebInterface> web_interface_;
 };
 
@@ -0,0 +1,48 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace scales {
+
+/*
+ * Append data to a fixed size buffer, calling flush() each time the buffer
+ * becomes full. flush() must set the length back to 0.
+ */
+template <class Flush>
+inline void buffered_write(char *buffer, size_t capacity, size_t &length,
+		const uint8_t *data, size_t size, Flush &&flush) {
+	while (size > 0) {
+		size_t available = std::min(size, capacity - length);
+
+		std::memcpy(&buffer[length], data, available);
+		length += available;
+		data += available;
+		size -= available;
+
+		if (length == capacity)
+			flush();
+	}
+}
+
+} // namespace scales
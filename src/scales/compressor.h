@@ -0,0 +1,112 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace scales {
+
+/*
+ * Lossy compression of the readings as they are made, for long recordings
+ * of a static load where nearly every reading is noise around a flat line.
+ * Only the readings needed to rebuild the others within the tolerance are
+ * kept:
+ *   Deadband keeps a reading when it differs from the last one that was
+ *   kept by more than the tolerance (rebuild by holding each value).
+ *
+ *   Swinging door keeps the previous reading when a straight line from the
+ *   last one that was kept to the current reading would no longer be
+ *   within the tolerance of all of the readings in between (rebuild by
+ *   linear interpolation).
+ *
+ * Readings with events are always kept, along with the reading before
+ * them, and a reading is kept at least every MAX_INTERVAL_US. Each reading
+ * has a constant cost.
+ *
+ * This must not depend on Arduino or ESP-IDF headers.
+ */
+class Compressor {
+public:
+	/* Keep readings this often even if they're not needed */
+	static constexpr uint64_t MAX_INTERVAL_US = 60 * 1000000ULL;
+
+	enum class Mode : uint8_t {
+		LOSSLESS,
+		DEADBAND,
+		SWINGING_DOOR,
+	};
+
+	/* Readings to keep, returned by add() */
+	enum Keep : uint8_t {
+		NONE = 0,
+		/* The previous reading, which is before the current one */
+		PREVIOUS = 1U << 0,
+		CURRENT = 1U << 1,
+	};
+
+	struct Parameters {
+		Mode mode{Mode::LOSSLESS};
+		uint32_t tolerance{0};
+	};
+
+	struct Point {
+		uint64_t time_us;
+		int32_t value;
+	};
+
+	Compressor() = default;
+	explicit Compressor(const Parameters &parameters);
+
+	/* Name used in recordings and on the console */
+	static const char *mode_name(Mode mode);
+	/* Returns false if the name is not valid */
+	static bool mode(std::string_view name, Mode &mode);
+
+	inline const Parameters& parameters() const { return parameters_; }
+	/* Start again (with new parameters) */
+	void reset(const Parameters &parameters);
+
+	/*
+	 * Returns the readings to keep, which includes the current one if it
+	 * has an event (keep is true). The previous reading is available from
+	 * previous() until the next call.
+	 */
+	uint8_t add(uint64_t time_us, int32_t value, bool keep);
+	inline const Point& previous() const { return previous_; }
+	/* Returns true if the last reading needs to be kept at the end */
+	bool flush(Point &point);
+
+private:
+	void archive(const Point &point);
+	/* Slopes of the doors from the last kept reading to the point */
+	void open(const Point &point, double &upper, double &lower) const;
+
+	Parameters parameters_;
+	bool started_{false};
+	Point archived_{0, 0};
+	bool held_{false};
+	Point last_{0, 0};
+	Point previous_{0, 0};
+	double upper_{0};
+	double lower_{0};
+};
+
+} // namespace scales
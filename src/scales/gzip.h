@@ -0,0 +1,95 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace scales {
+
+/*
+ * Streaming gzip encoder with a fixed memory footprint.
+ *
+ * Uses greedy LZ77 matching over a small window and fixed Huffman codes,
+ * which is much cheaper than zlib but still compresses repetitive XML and
+ * delta encoded readings well.
+ */
+class GzipEncoder {
+public:
+	using output_function = std::function<void(const uint8_t *data, size_t length)>;
+
+	static constexpr size_t WINDOW_SIZE = 4096;
+
+	GzipEncoder(output_function output);
+
+	/* Start a new stream, reusing the existing memory */
+	void reset(output_function output);
+	void write(const uint8_t *data, size_t length);
+	void finish();
+
+	inline size_t input_bytes() const { return input_bytes_; }
+	inline size_t output_bytes() const { return output_bytes_; }
+
+	/* Returns true if the Accept-Encoding header value allows gzip */
+	static bool accepted(std::string_view accept_encoding);
+
+private:
+	static constexpr size_t BUFFER_SIZE = WINDOW_SIZE * 2;
+	static constexpr size_t HASH_BITS = 12;
+	static constexpr size_t HASH_SIZE = 1U << HASH_BITS;
+	static constexpr unsigned int MAX_CHAIN = 16;
+	static constexpr unsigned int MIN_MATCH = 3;
+	static constexpr unsigned int MAX_MATCH = 258;
+	static constexpr size_t OUTPUT_SIZE = 256;
+
+	static inline unsigned int hash(const uint8_t *data) {
+		return ((data[0] << 8) ^ (data[1] << 4) ^ data[2]) & (HASH_SIZE - 1);
+	}
+
+	void compress(bool flush);
+	void insert(size_t pos);
+	void shift_window();
+	unsigned int longest_match(size_t pos, size_t &distance);
+
+	void put_bits(uint32_t value, unsigned int bits);
+	void put_huffman(uint32_t code, unsigned int bits);
+	void put_literal(unsigned int literal);
+	void put_match(unsigned int length, unsigned int distance);
+	void put_byte(uint8_t value);
+	void flush_output();
+
+	output_function output_;
+	uint8_t buffer_[BUFFER_SIZE];
+	uint16_t head_[HASH_SIZE]{};
+	uint16_t prev_[BUFFER_SIZE]{};
+	size_t pos_{0};
+	size_t end_{0};
+	uint32_t bit_buffer_{0};
+	unsigned int bit_count_{0};
+	uint8_t out_[OUTPUT_SIZE];
+	size_t out_len_{0};
+	uint32_t crc_{0};
+	size_t input_bytes_{0};
+	size_t output_bytes_{0};
+	bool finished_{false};
+};
+
+} // namespace scales
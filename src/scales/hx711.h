@@ -20,39 +20,99 @@
 
 #include <Arduino.h>
 
+#include <array>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <sys/time.h>
+#include <vector>
 
 #include <uuid/log.h>
 
+#include "compressor.h"
+#include "hx711_hardware.h"
+#include "recording.h"
+#include "recording_parser.h"
+#include "sample_clock.h"
+#include "segment_pool.h"
+#include "session.h"
+#include "step_detector.h"
+
 namespace scales {
 
-enum Type : uint8_t {
-    READING = 0,
-    TARE = 1,
-};
+class HX711 {
+public:
+    /* Leave some PSRAM for everything else when sizing the buffer automatically */
+    static constexpr size_t BUFFER_RESERVE_BYTES = 512 * 1024;
+    /* Record the wall clock time this often so that drift can be corrected */
+    static constexpr uint64_t ANCHOR_INTERVAL_US = 60 * 1000000ULL;
+    /* Number of recent events to keep */
+    static constexpr size_t MAX_EVENTS = 16;
+    /* Tare with the mean of the unsettled readings after waiting this long */
+    static constexpr uint64_t TARE_TIMEOUT_US = 5 * 1000000ULL;
+    /* Minimum time between automatic zero tracking adjustments */
+    static constexpr uint64_t ZERO_INTERVAL_US = 1000000ULL;
+    /* Ignore zero tracking changes smaller than the noise divided by this */
+    static constexpr uint32_t ZERO_NOISE_DIVISOR = 8;
+    /* Conversion rates that can be selected with the RATE pin */
+    static constexpr unsigned int SLOW_RATE_HZ = 10;
+    static constexpr unsigned int FAST_RATE_HZ = 80;
+    /* Minimum step detection window when it's scaled for a slower rate */
+    static constexpr unsigned int MIN_STEP_WINDOW = 4;
+    /* Number of recent readings to keep for streaming */
+    static constexpr size_t LIVE_READINGS = 128;
+    /* Minimum length of a file of a continuous recording, so that they all have different names */
+    static constexpr uint64_t MIN_ROTATION_US = 2 * 1000000ULL;
+    static constexpr uint32_t SAVE_STACK_SIZE = 6144;
 
-struct Data {
-    uint32_t time_us;
-    uint32_t type:8;
-    uint32_t value:24;
-};
+    /* Updated without locking so that they can be read at any time */
+    struct Stats {
+        std::atomic<uint32_t> samples{0};
+        std::atomic<uint32_t> invalid_reads{0};
+        std::atomic<uint32_t> late_reads{0};
+        std::atomic<uint32_t> dropped_readings{0};
+        std::atomic<uint32_t> period_ns{0};
+        std::atomic<uint32_t> jitter_ns{0};
 
-class MemoryDeleter {
-public:
-        void operator()(Data *data) { ::free(data); }
-};
+        std::atomic<uint32_t> saves{0};
+        std::atomic<uint32_t> save_errors{0};
+        std::atomic<uint32_t> save_bytes{0};
+        std::atomic<uint32_t> save_bytes_total{0};
+        std::atomic<uint32_t> save_us{0};
+        std::atomic<uint32_t> save_ms_total{0};
+        std::atomic<uint32_t> rotations{0};
+    };
 
-using MemoryAllocation = std::unique_ptr<Data, MemoryDeleter>;
+    /*
+     * Split recordings into several files after a number of minutes or
+     * readings (0 for no limit, and both 0 to disable continuous recording)
+     */
+    struct Rotation {
+        unsigned int minutes{0};
+        unsigned long readings{0};
+    };
 
-class HX711 {
-public:
-    static constexpr unsigned long BUFFER_SIZE = 90 * 900; /* 88.5Hz for 900s */
+    /* Detected step in the readings */
+    struct Event {
+        struct timeval realtime;
+        uint8_t type;           /* StepDetector::APPLIED, REMOVED or SETTLED */
+        int32_t level;          /* Relative to the tare */
+        int32_t step;
+        uint32_t settling_ms;
+    };
 
-	HX711(int data_pin, int sck_pin);
+    /* Recent reading (or tare value), whether it's being recorded or not */
+    struct LiveReading {
+        uint64_t time_us;
+        int32_t tare_value;     /* Before this entry */
+        Data data;              /* Relative to the previous entry */
+    };
+
+	HX711(HX711Hardware &hardware);
 
 	void init();
 	void loop();
@@ -60,21 +120,98 @@ public:
     int32_t reading();
 
     void start();
+    /* Tare with the settled level, when the readings are stable */
     void tare();
+    /* Range from the tare value to follow drift within while settled (0 to disable) */
+    int32_t zero_tracking() const;
+    void zero_tracking(int32_t range);
     inline bool running() const { std::lock_guard lock{mutex_}; return running_; }
     inline struct timeval realtime_us() const { std::lock_guard lock{mutex_}; return realtime_us_; }
     inline uint64_t start_us() const { std::lock_guard lock{mutex_}; return start_us_; }
     uint64_t duration_us() const;
-    inline unsigned long count() const { std::lock_guard lock{mutex_}; return buffer_pos_; }
+    inline unsigned long count() const { std::lock_guard lock{mutex_}; return session_->count(); }
     inline bool has_tare() const { std::lock_guard lock{mutex_}; return buffer_tare_; }
-    inline unsigned long max_count() const { return BUFFER_SIZE; }
+    /* Statistics of the readings in the current (or last) recording */
+    inline recording::Statistics statistics() const { std::lock_guard lock{mutex_}; return session_->statistics; }
+    /* Maximum number of readings in the current (or next) recording */
+    unsigned long max_count() const;
+    /* Maximum duration of the current (or next) recording at the current sample rate */
+    uint64_t max_duration_us() const;
+    /* Total size of the buffer */
+    size_t buffer_bytes() const { std::lock_guard lock{mutex_}; return pool_.segments() * SegmentPool::SEGMENT_BYTES; }
+    /* Number of recordings held in the buffer */
+    inline size_t resident_count() const { std::lock_guard lock{mutex_}; return resident_.size(); }
+    inline const Stats& stats() const { return stats_; }
+    /* Recent events, most recent first */
+    void events(std::function<void(const Event &event)> func) const;
+    /*
+     * The window is the number of readings at FAST_RATE_HZ, which is scaled
+     * for the current rate so that it covers the same length of time
+     */
+    StepDetector::Parameters step_parameters() const;
+    void step_parameters(const StepDetector::Parameters &parameters);
+    /* Nominal conversion rate */
+    inline unsigned int rate() const { std::lock_guard lock{mutex_}; return rate_hz_; }
+    /* The rate can be selected because the RATE pin is connected */
+    inline bool rate_selectable() const { std::lock_guard lock{mutex_}; return rate_selectable_; }
+    /* Select and save the conversion rate, which can't be changed while recording */
+    bool rate(unsigned int rate_hz);
+    /* Lossy compression of the next recording */
+    Compressor::Parameters compression() const;
+    /* Set and save the compression, which can't be changed while recording */
+    bool compression(const Compressor::Parameters &parameters);
+    Rotation rotation() const;
+    /* Set and save the rotation, which applies to the current recording */
+    void rotation(const Rotation &rotation);
+    /*
+     * Copy recent readings from index onwards, returning the number copied.
+     * If some of them have already been replaced then index is advanced to
+     * the oldest one that is available.
+     */
+    size_t live_readings(uint32_t &index, LiveReading *readings, size_t max) const;
+    /* Index of the next live reading */
+    inline uint32_t live_index() const { std::lock_guard lock{mutex_}; return live_index_; }
+    inline uint64_t now_us() const { return hardware_.now_us(); }
+    /* Returns true if the readings have settled, with the level relative to the tare */
+    bool settled(int32_t &level, uint32_t &noise) const;
     void stop();
 
-    void list_files(std::function<void(const std::string &filename, const std::string &timestamp)> func);
+    /*
+     * Recordings in memory that haven't been saved yet are listed first. The
+     * statistics are nullptr if they're not in the recording or they weren't
+     * requested (which avoids reading the start of every file).
+     */
+    void list_files(std::function<void(std::string_view filename, std::string_view timestamp,
+        bool resident, const recording::Statistics *statistics)> func,
+        bool statistics = false);
+    /* Returns a recording held in memory, which remains valid while it is referenced */
+    std::shared_ptr<const Session> resident_file(const std::string_view filename);
     bool file_exists(const std::string_view filename);
+    /* Returns true if a file of a continuous recording exists but can't be read yet */
+    bool file_pending(const std::string_view filename);
     std::string file_name(const std::string &filename, bool safe);
-    void get_file(const std::string_view filename, Stream &output);
+    /* Returns the filename itself if it's not a timestamp */
+    static std::string_view file_name(const std::string_view filename, bool safe,
+        char *buffer, size_t size);
+    size_t get_file(const std::string_view filename, Stream &output,
+        std::function<void(size_t size)> open_func = {});
+    /*
+     * Read part of a saved recording, returning the number of bytes read and
+     * the size of the file. Returns 0 with a size of 0 if the recording
+     * hasn't been saved. The file is only open while reading.
+     */
+    size_t read_file(const std::string_view filename, size_t offset,
+        uint8_t *buffer, size_t length, size_t &size);
+    /*
+     * Call func for each reading of a recording, or of the current recording
+     * if the filename is empty. Returns false if the recording doesn't exist
+     * or is invalid.
+     */
+    bool read_readings(const std::string_view filename,
+        RecordingParser::reading_function func);
     void delete_file(const std::string_view filename);
+    unsigned int delete_files(const std::vector<std::string_view> &filenames);
+    unsigned int delete_all_files();
 
 protected:
     static uuid::log::Logger logger_;
@@ -83,11 +220,63 @@ private:
     static constexpr unsigned long EPOCH_S = 1735689600;
     static constexpr const char *DIRECTORY_NAME = "/readings";
     static constexpr const char *FILENAME_EXT = ".cbor";
+    static constexpr size_t PATH_SIZE = 64;
+    /* Readings copied at a time from the current recording */
+    static constexpr size_t COPY_READINGS = 64;
+    /* Maximum length of the header to read to find the statistics */
+    static constexpr size_t HEADER_BYTES = 1024;
+    static constexpr const char *RATE_FILENAME = "/hx711_rate";
+    static constexpr const char *COMPRESSION_FILENAME = "/hx711_compression";
+    static constexpr const char *ROTATION_FILENAME = "/hx711_rotation";
+
+    using FilePath = std::array<char,PATH_SIZE>;
 
-    void save();
+    static std::string session_filename(const Session &session);
+    /*
+     * Encode the recording in memory so that it can be kept resident. The
+     * mutex must be held if it's locked, otherwise only while evicting.
+     */
+    bool encode(Session &session, bool locked = true);
+    bool save(const Session &session);
+    bool append(const Data &data);
+    /* Append the reading (and tare value) if they're kept by the compressor */
+    bool record(uint64_t now_us, uint8_t events, uint8_t adjustment, int32_t value);
+    void add_live(uint64_t now_us, const Data &data);
+    void add_anchor();
+    /* Keep the last reading if it was held back by the compressor */
+    void keep_last();
+    /* Record the details of the current recording in its session */
+    void finish_session(uint64_t stop_us);
+    /* Returns true if it's time to continue the recording in a new file */
+    bool rotation_due(uint64_t now_us) const;
+    /* Continue the recording in a new file, saving the previous one in the background */
+    void rotate();
+    static void save_task(void *arg);
+    /* Save the files that have been rotated */
+    void save_rotated();
+    void add_event(uint64_t now_us, uint8_t type);
+    /* Returns Type::TARE or Type::ZERO if the tare value has been changed */
+    uint8_t adjust_tare(uint64_t now_us);
+    /* Remove the oldest saved recording from memory */
+    bool evict_session();
+    unsigned long evictable_segments() const;
+    bool remove_resident(const std::string_view filename);
+    bool read_current(RecordingParser::reading_function &func);
+    /* Returns false if the filename isn't the name of a file in the directory */
+    static bool file_path(const std::string_view filename, FilePath &path);
+    /* The file mutex must be held */
+    static bool file_statistics(const char *path, recording::Statistics &statistics);
+    /* Returns FAST_RATE_HZ if the rate hasn't been saved */
+    static unsigned int load_rate();
+    static void save_rate(unsigned int rate_hz);
+    /* Returns lossless compression if it hasn't been saved */
+    static Compressor::Parameters load_compression();
+    static void save_compression(const Compressor::Parameters &parameters);
+    static Rotation load_rotation();
+    static void save_rotation(const Rotation &rotation);
+    StepDetector::Parameters rate_step_parameters() const;
 
-    const int data_pin_;
-    const int sck_pin_;
+    HX711Hardware &hardware_;
 
     mutable std::mutex mutex_;
     int32_t reading_{0};
@@ -95,11 +284,42 @@ private:
     struct timeval realtime_us_{0, 0};
     uint64_t start_us_{0};
     uint64_t stop_us_{0};
-    MemoryAllocation buffer_;
-    unsigned long buffer_pos_{0};
+    uint64_t previous_us_{0};
+    uint64_t anchor_us_{0};
+    SegmentPool pool_;
+    std::shared_ptr<Session> session_;
+    std::deque<std::shared_ptr<Session>> resident_;
+    bool buffer_full_{false};
     bool buffer_tare_{false};
     bool running_{false};
     bool tare_{false};
+    uint64_t tare_us_{0};
+    int32_t zero_range_{0};
+    uint64_t zero_us_{0};
+    uint64_t last_read_us_{0};
+    unsigned int rate_hz_{FAST_RATE_HZ};
+    bool rate_selectable_{false};
+    /* The sample clock needs to be reset (which is only accessed from loop()) */
+    std::atomic<bool> rate_changed_{false};
+    SampleClock clock_;
+    StepDetector::Parameters step_parameters_;
+    StepDetector detector_;
+    Compressor::Parameters compression_;
+    Compressor compressor_;
+    Rotation rotation_;
+    /* Files of a continuous recording waiting to be saved */
+    std::deque<std::shared_ptr<Session>> rotated_;
+    TaskHandle_t save_task_{nullptr};
+    /* Changed when a recording file is deleted or replaced (with the file mutex held) */
+    std::atomic<uint32_t> file_generation_{0};
+    std::array<Event,MAX_EVENTS> events_{};
+    size_t events_pos_{0};
+    size_t events_count_{0};
+    std::array<LiveReading,LIVE_READINGS> live_{};
+    uint32_t live_index_{0};
+    uint64_t live_previous_us_{0};
+    int32_t live_tare_value_{0};
+    Stats stats_;
 };
 
 } // namespace scales
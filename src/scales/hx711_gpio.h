@@ -0,0 +1,59 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "hx711_hardware.h"
+
+namespace scales {
+
+/*
+ * The falling edge of the data pin is timestamped in an interrupt handler
+ * so that the time a conversion became ready doesn't depend on how quickly
+ * it's polled.
+ */
+class HX711GPIO: public HX711Hardware {
+public:
+	/* The rate pin is optional (-1 if it's not connected) */
+	HX711GPIO(int data_pin, int sck_pin, int rate_pin = -1);
+
+	void init() override;
+	bool data() override;
+	void sck(bool level) override;
+	void delay_us(uint32_t us) override;
+	uint64_t now_us() override;
+	void disable_interrupts() override;
+	void enable_interrupts() override;
+	uint64_t ready_us() override;
+	bool select_rate(unsigned int rate_hz) override;
+
+private:
+	static void data_interrupt(void *arg);
+
+	const int data_pin_;
+	const int sck_pin_;
+	const int rate_pin_;
+	/* Lower 32 bits of the time, which can be read and written atomically */
+	std::atomic<uint32_t> edge_us_{0};
+	uint32_t read_us_{0};
+};
+
+} // namespace scales
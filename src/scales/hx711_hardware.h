@@ -0,0 +1,82 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace scales {
+
+/*
+ * Access to the HX711 data and clock pins and the time source used for
+ * readings, so that the HX711 can be replaced by an emulator.
+ */
+class HX711Hardware {
+public:
+	virtual ~HX711Hardware() = default;
+
+	virtual void init() = 0;
+	virtual bool data() = 0;
+	virtual void sck(bool level) = 0;
+	virtual void delay_us(uint32_t us) = 0;
+	virtual uint64_t now_us() = 0;
+	virtual void disable_interrupts() = 0;
+	virtual void enable_interrupts() = 0;
+
+	/*
+	 * Time that the current conversion became ready, if that's known more
+	 * accurately than the time it was found to be ready
+	 */
+	virtual uint64_t ready_us() { return now_us(); }
+
+	/*
+	 * Select the conversion rate (10 or 80 Hz) using the RATE pin, returning
+	 * false if it isn't connected
+	 */
+	virtual bool select_rate(unsigned int /* rate_hz */) { return false; }
+
+	/* A conversion is ready to be read when the data pin is low */
+	inline bool ready() { return !data(); }
+
+	/*
+	 * Clock out a conversion and select channel A with gain 128 for the
+	 * next conversion. The 24-bit value is in bits 1 to 24 and bit 0 is
+	 * the state of the data pin after the 25th clock pulse, which must
+	 * be high.
+	 */
+	uint32_t read() {
+		uint32_t value = 0;
+
+		delay_us(1); // T1
+
+		disable_interrupts();
+		for (int i = 0; i < 25; i++) {
+			sck(true);
+			delay_us(1); // T2 & T3
+			value |= data() ? 1 : 0;
+			value <<= 1;
+			sck(false);
+			delay_us(1); // T4
+		}
+		enable_interrupts();
+
+		return value >> 1;
+	}
+};
+
+} // namespace scales
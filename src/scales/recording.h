@@ -0,0 +1,269 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Recording format definitions shared between the firmware and the host
+ * tools in readings/. This must not depend on Arduino or ESP-IDF headers.
+ *
+ * A recording is a CBOR map (with the self-describe tag) containing:
+ *   "realtime_s_us": [seconds, microseconds] wall clock time at start
+ *   "start_us": monotonic time at start
+ *   "stop_us": monotonic time at stop
+ *   "period_ns": estimated conversion period (optional)
+ *   "jitter_ns": RMS error in measuring the conversion times, which
+ *                have been corrected for it (optional)
+ *   "rate_hz": nominal conversion rate selected with the RATE pin
+ *              (optional, the period is more accurate)
+ *   "compression": {"mode": text, "tolerance": uint} lossy compression
+ *                  of the readings, where only readings that are needed
+ *                  to rebuild the others within the tolerance have been
+ *                  kept (optional, "deadband" or "swinging_door")
+ *   "segment": {"index": uint, "previous": text, "next": text} position
+ *              of this file in a continuous recording that has been
+ *              split into several files, with the filenames of the files
+ *              before and after it (optional, and so are "previous" and
+ *              "next"); each file starts when the previous one stops, at
+ *              the time of its last reading
+ *   "anchors": [[realtime_us, offset_us], ...] wall clock time in
+ *              microseconds at offsets from the start, recorded
+ *              periodically so that clock drift can be corrected
+ *              (optional, before "readings")
+ *   "readings_format": READINGS_FORMAT
+ *   "statistics": {"count": uint, "tares": uint, "min": int, "max": int,
+ *                  "mean": float, "stddev": float} of the reading values
+ *                 (optional, before "anchors" so that it can be read
+ *                 without reading the whole file), which includes
+ *                 readings that were not kept by lossy compression
+ *   "readings": indefinite array of readings, each one being optional
+ *               flags (text) and tare value ([int]) followed by the time
+ *               offset (uint) and the value offset (int) from the
+ *               previous reading; the flags are "tare" and "zero" (with
+ *               the new tare value) and the events "applied", "removed"
+ *               and "settled" on the reading where they were detected
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace scales {
+
+/* Flags for a reading, which can be combined */
+enum Type : uint8_t {
+    READING = 0,
+    TARE = 1U << 0,
+    APPLIED = 1U << 1,
+    REMOVED = 1U << 2,
+    SETTLED = 1U << 3,
+    ZERO = 1U << 4,
+    /* The entry is the new tare value for the next reading, not a reading */
+    TARE_VALUE = 1U << 7,
+};
+
+/* Buffer entry for a reading, with the time relative to the previous reading */
+struct Data {
+    uint32_t offset_us;
+    uint32_t type:8;
+    uint32_t value:24;
+};
+
+namespace recording {
+
+constexpr const char *KEY_REALTIME_S_US = "realtime_s_us";
+constexpr const char *KEY_START_US = "start_us";
+constexpr const char *KEY_STOP_US = "stop_us";
+constexpr const char *KEY_PERIOD_NS = "period_ns";
+constexpr const char *KEY_JITTER_NS = "jitter_ns";
+constexpr const char *KEY_RATE_HZ = "rate_hz";
+constexpr const char *KEY_COMPRESSION = "compression";
+constexpr const char *KEY_SEGMENT = "segment";
+constexpr const char *KEY_ANCHORS = "anchors";
+constexpr const char *KEY_READINGS_FORMAT = "readings_format";
+constexpr const char *KEY_READINGS = "readings";
+constexpr const char *KEY_STATISTICS = "statistics";
+
+constexpr const char *KEY_STATISTICS_COUNT = "count";
+constexpr const char *KEY_STATISTICS_TARES = "tares";
+constexpr const char *KEY_STATISTICS_MIN = "min";
+constexpr const char *KEY_STATISTICS_MAX = "max";
+constexpr const char *KEY_STATISTICS_MEAN = "mean";
+constexpr const char *KEY_STATISTICS_STDDEV = "stddev";
+
+constexpr const char *KEY_COMPRESSION_MODE = "mode";
+constexpr const char *KEY_COMPRESSION_TOLERANCE = "tolerance";
+
+constexpr const char *KEY_SEGMENT_INDEX = "index";
+constexpr const char *KEY_SEGMENT_PREVIOUS = "previous";
+constexpr const char *KEY_SEGMENT_NEXT = "next";
+
+constexpr std::array<const char *,4> READINGS_FORMAT{
+    "[flags:text]",
+    "[tare_value:[int]]",
+    "<offset_time_us:uint>",
+    "<offset_value:int>",
+};
+
+/*
+ * Recordings made before tare values were recorded, where the tare value
+ * is the value of the reading with the "tare" flag.
+ */
+constexpr std::array<const char *,3> LEGACY_READINGS_FORMAT{
+    "[flags:text]",
+    "<offset_time_us:uint>",
+    "<offset_value:int>",
+};
+
+constexpr const char *FLAG_TARE = "tare";
+/* Events detected by StepDetector */
+constexpr const char *FLAG_APPLIED = "applied";
+constexpr const char *FLAG_REMOVED = "removed";
+constexpr const char *FLAG_SETTLED = "settled";
+/* Automatic zero tracking adjusted the tare value */
+constexpr const char *FLAG_ZERO = "zero";
+
+/* Name of a single event flag */
+constexpr inline const char *flag_name(uint8_t type) {
+    switch (type) {
+    case Type::TARE: return FLAG_TARE;
+    case Type::APPLIED: return FLAG_APPLIED;
+    case Type::REMOVED: return FLAG_REMOVED;
+    case Type::SETTLED: return FLAG_SETTLED;
+    case Type::ZERO: return FLAG_ZERO;
+    default: return "";
+    }
+}
+
+/*
+ * Statistics of the reading values in a recording, updated as readings are
+ * made using Welford's algorithm so that they don't need a full decode.
+ */
+struct Statistics {
+    uint32_t count{0};
+    /* Number of times the recording was tared */
+    uint32_t tares{0};
+    int32_t min{0};
+    int32_t max{0};
+    double mean{0};
+    /* Sum of squared differences from the mean */
+    double m2{0};
+
+    inline void add(int32_t value) {
+        if (count == 0) {
+            min = max = value;
+        } else {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+
+        count++;
+
+        double delta = value - mean;
+
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    /* Sample standard deviation */
+    inline double stddev() const {
+        return count > 1 ? std::sqrt(m2 / (count - 1)) : 0;
+    }
+
+    /* Restore from a standard deviation that was written to a recording */
+    inline void stddev(double value) {
+        m2 = count > 1 ? value * value * (count - 1) : 0;
+    }
+};
+
+/* Convert a raw 24-bit reading to a signed value */
+constexpr inline int32_t sign_extend(uint32_t value) {
+    return static_cast<int32_t>(((value & 0x800000) ? 0xFF000000 : 0) | (value & 0xFFFFFF));
+}
+
+/*
+ * Buffer entry for a reading, with the time relative to the previous reading
+ * (or the start) so that recordings are not limited to 2^32 microseconds.
+ * Corrected times can be slightly before the previous time.
+ */
+constexpr inline Data make_data(uint64_t now_us, uint64_t previous_us, uint8_t flags, int32_t value) {
+    return {
+        static_cast<uint32_t>(now_us > previous_us
+            ? std::min(now_us - previous_us, (uint64_t)UINT32_MAX) : 0),
+        flags,
+        static_cast<uint32_t>(value) & 0xFFFFFF,
+    };
+}
+
+/* Buffer entry for a new tare value, which applies from the next reading */
+constexpr inline Data make_tare_data(uint8_t flags, int32_t value) {
+    return {
+        0,
+        static_cast<uint8_t>(flags | Type::TARE_VALUE),
+        static_cast<uint32_t>(value) & 0xFFFFFF,
+    };
+}
+
+/*
+ * Write the contents of the readings array. The writer must provide
+ * beginArray(), writeUnsignedInt() and writeInt(), and
+ * write_text(writer, text) is used to write flags.
+ *
+ * Readings can be written in several parts by passing the value returned
+ * from the previous call as previous_value.
+ */
+template <class Writer, class WriteText>
+inline int32_t write_readings(Writer &writer, WriteText &&write_text,
+        const Data *data, size_t count, int32_t previous_value = 0) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = sign_extend(data[i].value);
+
+        if (data[i].type != Type::READING) {
+            for (uint8_t flag = Type::TARE; flag <= Type::ZERO; flag <<= 1) {
+                if (data[i].type & flag)
+                    write_text(writer, flag_name(flag));
+            }
+
+            if (data[i].type & Type::TARE_VALUE) {
+                writer.beginArray(1);
+                writer.writeInt(value);
+                continue;
+            }
+        }
+
+        writer.writeUnsignedInt(data[i].offset_us);
+        writer.writeInt(value - previous_value);
+        previous_value = value;
+    }
+
+    return previous_value;
+}
+
+/*
+ * Format the timestamp in a recording filename as a date and time, or
+ * return the filename itself if it's not a timestamp.
+ */
+std::string_view file_name(std::string_view filename, bool safe,
+    char *buffer, size_t size);
+
+} // namespace recording
+
+} // namespace scales
@@ -0,0 +1,123 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "recording.h"
+
+namespace scales {
+
+/*
+ * Incremental parser for the readings in a recording, which can be given
+ * the recording in pieces of any size so that it doesn't need to be in
+ * memory all at once. Everything other than the readings and statistics
+ * is skipped.
+ *
+ * This must not depend on Arduino or ESP-IDF headers.
+ */
+class RecordingParser {
+public:
+	/* Readings have the time from the start of the recording and the Type flags */
+	using reading_function = std::function<void(uint64_t time_us, int32_t value, uint8_t flags)>;
+
+	explicit RecordingParser(reading_function func = nullptr);
+
+	void reset();
+	/* Returns false if the data isn't a valid recording, after which everything is ignored */
+	bool parse(const uint8_t *data, size_t length);
+
+	/* The end of the readings has been reached */
+	inline bool finished() const { return finished_; }
+	inline bool failed() const { return failed_; }
+	/* The start of the readings has been reached, so the header is complete */
+	inline bool readings() const { return readings_; }
+	/* Returns nullptr if the statistics haven't been parsed (yet) */
+	inline const recording::Statistics* statistics() const {
+		return have_statistics_ ? &statistics_ : nullptr;
+	}
+
+private:
+	static constexpr size_t MAX_DEPTH = 8;
+	static constexpr size_t TEXT_SIZE = 16;
+	static constexpr uint64_t INDEFINITE = UINT64_MAX;
+
+	enum class State : uint8_t {
+		HEAD,
+		ARGUMENT,
+		STRING,
+	};
+
+	enum class Context : uint8_t {
+		ROOT,
+		READINGS,
+		STATISTICS,
+		SKIP,
+	};
+
+	struct Level {
+		Context context;
+		uint64_t remaining;
+	};
+
+	bool head(uint8_t major, uint64_t value, bool indefinite);
+	bool scalar(uint8_t major, uint64_t value);
+	void statistic(uint8_t major, uint64_t value);
+	bool text();
+	bool complete();
+	inline bool fail() { failed_ = true; return false; }
+
+	reading_function func_;
+
+	State state_{State::HEAD};
+	uint8_t major_{0};
+	unsigned int argument_bytes_{0};
+	unsigned int argument_size_{0};
+	uint64_t argument_{0};
+	uint64_t string_remaining_{0};
+	bool capture_text_{false};
+	std::array<char,TEXT_SIZE> text_{};
+	size_t text_length_{0};
+
+	std::array<Level,MAX_DEPTH> stack_{};
+	size_t depth_{0};
+	bool key_{false};
+	bool readings_key_{false};
+	bool statistics_key_{false};
+	std::string_view statistic_key_;
+
+	uint64_t time_us_{0};
+	int32_t value_{0};
+	uint8_t flags_{0};
+	bool have_offset_{false};
+	uint64_t offset_us_{0};
+
+	recording::Statistics statistics_;
+	bool have_statistics_{false};
+
+	bool readings_{false};
+	bool finished_{false};
+	bool failed_{false};
+};
+
+} // namespace scales
@@ -0,0 +1,62 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace scales {
+
+/*
+ * Tracks the HX711 conversion clock with a second order phase-locked loop
+ * so that sample times can be corrected for the jitter in measuring when
+ * each conversion became ready.
+ *
+ * The phase follows the measured times with a gain of 1/8 and the period
+ * is adjusted by 1/256 of the phase error. Missed conversions are allowed
+ * for by rounding to the nearest whole number of periods.
+ *
+ * This must not depend on Arduino or ESP-IDF headers.
+ */
+class SampleClock {
+public:
+	/* Resynchronise instead of assuming that conversions were missed */
+	static constexpr unsigned int MAX_MISSED = 16;
+
+	/* Returns the corrected time of a conversion measured at time_us */
+	uint64_t update(uint64_t time_us);
+	/* Start again, e.g. because the conversion rate has changed */
+	void reset();
+
+	/* Estimated conversion period, or 0 if not known yet */
+	inline uint32_t period_ns() const { return count_ >= 2 ? period_ns_ : 0; }
+	/* RMS difference between the measured and predicted times */
+	uint32_t jitter_ns() const;
+
+private:
+	static constexpr int PHASE_SHIFT = 3;
+	static constexpr int FREQUENCY_SHIFT = 8;
+	static constexpr int JITTER_SHIFT = 6;
+
+	unsigned int count_{0};
+	int64_t phase_ns_{0};
+	int64_t period_ns_{0};
+	uint64_t jitter_sq_ns_{0};
+};
+
+} // namespace scales
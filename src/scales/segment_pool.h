@@ -0,0 +1,82 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "recording.h"
+
+namespace scales {
+
+class MemoryDeleter {
+public:
+	void operator()(Data *data) { ::free(data); }
+};
+
+using MemoryAllocation = std::unique_ptr<Data, MemoryDeleter>;
+
+/*
+ * Fixed size segments of readings allocated from a single block of memory,
+ * so that recordings can grow without a fixed maximum and several of them
+ * can be kept in memory at once.
+ *
+ * Segments can be allocated and released from any task, but the contents of
+ * a segment must only be used by its owner.
+ */
+class SegmentPool {
+public:
+	using Index = uint16_t;
+
+	static constexpr size_t SEGMENT_READINGS = 4096;
+	static constexpr size_t SEGMENT_BYTES = SEGMENT_READINGS * sizeof(Data);
+	static constexpr Index NONE = UINT16_MAX;
+
+	/*
+	 * Allocate up to max_bytes of PSRAM for the pool, or all of the largest
+	 * free block (less reserve_bytes) if max_bytes is 0.
+	 */
+	bool init(size_t max_bytes, size_t reserve_bytes);
+	/* Use memory allocated by the caller (e.g. on the host) for the segments */
+	bool init(MemoryAllocation memory, size_t segments);
+
+	inline size_t segments() const { return segments_; }
+	size_t free_segments() const;
+
+	/* Returns NONE if there are no free segments */
+	Index allocate();
+	void release(Index index);
+
+	inline Data *segment(Index index) { return memory_.get() + index * SEGMENT_READINGS; }
+	inline const Data *segment(Index index) const { return memory_.get() + index * SEGMENT_READINGS; }
+	inline uint8_t *bytes(Index index) { return reinterpret_cast<uint8_t*>(segment(index)); }
+	inline const uint8_t *bytes(Index index) const { return reinterpret_cast<const uint8_t*>(segment(index)); }
+
+private:
+	mutable std::mutex mutex_;
+	MemoryAllocation memory_;
+	size_t segments_{0};
+	std::vector<Index> free_;
+};
+
+} // namespace scales
@@ -0,0 +1,141 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+#include "compressor.h"
+#include "recording.h"
+#include "segment_pool.h"
+
+namespace scales {
+
+/* Readings of one recording, stored in segments from a pool */
+class Session {
+public:
+	/* Wall clock time at a point in the recording */
+	struct Anchor {
+		uint64_t realtime_us;
+		uint64_t offset_us;
+	};
+
+	/* Position in a continuous recording that has been split into several files */
+	struct Chain {
+		unsigned long index{0};
+		std::string previous;   /* Filename of the previous file (if any) */
+		std::string next;       /* Filename of the next file (if any) */
+	};
+
+	explicit Session(SegmentPool &pool) : pool_(&pool) {}
+	~Session();
+
+	Session(Session &&other) noexcept;
+	Session& operator=(Session &&other) noexcept;
+	Session(const Session&) = delete;
+	Session& operator=(const Session&) = delete;
+
+	inline unsigned long count() const { return count_; }
+	/* Number of segments used from the pool */
+	inline size_t segments() const { return segments_.size() + encoded_.size(); }
+
+	/* Returns false if there are no free segments in the pool */
+	bool append(const Data &data);
+	/* Remove all readings and release the segments */
+	void clear();
+	/*
+	 * Release the segments used by the readings once they're no longer
+	 * needed, without changing count(). for_each() will return nothing.
+	 */
+	void release_readings();
+
+	/*
+	 * Returns the number of bytes appended, which is less than size if
+	 * there are no free segments in the pool
+	 */
+	size_t append_encoded(const uint8_t *data, size_t size);
+	/* Remove the encoded recording and release its segments */
+	void clear_encoded();
+	inline size_t encoded_size() const { return encoded_size_; }
+
+	/* Call func(const Data *data, size_t count) for each segment in order */
+	template <class Function>
+	void for_each(Function &&func) const {
+		unsigned long remaining = count_;
+
+		for (auto index : segments_) {
+			size_t count = std::min(remaining, (unsigned long)SegmentPool::SEGMENT_READINGS);
+
+			func(pool_->segment(index), count);
+			remaining -= count;
+		}
+	}
+
+	/*
+	 * Copy up to count readings from position start, returning the number
+	 * copied. Nothing is copied after the readings have been released.
+	 */
+	size_t copy(unsigned long start, Data *data, size_t count) const;
+
+	/* Call func(const uint8_t *data, size_t size) for each encoded segment in order */
+	template <class Function>
+	void for_each_encoded(Function &&func) const {
+		size_t remaining = encoded_size_;
+
+		for (auto index : encoded_) {
+			size_t size = std::min(remaining, SegmentPool::SEGMENT_BYTES);
+
+			func(pool_->bytes(index), size);
+			remaining -= size;
+		}
+	}
+
+	struct timeval realtime_us{0, 0};
+	uint64_t start_us{0};
+	uint64_t stop_us{0};
+	uint32_t period_ns{0};
+	uint32_t jitter_ns{0};
+	/* Nominal conversion rate (0 if unknown) */
+	unsigned int rate_hz{0};
+	Compressor::Parameters compression;
+	bool continuous{false};
+	Chain chain;
+	std::vector<Anchor> anchors;
+	recording::Statistics statistics;
+	bool saved{false};
+	/*
+	 * Deleted while it's resident, so it must not be saved afterwards
+	 * (checked by the save while the file mutex is held)
+	 */
+	std::atomic<bool> deleted{false};
+
+private:
+	SegmentPool *pool_;
+	std::vector<SegmentPool::Index> segments_;
+	unsigned long count_{0};
+	std::vector<SegmentPool::Index> encoded_;
+	size_t encoded_size_{0};
+};
+
+} // namespace scales
@@ -0,0 +1,101 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace scales {
+
+/*
+ * Estimates the amplitude spectrum of the readings with Welch's method,
+ * averaging the power of Hann windowed segments that overlap by half.
+ * Readings are added one at a time so the memory used is fixed and
+ * doesn't depend on the length of the recording.
+ *
+ * The readings are assumed to be at a constant rate. The mean of each
+ * segment is removed so that the load itself doesn't leak into the lower
+ * frequencies.
+ *
+ * This must not depend on Arduino or ESP-IDF headers.
+ */
+class Spectrum {
+public:
+	static constexpr size_t SEGMENT_SIZE = 256;
+	static constexpr size_t BINS = SEGMENT_SIZE / 2 + 1;
+
+	struct Peak {
+		float frequency_hz;
+		float amplitude;
+	};
+
+	Spectrum();
+
+	void reset();
+	void add(uint64_t time_us, int32_t value);
+
+	/* Number of readings added */
+	inline unsigned long count() const { return count_; }
+	/* Number of segments averaged */
+	inline unsigned long segments() const { return segments_; }
+	/* Mean rate of the readings, or 0 if there are too few of them */
+	float rate_hz() const;
+	/* Width of each bin */
+	inline float resolution_hz() const { return rate_hz() / SEGMENT_SIZE; }
+
+	/* Amplitude of a sine wave centred on the bin, in the same units as the readings */
+	float amplitude(size_t bin) const;
+	/*
+	 * Find the largest local maxima (excluding 0Hz) in order of amplitude,
+	 * with the frequency interpolated between bins. Returns the number of
+	 * peaks found.
+	 */
+	size_t peaks(Peak *peaks, size_t count) const;
+	/*
+	 * Reduce the spectrum (excluding 0Hz) to a number of points, each
+	 * being the largest amplitude of a group of bins at the frequency of
+	 * the centre of the group.
+	 */
+	void decimate(Peak *points, size_t count) const;
+
+private:
+	static constexpr size_t HOP_SIZE = SEGMENT_SIZE / 2;
+
+	void process();
+	void fft();
+
+	std::array<float,SEGMENT_SIZE> window_;
+	std::array<float,SEGMENT_SIZE / 2> cos_;
+	std::array<float,SEGMENT_SIZE / 2> sin_;
+	float window_sum_{0};
+
+	std::array<int32_t,SEGMENT_SIZE> input_;
+	size_t fill_{0};
+	std::array<float,SEGMENT_SIZE> real_;
+	std::array<float,SEGMENT_SIZE> imag_;
+	std::array<float,BINS> power_;
+
+	unsigned long count_{0};
+	unsigned long segments_{0};
+	uint64_t first_us_{0};
+	uint64_t last_us_{0};
+};
+
+} // namespace scales
@@ -0,0 +1,121 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "recording.h"
+
+namespace scales {
+
+/*
+ * Detects steps in the readings as they are made, so that events can be
+ * reported without having to analyse the whole recording afterwards.
+ *
+ * While settled, a two-sided CUSUM of the difference from the settled
+ * level detects a load being applied or removed. The readings have settled
+ * again when the standard deviation over a window is less than a multiple
+ * of the noise, which is estimated from the differences between adjacent
+ * readings. Each reading has a constant cost.
+ *
+ * The parameters have the same meaning as those used by hx711-analyse.
+ *
+ * This must not depend on Arduino or ESP-IDF headers.
+ */
+class StepDetector {
+public:
+	static constexpr unsigned int MAX_WINDOW = 64;
+
+	/* Event types, which are recorded as flags */
+	static constexpr uint8_t APPLIED = Type::APPLIED;
+	static constexpr uint8_t REMOVED = Type::REMOVED;
+	static constexpr uint8_t SETTLED = Type::SETTLED;
+
+	struct Parameters {
+		unsigned int window{16};        /* Readings per window */
+		int32_t step_threshold{1000};   /* Minimum step size */
+		unsigned int settle_factor{3};  /* Settled when stddev < factor * noise */
+	};
+
+	struct Event {
+		uint8_t type{0};
+		uint64_t time_us{0};            /* Start of the step or window that settled */
+		int32_t level{0};               /* Settled level before the step or after settling */
+		int32_t step{0};                /* Change in the settled level (when settled) */
+		uint64_t settling_us{0};        /* Time taken to settle (when settled) */
+	};
+
+	StepDetector() = default;
+	explicit StepDetector(const Parameters &parameters);
+
+	/* Returns the types of any events at this reading */
+	uint8_t update(uint64_t time_us, int32_t value);
+	/* Forget the settled level, e.g. because the rate or gain has changed */
+	void reset();
+
+	inline const Parameters& parameters() const { return parameters_; }
+	void parameters(const Parameters &parameters);
+
+	inline bool settled() const { return state_ == State::SETTLED; }
+	/* Current settled level, which follows slow drift */
+	inline int32_t level() const { return level_scaled_ >> LEVEL_SHIFT; }
+	/* Mean of the most recent window of readings (or as many as there are) */
+	inline int32_t mean() const { return count_ ? sum_ / (int64_t)count_ : previous_; }
+	/* Estimated standard deviation of the noise */
+	uint32_t noise() const;
+	/* Details of the most recent event */
+	inline const Event& event() const { return event_; }
+
+private:
+	enum class State : uint8_t {
+		UNKNOWN,
+		SETTLED,
+		MOVING,
+	};
+
+	static constexpr int NOISE_SHIFT = 6;
+	static constexpr int LEVEL_SHIFT = 6;
+
+	Parameters parameters_;
+	State state_{State::UNKNOWN};
+
+	std::array<int32_t,MAX_WINDOW> values_{};
+	std::array<uint64_t,MAX_WINDOW> times_{};
+	unsigned int pos_{0};
+	unsigned int count_{0};
+	int64_t sum_{0};
+	int64_t sum_sq_{0};
+
+	bool have_previous_{false};
+	int32_t previous_{0};
+	float noise_var_{0};
+
+	int64_t level_scaled_{0};
+	int64_t high_sum_{0};
+	int64_t low_sum_{0};
+	uint64_t high_start_us_{0};
+	uint64_t low_start_us_{0};
+	unsigned int moving_count_{0};
+	uint64_t step_start_us_{0};
+	int32_t step_level_{0};
+	Event event_;
+};
+
+} // namespace scales
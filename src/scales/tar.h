@@ -0,0 +1,50 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <string_view>
+#include <time.h>
+
+namespace scales {
+
+/*
+ * Writes a ustar archive to a stream without buffering file contents.
+ *
+ * The size of each file must be known before its contents are written.
+ */
+class TarWriter {
+public:
+	static constexpr size_t BLOCK_SIZE = 512;
+
+	TarWriter(Print &output);
+
+	void begin_file(const std::string_view name, size_t size, time_t mtime);
+	void end_file(size_t written);
+	void finish();
+
+private:
+	void write_zeros(size_t length);
+
+	Print &output_;
+	size_t size_{0};
+};
+
+} // namespace scales
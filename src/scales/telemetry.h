@@ -0,0 +1,156 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+/*
+ * Telemetry packet format shared between the firmware and the host tools in
+ * readings/. This must not depend on Arduino or ESP-IDF headers.
+ *
+ * Live readings are sent as UDP datagrams (to a unicast or multicast
+ * address) so that any number of listeners can capture them. All values are
+ * little endian:
+ *   0 magic "HXT" and version (4 bytes)
+ *   4 device ID, the MAC address (6 bytes)
+ *  10 flags (uint8)
+ *  11 number of entries (uint8)
+ *  12 packet sequence number (uint32)
+ *  16 index of the first entry, counting every entry since boot (uint32)
+ *  20 monotonic time before the first entry (uint64)
+ *  28 wall clock time in microseconds at the same time (uint64)
+ *  36 estimated conversion period (uint32)
+ *  40 tare value before the first entry (int32)
+ *  44 entries, each one being the time offset from the previous entry
+ *     (uint32), flags (uint8) and the value (int24), which is the same as a
+ *     Data buffer entry of a recording
+ *
+ * Lost packets can be detected from the sequence number and lost entries
+ * from the index. The time and tare value in each packet allow a listener
+ * to start at any packet or continue after a loss.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "recording.h"
+
+namespace scales {
+
+namespace telemetry {
+
+constexpr std::array<uint8_t,4> MAGIC{'H', 'X', 'T', 1};
+constexpr uint16_t DEFAULT_PORT = 7711;
+constexpr size_t HEADER_SIZE = 44;
+constexpr size_t ENTRY_SIZE = 8;
+constexpr size_t MAX_ENTRIES = 128;
+/* Fits in a single unfragmented datagram on Ethernet and Wi-Fi */
+constexpr size_t MAX_PACKET_SIZE = HEADER_SIZE + MAX_ENTRIES * ENTRY_SIZE;
+
+enum Flags : uint8_t {
+	/* The readings are being recorded */
+	RECORDING = 1U << 0,
+};
+
+struct Header {
+	std::array<uint8_t,6> device{};
+	uint8_t flags{0};
+	uint8_t count{0};
+	uint32_t sequence{0};
+	uint32_t index{0};
+	uint64_t time_us{0};
+	uint64_t realtime_us{0};
+	uint32_t period_ns{0};
+	int32_t tare_value{0};
+};
+
+inline void put_le(uint8_t *buffer, uint64_t value, size_t length) {
+	for (size_t i = 0; i < length; i++)
+		buffer[i] = (value >> (i * 8)) & 0xFF;
+}
+
+inline uint64_t get_le(const uint8_t *buffer, size_t length) {
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < length; i++)
+		value |= (uint64_t)buffer[i] << (i * 8);
+
+	return value;
+}
+
+/* Encode a packet into buffer (at least MAX_PACKET_SIZE), returning its length */
+inline size_t encode(const Header &header, const Data *entries, uint8_t *buffer) {
+	size_t count = std::min((size_t)header.count, MAX_ENTRIES);
+
+	std::copy(MAGIC.begin(), MAGIC.end(), &buffer[0]);
+	std::copy(header.device.begin(), header.device.end(), &buffer[4]);
+	buffer[10] = header.flags;
+	buffer[11] = count;
+	put_le(&buffer[12], header.sequence, 4);
+	put_le(&buffer[16], header.index, 4);
+	put_le(&buffer[20], header.time_us, 8);
+	put_le(&buffer[28], header.realtime_us, 8);
+	put_le(&buffer[36], header.period_ns, 4);
+	put_le(&buffer[40], static_cast<uint32_t>(header.tare_value), 4);
+
+	uint8_t *entry = &buffer[HEADER_SIZE];
+
+	for (size_t i = 0; i < count; i++, entry += ENTRY_SIZE) {
+		put_le(&entry[0], entries[i].offset_us, 4);
+		entry[4] = entries[i].type;
+		put_le(&entry[5], entries[i].value, 3);
+	}
+
+	return HEADER_SIZE + count * ENTRY_SIZE;
+}
+
+/* Decode a packet, returning false if it's not valid */
+inline bool decode(const uint8_t *buffer, size_t length, Header &header,
+		std::array<Data,MAX_ENTRIES> &entries) {
+	if (length < HEADER_SIZE || !std::equal(MAGIC.begin(), MAGIC.end(), &buffer[0]))
+		return false;
+
+	std::copy(&buffer[4], &buffer[10], header.device.begin());
+	header.flags = buffer[10];
+	header.count = buffer[11];
+	header.sequence = get_le(&buffer[12], 4);
+	header.index = get_le(&buffer[16], 4);
+	header.time_us = get_le(&buffer[20], 8);
+	header.realtime_us = get_le(&buffer[28], 8);
+	header.period_ns = get_le(&buffer[36], 4);
+	header.tare_value = static_cast<int32_t>(get_le(&buffer[40], 4));
+
+	if (header.count > MAX_ENTRIES || length != HEADER_SIZE + header.count * ENTRY_SIZE)
+		return false;
+
+	const uint8_t *entry = &buffer[HEADER_SIZE];
+
+	for (size_t i = 0; i < header.count; i++, entry += ENTRY_SIZE) {
+		entries[i].offset_us = get_le(&entry[0], 4);
+		entries[i].type = entry[4];
+		entries[i].value = get_le(&entry[5], 3);
+	}
+
+	return true;
+}
+
+} // namespace telemetry
+
+} // namespace scales
@@ -0,0 +1,103 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <lwip/sockets.h>
+
+#include <uuid/log.h>
+
+#include "hx711.h"
+#include "telemetry.h"
+
+namespace scales {
+
+/*
+ * Streams live readings to a UDP unicast or multicast address, so that any
+ * number of listeners can capture them at the same time without
+ * downloading recordings from the device. Readings are sent whether they're
+ * being recorded or not.
+ *
+ * Readings are sent in batches to reduce the number of packets; there's no
+ * retransmission so listeners need to accept some loss.
+ */
+class TelemetrySender {
+public:
+	static constexpr uint32_t STACK_SIZE = 4096;
+	/* Send the readings that have been made this often */
+	static constexpr uint32_t INTERVAL_MS = 100;
+	/* Multicast packets stay on the local network by default */
+	static constexpr int MULTICAST_TTL = 1;
+
+	struct Stats {
+		std::atomic<uint32_t> packets{0};
+		std::atomic<uint32_t> readings{0};
+		/* Readings replaced before they could be sent */
+		std::atomic<uint32_t> overruns{0};
+		std::atomic<uint32_t> errors{0};
+	};
+
+	explicit TelemetrySender(HX711 &hx711);
+
+	/* Load the configuration and start the task */
+	void start();
+	std::string destination() const;
+	/*
+	 * Set the destination address[:port] (an empty string disables
+	 * telemetry), which is saved. Returns false if it's not valid.
+	 */
+	bool destination(const std::string &destination);
+	inline const Stats& stats() const { return stats_; }
+
+private:
+	static constexpr const char *FILENAME = "/telemetry";
+
+	static void task(void *arg);
+	static bool parse(const std::string &destination, in_addr &address, uint16_t &port);
+
+	void run();
+	/* Returns false if the packet couldn't be sent */
+	bool send(int fd, const sockaddr_in &destination, size_t count);
+
+	static uuid::log::Logger logger_;
+
+	HX711 &hx711_;
+	mutable std::mutex mutex_;
+	std::string destination_;
+	in_addr address_{};
+	uint16_t port_{0};
+	TaskHandle_t task_{nullptr};
+	telemetry::Header header_;
+	uint32_t index_{0};
+	std::array<HX711::LiveReading,telemetry::MAX_ENTRIES> readings_;
+	std::array<Data,telemetry::MAX_ENTRIES> entries_;
+	std::array<uint8_t,telemetry::MAX_PACKET_SIZE> buffer_;
+	Stats stats_;
+};
+
+} // namespace scales
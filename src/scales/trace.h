@@ -0,0 +1,93 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Execution trace of the main loop, readings, saves, HTTP handlers, console
+ * commands and filesystem operations, so that the cause of a gap in the
+ * readings can be found. The trace is downloaded from /trace in the Chrome
+ * trace event format, which can be opened in Perfetto (ui.perfetto.dev) or
+ * chrome://tracing.
+ *
+ * Events are kept in a ring buffer in PSRAM. Adding an event to the buffer
+ * takes about 30ns on the host (the "trace_event" benchmark), which is
+ * mostly the atomic increment of the index. The total time on the device,
+ * including reading the timer and looking up the task, is measured at
+ * startup and shown by the "trace" command and in /metrics.
+ *
+ * Spans of the rest of the main loop (network, console and log output) are
+ * only added when they're long enough to delay a reading.
+ */
+
+#include <Arduino.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "trace_buffer.h"
+
+namespace scales {
+
+namespace trace {
+
+/* Allocate the buffer and measure the overhead of adding events */
+void init();
+bool enabled();
+void enabled(bool enabled);
+/* Discard all events */
+void clear();
+size_t capacity();
+uint32_t count();
+/* Measured time to add an event */
+uint32_t overhead_ns();
+
+void begin(Category category, const char *name, const char *detail = nullptr);
+void end(Category category, const char *name, const char *detail = nullptr);
+/* Add a span that has already ended, if it lasted at least min_duration_us */
+void complete(Category category, const char *name, uint64_t start_us,
+	uint32_t min_duration_us = 0);
+void counter(Category category, const char *name, int32_t value);
+
+/* Output the trace as Chrome trace event format JSON */
+void write_json(Print &output);
+
+/* Trace the lifetime of the object as a span */
+class Span {
+public:
+	inline Span(Category category, const char *name, const char *detail = nullptr)
+			: category_(category), name_(name), detail_(detail) {
+		begin(category_, name_, detail_);
+	}
+
+	inline ~Span() {
+		end(category_, name_, detail_);
+	}
+
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+
+private:
+	const Category category_;
+	const char *name_;
+	const char *detail_;
+};
+
+} // namespace trace
+
+} // namespace scales
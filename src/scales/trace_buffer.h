@@ -0,0 +1,154 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Trace event buffer shared between the firmware and the benchmarks in
+ * bench/. This must not depend on Arduino or ESP-IDF headers.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace scales {
+
+namespace trace {
+
+/* Chrome trace event phases */
+enum class Phase : uint8_t {
+	BEGIN = 'B',
+	END = 'E',
+	COMPLETE = 'X',
+	COUNTER = 'C',
+};
+
+enum class Category : uint8_t {
+	LOOP,
+	HX711,
+	SAVE,
+	HTTP,
+	CONSOLE,
+	FS,
+};
+
+inline const char *category_name(Category category) {
+	switch (category) {
+	case Category::LOOP: return "loop";
+	case Category::HX711: return "hx711";
+	case Category::SAVE: return "save";
+	case Category::HTTP: return "http";
+	case Category::CONSOLE: return "console";
+	case Category::FS: return "fs";
+	}
+
+	return "";
+}
+
+/*
+ * Names are not copied, so they must be static strings (or otherwise last
+ * as long as the buffer). The detail is appended to the name.
+ */
+struct Event {
+	uint64_t time_us;
+	const char *name;
+	union {
+		const char *detail; /* BEGIN and END */
+		uint32_t duration_us; /* COMPLETE */
+		int32_t value; /* COUNTER */
+	};
+	uint8_t task;
+	Phase phase;
+	Category category;
+};
+
+/*
+ * Ring buffer of events that can be added from any task without locking.
+ *
+ * Each slot has a sequence number that is cleared while it's being written,
+ * so that events that are overwritten while the buffer is being read can be
+ * skipped instead of being output with mixed up values.
+ */
+class Buffer {
+public:
+	struct Slot {
+		std::atomic<uint32_t> sequence{0};
+		Event event;
+	};
+
+	/* The number of slots must be a power of 2 */
+	void init(Slot *slots, size_t count) {
+		slots_ = slots;
+		mask_ = count - 1;
+		clear();
+	}
+
+	inline size_t capacity() const { return slots_ ? mask_ + 1 : 0; }
+	/* Total number of events added since the buffer was cleared */
+	inline uint32_t count() const { return next_.load(std::memory_order_relaxed); }
+
+	void clear() {
+		for (size_t i = 0; i < capacity(); i++)
+			slots_[i].sequence.store(0, std::memory_order_relaxed);
+
+		next_.store(0, std::memory_order_release);
+	}
+
+	inline void add(const Event &event) {
+		uint32_t index = next_.fetch_add(1, std::memory_order_relaxed);
+		Slot &slot = slots_[index & mask_];
+
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.event = event;
+		slot.sequence.store(index + 1, std::memory_order_release);
+	}
+
+	/* Call func(const Event&) for each event in the buffer, oldest first */
+	template <class Function>
+	void for_each(Function func) const {
+		uint32_t end = next_.load(std::memory_order_acquire);
+		uint32_t begin = end > capacity() ? end - capacity() : 0;
+
+		for (uint32_t index = begin; index != end; index++) {
+			const Slot &slot = slots_[index & mask_];
+			Event event;
+
+			if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+				continue;
+
+			event = slot.event;
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (slot.sequence.load(std::memory_order_relaxed) != index + 1)
+				continue;
+
+			func(event);
+		}
+	}
+
+private:
+	Slot *slots_{nullptr};
+	size_t mask_{0};
+	std::atomic<uint32_t> next_{0};
+};
+
+} // namespace trace
+
+} // namespace scales
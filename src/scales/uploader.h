@@ -0,0 +1,123 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <esp_http_client.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <uuid/log.h>
+
+#include "hx711.h"
+
+namespace scales {
+
+/*
+ * Uploads saved recordings to a collector in the background, so that they
+ * don't need to be downloaded from each device.
+ *
+ * Each recording is sent to <url>/<filename>.cbor:
+ *   HEAD returns the number of bytes already received in the Upload-Offset
+ *        header (404 if there are none)
+ *   POST with Upload-Offset and Upload-Length headers sends the rest of the
+ *        file from that offset, and the response has the new Upload-Offset
+ *
+ * An interrupted upload resumes from the offset that the collector has.
+ * Several recordings are uploaded on the same connection. Recordings that
+ * have been uploaded completely are listed in an index file, so that they
+ * can be deleted.
+ */
+class Uploader {
+public:
+	static constexpr uint32_t STACK_SIZE = 6144;
+	/* Check for new recordings this often */
+	static constexpr uint32_t INTERVAL_MS = 60 * 1000;
+	static constexpr int TIMEOUT_MS = 10 * 1000;
+	/* Maximum number of recordings to upload on one connection */
+	static constexpr size_t BATCH_FILES = 8;
+	static constexpr size_t CHUNK_SIZE = 4096;
+
+	struct Stats {
+		std::atomic<uint32_t> files{0};
+		std::atomic<uint32_t> bytes{0};
+		std::atomic<uint32_t> resumed{0};
+		std::atomic<uint32_t> connections{0};
+		std::atomic<uint32_t> errors{0};
+	};
+
+	explicit Uploader(HX711 &hx711);
+
+	/* Load the configuration and index, and start the task */
+	void start();
+	std::string url() const;
+	/* Set the collector URL (an empty string disables uploads), which is saved */
+	void url(const std::string &url);
+	/* Upload any new recordings now */
+	void wake();
+	bool uploaded(const std::string_view filename) const;
+	/* Number of saved recordings that haven't been uploaded */
+	size_t pending() const;
+	inline const Stats& stats() const { return stats_; }
+
+private:
+	static constexpr const char *URL_FILENAME = "/upload_url";
+	static constexpr const char *INDEX_FILENAME = "/uploaded";
+	static constexpr size_t HEADER_SIZE = 16;
+
+	/* Response headers of the current request */
+	struct Response {
+		long offset{-1};
+	};
+
+	static void task(void *arg);
+	static esp_err_t event_handler(esp_http_client_event_t *event);
+
+	void run();
+	void load_index();
+	void add_index(const std::string &filename);
+	std::vector<std::string> pending_files() const;
+	/* Returns false if the connection can't be used any more */
+	bool upload(esp_http_client_handle_t client, const std::string &url,
+		const std::string &filename, bool &complete);
+	long remote_offset(esp_http_client_handle_t client, const std::string &url);
+
+	static uuid::log::Logger logger_;
+
+	HX711 &hx711_;
+	mutable std::mutex mutex_;
+	std::string url_;
+	std::unordered_set<std::string> uploaded_;
+	TaskHandle_t task_{nullptr};
+	Response response_;
+	std::array<uint8_t,CHUNK_SIZE> buffer_;
+	Stats stats_;
+};
+
+} // namespace scales
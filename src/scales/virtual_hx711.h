@@ -0,0 +1,121 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hx711_hardware.h"
+
+namespace scales {
+
+/*
+ * Emulates the serial interface of an HX711 with a scripted load profile,
+ * sinusoidal vibration and Gaussian noise.
+ *
+ * With a real clock, conversions happen at the configured rate in real
+ * time. With a virtual clock, time only advances when delays are requested
+ * or when waiting for the next conversion, so readings can be generated as
+ * fast as they can be processed.
+ *
+ * This has no dependencies on Arduino so that it can be used on a host.
+ */
+class VirtualHX711: public HX711Hardware {
+public:
+	enum class Clock {
+		REAL,
+		VIRTUAL,
+	};
+
+	/* Load value at a point in time, relative to when the profile is set */
+	struct Point {
+		uint64_t time_us;
+		int32_t value;
+	};
+
+	static constexpr unsigned int DEFAULT_RATE_HZ = 80;
+
+	explicit VirtualHX711(Clock clock = Clock::REAL, unsigned int rate_hz = DEFAULT_RATE_HZ,
+		float noise = 0, uint32_t seed = 1);
+
+	void init() override;
+	bool data() override;
+	void sck(bool level) override;
+	void delay_us(uint32_t us) override;
+	uint64_t now_us() override;
+	void disable_interrupts() override {}
+	void enable_interrupts() override {}
+	uint64_t ready_us() override;
+	bool select_rate(unsigned int rate_hz) override;
+
+	unsigned int rate() const;
+	/* Conversion rate (normally 10 or 80 Hz) */
+	void rate(unsigned int rate_hz);
+	float noise() const;
+	/* Standard deviation of the noise added to each conversion */
+	void noise(float stddev);
+	float vibration_hz() const;
+	float vibration_amplitude() const;
+	/* Add a sine wave to each conversion */
+	void vibration(float frequency_hz, float amplitude);
+	std::string profile() const;
+	/*
+	 * Set the load profile from a list of "time_s:value" points. The value
+	 * is linearly interpolated between points and the last value is held
+	 * after the last point, e.g. "0:0 10:0 10.5:20000 30:20000 30.2:0".
+	 */
+	bool profile(std::string_view script);
+	void profile(std::vector<Point> points);
+	/* Number of conversions that were replaced before they were read */
+	inline uint32_t overwritten() const { return overwritten_; }
+
+private:
+	static constexpr uint32_t POWER_DOWN_US = 60;
+
+	void update(uint64_t now);
+	int32_t value_at(uint64_t time_us) const;
+
+	const Clock clock_;
+	mutable std::mutex mutex_;
+	uint64_t virtual_us_{0};
+	uint64_t period_us_;
+	float noise_;
+	float vibration_hz_{0};
+	float vibration_amplitude_{0};
+	std::vector<Point> profile_;
+	uint64_t profile_start_us_{0};
+	std::minstd_rand random_;
+	std::normal_distribution<float> distribution_{0, 1};
+
+	uint64_t next_conversion_us_{0};
+	uint64_t conversion_us_{0};
+	uint64_t sck_high_us_{0};
+	uint32_t conversion_{0};
+	uint32_t overwritten_{0};
+	unsigned int pulses_{0};
+	bool ready_{false};
+	bool sck_{false};
+	bool powered_down_{false};
+};
+
+} // namespace scales
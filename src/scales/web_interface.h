@@ -20,6 +20,8 @@
 
 #include <Arduino.h>
 
+#include <string_view>
+
 #include <uuid/log.h>
 
 #include "app.h"
@@ -34,13 +36,24 @@ public:
 	WebInterface(App &app);
 
 private:
-	static std::unordered_map<std::string_view,std::string_view> parse_form(std::string_view text);
+	static constexpr size_t SPECTRUM_PEAKS = 8;
+	static constexpr size_t SPECTRUM_POINTS = 32;
+
+	static bool read_form(WebServer::Request &req, char *buffer, size_t size,
+		std::string_view &text);
 
 	bool status(WebServer::Request &req);
 	bool action(WebServer::Request &req);
 
 	bool files(WebServer::Request &req);
 	bool access_file(WebServer::Request &req);
+	bool archive(WebServer::Request &req);
+	bool delete_files(WebServer::Request &req);
+	bool spectrum(WebServer::Request &req);
+
+	bool metrics(WebServer::Request &req);
+	/* Chrome trace event format JSON */
+	bool trace_events(WebServer::Request &req);
 
 	static uuid::log::Logger logger_;
 
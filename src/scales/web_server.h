@@ -22,24 +22,53 @@
 
 #include <esp_http_server.h>
 
+#include <array>
+#include <cstdarg>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include <uuid/log.h>
 
+#include "gzip.h"
+
 namespace scales {
 
 class WebServer {
 public:
 	static constexpr uint16_t DEFAULT_PORT = 80;
+	static constexpr size_t DEFAULT_ASYNC_WORKERS = 3;
 
 	class Request: public Stream {
 		friend WebServer;
 	public:
-		Request(httpd_req_t *req);
+		class GzipDeleter {
+		public:
+			void operator()(GzipEncoder *gzip);
+		};
+
+		/*
+		 * Memory used while handling a request, reused by later requests
+		 * so that responses don't need to allocate anything.
+		 */
+		struct Context {
+			static constexpr size_t BUFFER_SIZE = 1436 - 7;
+			static constexpr size_t HEADERS_SIZE = 384;
+			static constexpr size_t SCRATCH_SIZE = 256;
+
+			std::array<char,BUFFER_SIZE> buffer;
+			std::array<char,HEADERS_SIZE> headers;
+			std::array<char,SCRATCH_SIZE> scratch;
+			/* Allocated from PSRAM on first use */
+			std::unique_ptr<GzipEncoder,GzipDeleter> gzip;
+		};
+
+		Request(httpd_req_t *req, Context &context);
 
 		int available() override;
 		int read() override;
@@ -48,41 +77,104 @@ public:
 
 		size_t write(uint8_t c) override;
 		size_t write(const uint8_t *buffer, size_t size) override;
+		using Print::write;
+		/*
+		 * Send data directly from memory without copying it into the
+		 * response buffer, unless the response is compressed. The data
+		 * only needs to remain valid until this returns.
+		 */
+		size_t write_memory(const uint8_t *buffer, size_t size);
+
+		/* Formats directly into the response buffer */
+		size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+		size_t vprintf(const char *format, va_list ap);
 
 		const std::string_view uri() const;
+		const std::string_view query() const;
 		std::string client_address();
 		std::string get_header(const char *name);
+		/* The value is truncated if the buffer is too small */
+		std::string_view get_header(const char *name, char *buffer, size_t size);
 
 		void set_status(unsigned int status);
 		void set_type(const char *type);
 		void add_header(const char *name, const char *value);
-		void add_header(const char *name, const std::string &value);
+		void add_header(const char *name, std::string_view value);
+
+		/*
+		 * Compress the response if the client accepts it. Must be called
+		 * before writing any of the response body.
+		 */
+		bool compress();
 
 	private:
+		void gzip_write(const uint8_t *buffer, size_t size);
+		void buffer_write(const uint8_t *buffer, size_t size);
 		void send();
 		void finish();
 
 		httpd_req_t *req_;
+		Context &context_;
 		size_t content_len_;
 		esp_err_t send_err_{ESP_OK};
-		std::vector<char> buffer_;
 		size_t buffer_len_{0};
-		std::vector<std::unique_ptr<char>> resp_headers_;
+		size_t headers_len_{0};
+		GzipEncoder *gzip_{nullptr};
+		uint64_t gzip_us_{0};
+		uint64_t send_us_{0};
 		bool status_{false};
 		bool sent_{false};
 	};
 
+	/* Updated without locking so that they can be read at any time */
+	struct HandlerStats {
+		static constexpr std::array<uint32_t,11> BUCKETS_MS{
+			5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+		void record(uint32_t duration_us, uint32_t allocations, bool success);
+
+		std::atomic<uint32_t> requests{0};
+		std::atomic<uint32_t> failures{0};
+		std::atomic<uint32_t> rejected{0};
+		std::atomic<uint32_t> duration_ms_total{0};
+		/* Only allocations by the task handling the request */
+		std::atomic<uint32_t> allocations{0};
+		/* Not cumulative, the last bucket is +Inf */
+		std::array<std::atomic<uint32_t>,BUCKETS_MS.size() + 1> buckets{};
+	};
+
+	/* Compressed responses, updated without locking */
+	struct GzipStats {
+		std::atomic<uint32_t> responses{0};
+		std::atomic<uint32_t> input_bytes{0};
+		std::atomic<uint32_t> output_bytes{0};
+		/* Time spent compressing, excluding sending */
+		std::atomic<uint32_t> cpu_ms_total{0};
+	};
+
 	using get_function = std::function<bool(Request &req)>;
 	using post_function = std::function<bool(Request &req)>;
+	using stats_function = std::function<void(const std::string &uri,
+		const char *method, const HandlerStats &stats)>;
 
-	WebServer(uint16_t port = DEFAULT_PORT);
+	WebServer(uint16_t port = DEFAULT_PORT, size_t async_workers = DEFAULT_ASYNC_WORKERS);
 	~WebServer();
 
-	bool add_get_handler(const std::string &uri, get_function handler);
-	bool add_post_handler(const std::string &uri, post_function handler);
+	/*
+	 * Async handlers run on a worker task instead of the httpd task so
+	 * that long responses (e.g. downloads) don't block other requests.
+	 * If all workers are busy the request is rejected with a 503.
+	 */
+	bool add_get_handler(const std::string &uri, get_function handler, bool async = false);
+	bool add_post_handler(const std::string &uri, post_function handler, bool async = false);
 	bool add_static_content(const std::string &uri, const char *content_type,
 		const char * const headers[][2], const std::string_view data);
 
+	void handler_stats(stats_function func) const;
+	/* Minimum free stack of the async workers since they started */
+	size_t async_stack_free() const;
+	static inline const GzipStats& gzip_stats() { return gzip_stats_; }
+
 private:
 	class HandleDeleter {
 	public:
@@ -91,7 +183,89 @@ private:
 		}
 	};
 
+	class URIHandler;
+
+	/*
+	 * Closes the least recently used socket when they're all in use, like
+	 * httpd's LRU purge but without closing sockets of async requests.
+	 */
+	class Sockets {
+	public:
+		inline size_t max_open() const { return max_open_; }
+		void max_open(size_t count);
+
+		static esp_err_t open(httpd_handle_t server, int sockfd);
+		static void close(httpd_handle_t server, int sockfd);
+		static void used(httpd_req_t *req);
+		static void async(httpd_handle_t server, int sockfd, bool async);
+
+	private:
+		struct Socket {
+			int fd;
+			uint64_t used_us;
+			bool async;
+		};
+
+		static Sockets& get(httpd_handle_t server);
+
+		std::mutex mutex_;
+		std::vector<Socket> sockets_;
+		size_t max_open_{0};
+	};
+
+	class RequestContexts {
+	public:
+		class Lease {
+		public:
+			Lease(RequestContexts &contexts);
+			~Lease();
+
+			inline Request::Context& operator*() { return *context_; }
+
+		private:
+			RequestContexts &contexts_;
+			Request::Context *context_;
+		};
+
+		RequestContexts(size_t count);
+
+	private:
+		Request::Context* acquire();
+		void release(Request::Context *context);
+
+		std::mutex mutex_;
+		std::vector<std::unique_ptr<Request::Context>> contexts_;
+		std::vector<Request::Context*> available_;
+	};
+
+	class AsyncWorkers {
+	public:
+		AsyncWorkers(size_t count);
+		~AsyncWorkers();
+
+		esp_err_t submit(httpd_req_t *req, URIHandler *handler, uint64_t start_us);
+		inline size_t stack_free() const { return stack_free_; }
+
+	private:
+		static constexpr uint32_t STACK_SIZE = 6144;
+
+		struct Job {
+			httpd_req_t *req;
+			URIHandler *handler;
+			uint64_t start_us;
+		};
+
+		static void worker_task(void *arg);
+
+		QueueHandle_t queue_{nullptr};
+		SemaphoreHandle_t idle_{nullptr};
+		SemaphoreHandle_t stopped_{nullptr};
+		size_t count_{0};
+		std::atomic<size_t> stack_free_{STACK_SIZE};
+	};
+
 	class URIHandler {
+		friend AsyncWorkers;
 	public:
 		virtual ~URIHandler() = default;
 
@@ -99,36 +273,47 @@ private:
 		bool server_register(httpd_handle_t server);
 		void server_unregister(httpd_handle_t server);
 
+		inline const std::string& uri() const { return uri_; }
+		inline const HandlerStats& stats() const { return stats_; }
+
 	protected:
-		URIHandler(const std::string &uri);
+		URIHandler(const std::string &uri, AsyncWorkers *workers = nullptr);
 
 		virtual esp_err_t handler_function(httpd_req_t *req) = 0;
 
 	private:
+		esp_err_t run(httpd_req_t *req, uint64_t start_us);
+
 		const std::string uri_;
+		AsyncWorkers *workers_;
+		HandlerStats stats_;
 	};
 
 	class GetURIHandler: public URIHandler {
 	public:
-		GetURIHandler(const std::string &uri, get_function handler);
+		GetURIHandler(const std::string &uri, get_function handler,
+			RequestContexts &contexts, AsyncWorkers *workers);
 
 	protected:
 		httpd_method_t method() override;
 		esp_err_t handler_function(httpd_req_t *req) override;
 
 	private:
+		RequestContexts &contexts_;
 		get_function function_;
 	};
 
 	class PostURIHandler: public URIHandler {
 	public:
-		PostURIHandler(const std::string &uri, post_function handler);
+		PostURIHandler(const std::string &uri, post_function handler,
+			RequestContexts &contexts, AsyncWorkers *workers);
 
 	protected:
 		httpd_method_t method() override;
 		esp_err_t handler_function(httpd_req_t *req) override;
 
 	private:
+		RequestContexts &contexts_;
 		post_function function_;
 	};
 
@@ -148,9 +333,13 @@ private:
 	};
 
 	static uuid::log::Logger logger_;
+	static GzipStats gzip_stats_;
 
+	Sockets sockets_;
 	std::unique_ptr<void,HandleDeleter> handle_;
+	RequestContexts request_contexts_;
 	std::vector<std::unique_ptr<URIHandler>> uri_handlers_;
+	std::unique_ptr<AsyncWorkers> async_workers_;
 };
 
 } // namespace scales
@@ -0,0 +1,51 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <string_view>
+
+namespace scales {
+
+/*
+ * Writes escaped XML elements, attributes and text directly to the output
+ * without any intermediate buffers.
+ */
+class XmlWriter {
+public:
+	XmlWriter(Print &output);
+
+	void start(const char *name);
+	void attribute(const char *name, std::string_view value);
+	void attribute(const char *name, long value);
+	void attribute(const char *name, unsigned long value);
+	void text(std::string_view value);
+	void text(long value);
+	void end(const char *name);
+
+private:
+	void close_tag();
+	void escape(std::string_view value);
+
+	Print &output_;
+	bool open_{false};
+};
+
+} // namespace scales
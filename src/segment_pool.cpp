@@ -0,0 +1,68 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/segment_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+namespace scales {
+
+bool SegmentPool::init(MemoryAllocation memory, size_t segments) {
+	std::lock_guard lock{mutex_};
+
+	memory_ = std::move(memory);
+	segments_ = memory_ ? std::min(segments, (size_t)NONE) : 0;
+
+	if (!memory_)
+		return false;
+
+	free_.clear();
+	free_.reserve(segments_);
+
+	/* Allocate the lowest indexes first */
+	for (size_t i = segments_; i > 0; i--)
+		free_.push_back(i - 1);
+
+	return true;
+}
+
+size_t SegmentPool::free_segments() const {
+	std::lock_guard lock{mutex_};
+	return free_.size();
+}
+
+SegmentPool::Index SegmentPool::allocate() {
+	std::lock_guard lock{mutex_};
+
+	if (free_.empty())
+		return NONE;
+
+	Index index = free_.back();
+	free_.pop_back();
+	return index;
+}
+
+void SegmentPool::release(Index index) {
+	std::lock_guard lock{mutex_};
+	free_.push_back(index);
+}
+
+} // namespace scales
@@ -0,0 +1,50 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Allocation of the segment pool from PSRAM, which is separate so that the
+ * rest of the pool can be used on the host.
+ */
+
+#include "scales/segment_pool.h"
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace scales {
+
+bool SegmentPool::init(size_t max_bytes, size_t reserve_bytes) {
+	static constexpr uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+	size_t available = ::heap_caps_get_largest_free_block(caps);
+	size_t bytes;
+
+	if (max_bytes) {
+		bytes = std::min(max_bytes, available);
+	} else {
+		bytes = available > reserve_bytes ? available - reserve_bytes : 0;
+	}
+
+	size_t segments = std::min(bytes / SEGMENT_BYTES, (size_t)NONE);
+
+	return init(MemoryAllocation{reinterpret_cast<Data*>(
+		::heap_caps_malloc(segments * SEGMENT_BYTES, caps))}, segments);
+}
+
+} // namespace scales
@@ -0,0 +1,166 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/session.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace scales {
+
+Session::~Session() {
+	clear();
+}
+
+Session::Session(Session &&other) noexcept
+		: realtime_us(other.realtime_us), start_us(other.start_us),
+		stop_us(other.stop_us), period_ns(other.period_ns),
+		jitter_ns(other.jitter_ns), rate_hz(other.rate_hz),
+		compression(other.compression), continuous(other.continuous),
+		chain(std::move(other.chain)), anchors(std::move(other.anchors)),
+		statistics(other.statistics), saved(other.saved),
+		deleted(other.deleted.load()), pool_(other.pool_),
+		segments_(std::move(other.segments_)), count_(other.count_),
+		encoded_(std::move(other.encoded_)), encoded_size_(other.encoded_size_) {
+	other.segments_.clear();
+	other.count_ = 0;
+	other.encoded_.clear();
+	other.encoded_size_ = 0;
+}
+
+Session& Session::operator=(Session &&other) noexcept {
+	if (this != &other) {
+		clear();
+
+		realtime_us = other.realtime_us;
+		start_us = other.start_us;
+		stop_us = other.stop_us;
+		period_ns = other.period_ns;
+		jitter_ns = other.jitter_ns;
+		rate_hz = other.rate_hz;
+		compression = other.compression;
+		continuous = other.continuous;
+		chain = std::move(other.chain);
+		anchors = std::move(other.anchors);
+		statistics = other.statistics;
+		saved = other.saved;
+		deleted = other.deleted.load();
+		pool_ = other.pool_;
+		segments_ = std::move(other.segments_);
+		count_ = other.count_;
+		encoded_ = std::move(other.encoded_);
+		encoded_size_ = other.encoded_size_;
+
+		other.segments_.clear();
+		other.count_ = 0;
+		other.encoded_.clear();
+		other.encoded_size_ = 0;
+	}
+
+	return *this;
+}
+
+bool Session::append(const Data &data) {
+	size_t pos = count_ % SegmentPool::SEGMENT_READINGS;
+
+	if (pos == 0) {
+		SegmentPool::Index index = pool_->allocate();
+
+		if (index == SegmentPool::NONE)
+			return false;
+
+		segments_.push_back(index);
+	}
+
+	pool_->segment(segments_.back())[pos] = data;
+	count_++;
+	return true;
+}
+
+void Session::clear() {
+	for (auto index : segments_)
+		pool_->release(index);
+
+	segments_.clear();
+	count_ = 0;
+	clear_encoded();
+}
+
+void Session::release_readings() {
+	for (auto index : segments_)
+		pool_->release(index);
+
+	segments_.clear();
+}
+
+size_t Session::copy(unsigned long start, Data *data, size_t count) const {
+	unsigned long available = std::min(count_,
+		(unsigned long)(segments_.size() * SegmentPool::SEGMENT_READINGS));
+	size_t copied = 0;
+
+	while (copied < count && start < available) {
+		size_t offset = start % SegmentPool::SEGMENT_READINGS;
+		size_t length = std::min({count - copied, SegmentPool::SEGMENT_READINGS - offset,
+			(size_t)(available - start)});
+
+		std::copy_n(pool_->segment(segments_[start / SegmentPool::SEGMENT_READINGS]) + offset,
+			length, data + copied);
+		copied += length;
+		start += length;
+	}
+
+	return copied;
+}
+
+size_t Session::append_encoded(const uint8_t *data, size_t size) {
+	size_t appended = 0;
+
+	while (size > 0) {
+		size_t pos = encoded_size_ % SegmentPool::SEGMENT_BYTES;
+
+		if (pos == 0) {
+			SegmentPool::Index index = pool_->allocate();
+
+			if (index == SegmentPool::NONE)
+				break;
+
+			encoded_.push_back(index);
+		}
+
+		size_t length = std::min(size, SegmentPool::SEGMENT_BYTES - pos);
+
+		std::memcpy(pool_->bytes(encoded_.back()) + pos, data, length);
+		encoded_size_ += length;
+		appended += length;
+		data += length;
+		size -= length;
+	}
+
+	return appended;
+}
+
+void Session::clear_encoded() {
+	for (auto index : encoded_)
+		pool_->release(index);
+
+	encoded_.clear();
+	encoded_size_ = 0;
+}
+
+} // namespace scales
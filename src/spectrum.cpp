@@ -0,0 +1,204 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace scales {
+
+static_assert((Spectrum::SEGMENT_SIZE & (Spectrum::SEGMENT_SIZE - 1)) == 0);
+
+Spectrum::Spectrum() {
+	constexpr double pi = 3.14159265358979323846;
+
+	for (size_t i = 0; i < SEGMENT_SIZE; i++) {
+		window_[i] = 0.5 - 0.5 * std::cos(2 * pi * i / SEGMENT_SIZE);
+		window_sum_ += window_[i];
+	}
+
+	for (size_t i = 0; i < SEGMENT_SIZE / 2; i++) {
+		cos_[i] = std::cos(2 * pi * i / SEGMENT_SIZE);
+		sin_[i] = std::sin(2 * pi * i / SEGMENT_SIZE);
+	}
+
+	reset();
+}
+
+void Spectrum::reset() {
+	fill_ = 0;
+	power_.fill(0);
+	count_ = 0;
+	segments_ = 0;
+	first_us_ = 0;
+	last_us_ = 0;
+}
+
+void Spectrum::add(uint64_t time_us, int32_t value) {
+	if (count_ == 0)
+		first_us_ = time_us;
+
+	last_us_ = time_us;
+	count_++;
+
+	input_[fill_++] = value;
+
+	if (fill_ == SEGMENT_SIZE) {
+		process();
+
+		std::copy(input_.begin() + HOP_SIZE, input_.end(), input_.begin());
+		fill_ = SEGMENT_SIZE - HOP_SIZE;
+	}
+}
+
+float Spectrum::rate_hz() const {
+	if (count_ < 2 || last_us_ <= first_us_)
+		return 0;
+
+	return (count_ - 1) * 1e6f / (last_us_ - first_us_);
+}
+
+void Spectrum::process() {
+	int64_t sum = 0;
+
+	for (auto value : input_)
+		sum += value;
+
+	/* Remove the mean before converting so that large values don't lose precision */
+	int32_t mean = sum / (int64_t)SEGMENT_SIZE;
+
+	for (size_t i = 0; i < SEGMENT_SIZE; i++) {
+		real_[i] = (input_[i] - mean) * window_[i];
+		imag_[i] = 0;
+	}
+
+	fft();
+
+	for (size_t i = 0; i < BINS; i++)
+		power_[i] += real_[i] * real_[i] + imag_[i] * imag_[i];
+
+	segments_++;
+}
+
+void Spectrum::fft() {
+	/* Iterative radix-2 decimation in time, in place */
+	for (size_t i = 1, j = 0; i < SEGMENT_SIZE; i++) {
+		size_t bit = SEGMENT_SIZE >> 1;
+
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j) {
+			std::swap(real_[i], real_[j]);
+			std::swap(imag_[i], imag_[j]);
+		}
+	}
+
+	for (size_t half = 1; half < SEGMENT_SIZE; half <<= 1) {
+		const size_t step = SEGMENT_SIZE / (half * 2);
+
+		for (size_t start = 0; start < SEGMENT_SIZE; start += half * 2) {
+			for (size_t k = 0; k < half; k++) {
+				const float wr = cos_[k * step];
+				const float wi = -sin_[k * step];
+				const size_t a = start + k;
+				const size_t b = a + half;
+				const float tr = real_[b] * wr - imag_[b] * wi;
+				const float ti = real_[b] * wi + imag_[b] * wr;
+
+				real_[b] = real_[a] - tr;
+				imag_[b] = imag_[a] - ti;
+				real_[a] += tr;
+				imag_[a] += ti;
+			}
+		}
+	}
+}
+
+float Spectrum::amplitude(size_t bin) const {
+	if (segments_ == 0 || bin >= BINS)
+		return 0;
+
+	return 2 * std::sqrt(power_[bin] / segments_) / window_sum_;
+}
+
+size_t Spectrum::peaks(Peak *peaks, size_t count) const {
+	const float resolution = resolution_hz();
+	size_t found = 0;
+
+	if (segments_ == 0 || count == 0)
+		return 0;
+
+	for (size_t i = 1; i < BINS - 1; i++) {
+		if (!(power_[i] > power_[i - 1] && power_[i] >= power_[i + 1]))
+			continue;
+
+		float amplitude = this->amplitude(i);
+
+		/* Parabolic interpolation of the log power at the peak */
+		float frequency = i;
+		float a = std::log(std::max(power_[i - 1], 1e-20f));
+		float b = std::log(power_[i]);
+		float c = std::log(std::max(power_[i + 1], 1e-20f));
+		float denominator = a - 2 * b + c;
+
+		if (denominator < 0) {
+			float offset = 0.5f * (a - c) / denominator;
+
+			frequency += offset;
+			amplitude *= std::exp(-0.125f * (a - c) * offset);
+		}
+
+		if (found == count && amplitude <= peaks[found - 1].amplitude)
+			continue;
+
+		size_t pos = std::min(found, count - 1);
+
+		while (pos > 0 && peaks[pos - 1].amplitude < amplitude) {
+			peaks[pos] = peaks[pos - 1];
+			pos--;
+		}
+
+		peaks[pos] = {frequency * resolution, amplitude};
+		found = std::min(found + 1, count);
+	}
+
+	return found;
+}
+
+void Spectrum::decimate(Peak *points, size_t count) const {
+	const float resolution = resolution_hz();
+	const size_t bins = BINS - 1;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t begin = 1 + i * bins / count;
+		size_t end = std::max(begin + 1, 1 + (i + 1) * bins / count);
+		float amplitude = 0;
+
+		for (size_t bin = begin; bin < end && bin < BINS; bin++)
+			amplitude = std::max(amplitude, this->amplitude(bin));
+
+		points[i] = {(begin + end - 1) * 0.5f * resolution, amplitude};
+	}
+}
+
+} // namespace scales
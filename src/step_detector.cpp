@@ -0,0 +1,161 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/step_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace scales {
+
+StepDetector::StepDetector(const Parameters &parameters) {
+	this->parameters(parameters);
+}
+
+void StepDetector::parameters(const Parameters &parameters) {
+	parameters_ = parameters;
+	parameters_.window = std::clamp(parameters_.window, 2U, MAX_WINDOW);
+	parameters_.step_threshold = std::max(parameters_.step_threshold, (int32_t)2);
+	parameters_.settle_factor = std::max(parameters_.settle_factor, 1U);
+	reset();
+}
+
+void StepDetector::reset() {
+	state_ = State::UNKNOWN;
+	pos_ = 0;
+	count_ = 0;
+	sum_ = 0;
+	sum_sq_ = 0;
+	have_previous_ = false;
+	noise_var_ = 0;
+	level_scaled_ = 0;
+	high_sum_ = 0;
+	low_sum_ = 0;
+	moving_count_ = 0;
+	event_ = {};
+}
+
+uint32_t StepDetector::noise() const {
+	return std::sqrt(noise_var_);
+}
+
+uint8_t StepDetector::update(uint64_t time_us, int32_t value) {
+	const unsigned int window = parameters_.window;
+	const int32_t threshold = parameters_.step_threshold;
+	const int32_t allowance = threshold / 2;
+
+	/*
+	 * The noise is estimated from the differences between adjacent
+	 * readings (which have twice the variance) excluding any that are
+	 * large enough to be part of a step.
+	 */
+	if (have_previous_) {
+		int32_t difference = value - previous_;
+
+		if (std::abs(difference) < allowance) {
+			float variance = (float)difference * difference / 2;
+
+			if (noise_var_ == 0) {
+				noise_var_ = variance;
+			} else {
+				noise_var_ += (variance - noise_var_) / (1 << NOISE_SHIFT);
+			}
+		}
+	}
+
+	have_previous_ = true;
+	previous_ = value;
+
+	if (count_ == window) {
+		int32_t oldest = values_[pos_];
+
+		sum_ -= oldest;
+		sum_sq_ -= (int64_t)oldest * oldest;
+	} else {
+		count_++;
+	}
+
+	values_[pos_] = value;
+	times_[pos_] = time_us;
+	sum_ += value;
+	sum_sq_ += (int64_t)value * value;
+	pos_ = (pos_ + 1) % window;
+
+	if (count_ < window)
+		return 0;
+
+	if (state_ == State::SETTLED) {
+		int32_t difference = value - level();
+
+		if (high_sum_ == 0)
+			high_start_us_ = time_us;
+
+		if (low_sum_ == 0)
+			low_start_us_ = time_us;
+
+		high_sum_ = std::max((int64_t)0, high_sum_ + difference - allowance);
+		low_sum_ = std::max((int64_t)0, low_sum_ - difference - allowance);
+
+		if (high_sum_ > threshold || low_sum_ > threshold) {
+			bool applied = high_sum_ > threshold;
+
+			state_ = State::MOVING;
+			moving_count_ = 0;
+			step_start_us_ = applied ? high_start_us_ : low_start_us_;
+			step_level_ = level();
+			event_ = {applied ? APPLIED : REMOVED, step_start_us_, step_level_, 0, 0};
+			return event_.type;
+		}
+
+		/* Follow slow drift */
+		level_scaled_ += value - level();
+		return 0;
+	}
+
+	if (state_ == State::MOVING && ++moving_count_ < window)
+		return 0;
+
+	/* n^2 * variance of the window, compared without dividing */
+	float variance_n2 = (float)((int64_t)window * sum_sq_ - sum_ * sum_);
+	float settled_var = (float)parameters_.settle_factor * parameters_.settle_factor
+		* std::max(noise_var_, 1.0f) * window * window;
+
+	if (variance_n2 >= settled_var)
+		return 0;
+
+	int32_t mean = sum_ / (int64_t)window;
+	uint64_t window_start_us = times_[pos_];
+
+	level_scaled_ = (int64_t)mean << LEVEL_SHIFT;
+	high_sum_ = 0;
+	low_sum_ = 0;
+
+	if (state_ == State::UNKNOWN) {
+		state_ = State::SETTLED;
+		return 0;
+	}
+
+	state_ = State::SETTLED;
+	event_ = {SETTLED, window_start_us, mean, mean - step_level_,
+		window_start_us > step_start_us_ ? window_start_us - step_start_us_ : 0};
+	return event_.type;
+}
+
+} // namespace scales
@@ -0,0 +1,82 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/tar.h"
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <time.h>
+
+namespace scales {
+
+TarWriter::TarWriter(Print &output) : output_(output) {
+}
+
+void TarWriter::begin_file(const std::string_view name, size_t size, time_t mtime) {
+	uint8_t header[BLOCK_SIZE]{};
+	unsigned int checksum = 0;
+
+	std::memcpy(&header[0], name.data(), std::min(name.size(), (size_t)99));
+	::snprintf(reinterpret_cast<char*>(&header[100]), 8, "%07o", 0644);
+	::snprintf(reinterpret_cast<char*>(&header[108]), 8, "%07o", 0);
+	::snprintf(reinterpret_cast<char*>(&header[116]), 8, "%07o", 0);
+	::snprintf(reinterpret_cast<char*>(&header[124]), 12, "%011lo", (unsigned long)size);
+	::snprintf(reinterpret_cast<char*>(&header[136]), 12, "%011lo",
+		(unsigned long)std::max(mtime, (time_t)0));
+	std::memset(&header[148], ' ', 8);
+	header[156] = '0';
+	std::memcpy(&header[257], "ustar\0" "00", 8);
+
+	for (auto value : header)
+		checksum += value;
+
+	::snprintf(reinterpret_cast<char*>(&header[148]), 7, "%06o", checksum);
+
+	output_.write(header, sizeof(header));
+	size_ = size;
+}
+
+void TarWriter::end_file(size_t written) {
+	/* The header has already been sent so the size must match */
+	if (written < size_)
+		write_zeros(size_ - written);
+
+	write_zeros((BLOCK_SIZE - (size_ % BLOCK_SIZE)) % BLOCK_SIZE);
+	size_ = 0;
+}
+
+void TarWriter::finish() {
+	write_zeros(BLOCK_SIZE * 2);
+}
+
+void TarWriter::write_zeros(size_t length) {
+	static const uint8_t zeros[64]{};
+
+	while (length > 0) {
+		size_t chunk = std::min(length, sizeof(zeros));
+
+		output_.write(zeros, chunk);
+		length -= chunk;
+	}
+}
+
+} // namespace scales
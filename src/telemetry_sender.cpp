@@ -0,0 +1,254 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "scales/telemetry_sender.h"
+
+#include <Arduino.h>
+
+#include <esp_mac.h>
+#include <lwip/sockets.h>
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <sys/time.h>
+
+#include <uuid/log.h>
+
+#include "app/app.h"
+#include "app/fs.h"
+
+#ifndef PSTR_ALIGN
+# define PSTR_ALIGN 4
+#endif
+
+using app::FS;
+
+static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN))) PROGMEM = "telemetry";
+
+namespace scales {
+
+uuid::log::Logger TelemetrySender::logger_{FPSTR(__pstr__logger_name), uuid::log::Facility::DAEMON};
+
+TelemetrySender::TelemetrySender(HX711 &hx711) : hx711_(hx711) {
+}
+
+void TelemetrySender::start() {
+	std::string destination;
+
+	esp_read_mac(header_.device.data(), ESP_MAC_WIFI_STA);
+
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+
+		if (FS.exists(FILENAME)) {
+			auto file = FS.open(FILENAME);
+
+			if (file) {
+				char buf[64];
+				size_t len = file.readBytes(buf, sizeof(buf));
+
+				while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+					len--;
+
+				destination.assign(buf, len);
+			}
+		}
+	}
+
+	if (!destination.empty()) {
+		std::lock_guard lock{mutex_};
+
+		if (parse(destination, address_, port_)) {
+			destination_ = destination;
+		} else {
+			logger_.err(F("Invalid destination %s"), destination.c_str());
+		}
+	}
+
+	if (xTaskCreate(task, "telemetry", STACK_SIZE, this, uxTaskPriorityGet(nullptr),
+			&task_) != pdPASS) {
+		logger_.crit(F("Failed to start task"));
+		task_ = nullptr;
+	}
+}
+
+std::string TelemetrySender::destination() const {
+	std::lock_guard lock{mutex_};
+	return destination_;
+}
+
+bool TelemetrySender::destination(const std::string &destination) {
+	in_addr address{};
+	uint16_t port = 0;
+
+	if (!destination.empty() && !parse(destination, address, port))
+		return false;
+
+	{
+		std::lock_guard lock{mutex_};
+		destination_ = destination;
+		address_ = address;
+		port_ = port;
+	}
+
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+
+		if (destination.empty()) {
+			FS.remove(FILENAME);
+		} else {
+			auto file = FS.open(FILENAME, "w");
+
+			if (!file || file.printf("%s\n", destination.c_str()) <= 0)
+				logger_.err(F("Unable to save destination"));
+		}
+	}
+
+	if (task_)
+		xTaskNotifyGive(task_);
+
+	return true;
+}
+
+bool TelemetrySender::parse(const std::string &destination, in_addr &address, uint16_t &port) {
+	std::string host = destination;
+	size_t colon = destination.find(':');
+
+	port = telemetry::DEFAULT_PORT;
+
+	if (colon != std::string::npos) {
+		char *end = nullptr;
+		unsigned long value = std::strtoul(destination.c_str() + colon + 1, &end, 10);
+
+		if (colon + 1 == destination.length() || *end != '\0' || value == 0 || value > UINT16_MAX)
+			return false;
+
+		host = destination.substr(0, colon);
+		port = value;
+	}
+
+	return inet_aton(host.c_str(), &address) != 0;
+}
+
+void TelemetrySender::task(void *arg) {
+	static_cast<TelemetrySender*>(arg)->run();
+}
+
+void TelemetrySender::run() {
+	int fd = -1;
+	bool enabled = false;
+
+	while (true) {
+		sockaddr_in destination{};
+
+		destination.sin_family = AF_INET;
+
+		{
+			std::lock_guard lock{mutex_};
+			destination.sin_addr = address_;
+			destination.sin_port = htons(port_);
+		}
+
+		if (destination.sin_port == 0) {
+			enabled = false;
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			continue;
+		}
+
+		if (!enabled) {
+			/* Start with the next reading instead of old ones */
+			index_ = hx711_.live_index();
+			enabled = true;
+		}
+
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INTERVAL_MS));
+
+		if (fd < 0) {
+			fd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+			if (fd < 0) {
+				logger_.err(F("Unable to create socket"));
+				stats_.errors.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+
+			uint8_t ttl = MULTICAST_TTL;
+
+			::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+		}
+
+		while (true) {
+			uint32_t index = index_;
+			size_t count = hx711_.live_readings(index, readings_.data(), readings_.size());
+
+			if (index != index_)
+				stats_.overruns.fetch_add(index - index_, std::memory_order_relaxed);
+
+			index_ = index;
+
+			if (count == 0)
+				break;
+
+			if (!send(fd, destination, count))
+				stats_.errors.fetch_add(1, std::memory_order_relaxed);
+
+			index_ += count;
+
+			if (count < readings_.size())
+				break;
+		}
+	}
+}
+
+bool TelemetrySender::send(int fd, const sockaddr_in &destination, size_t count) {
+	const HX711::LiveReading &first = readings_[0];
+	struct timeval realtime;
+	uint64_t now_us = hx711_.now_us();
+
+	gettimeofday(&realtime, nullptr);
+
+	header_.flags = hx711_.running() ? telemetry::Flags::RECORDING : 0;
+	header_.count = count;
+	header_.index = index_;
+	header_.time_us = first.time_us - first.data.offset_us;
+	header_.realtime_us = (uint64_t)realtime.tv_sec * 1000000ULL + realtime.tv_usec
+		- (now_us - header_.time_us);
+	header_.period_ns = hx711_.stats().period_ns.load(std::memory_order_relaxed);
+	header_.tare_value = first.tare_value;
+
+	for (size_t i = 0; i < count; i++)
+		entries_[i] = readings_[i].data;
+
+	size_t length = telemetry::encode(header_, entries_.data(), buffer_.data());
+
+	header_.sequence++;
+
+	if (::sendto(fd, buffer_.data(), length, 0,
+			reinterpret_cast<const sockaddr*>(&destination), sizeof(destination)) < 0) {
+		logger_.debug(F("Unable to send %zu readings: %d"), count, errno);
+		return false;
+	}
+
+	stats_.packets.fetch_add(1, std::memory_order_relaxed);
+	stats_.readings.fetch_add(count, std::memory_order_relaxed);
+	return true;
+}
+
+} // namespace scales
@@ -0,0 +1,268 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/trace.h"
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <uuid/log.h>
+
+#include "scales/trace_buffer.h"
+
+#ifndef PSTR_ALIGN
+# define PSTR_ALIGN 4
+#endif
+
+/* Number of events to keep, which must be a power of 2 (or 0 to disable) */
+#ifndef SCALES_TRACE_EVENTS
+# define SCALES_TRACE_EVENTS 16384
+#endif
+
+static_assert((SCALES_TRACE_EVENTS & (SCALES_TRACE_EVENTS - 1)) == 0,
+	"SCALES_TRACE_EVENTS must be a power of 2");
+
+static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN))) PROGMEM = "trace";
+
+namespace scales {
+
+namespace trace {
+
+/* Tasks after this share the same ID */
+static constexpr size_t MAX_TASKS = 32;
+static constexpr unsigned int OVERHEAD_EVENTS = 1000;
+
+static uuid::log::Logger logger{FPSTR(__pstr__logger_name), uuid::log::Facility::DAEMON};
+static Buffer buffer;
+static std::atomic<bool> enabled_{false};
+static uint32_t overhead_ns_{0};
+
+static std::mutex tasks_mutex;
+static std::array<std::array<char,configMAX_TASK_NAME_LEN>,MAX_TASKS> task_names{};
+static uint8_t task_count{0};
+static thread_local uint8_t current_task{0};
+
+/* Returns an ID for the current task, starting at 1 */
+static uint8_t task_id() {
+	if (current_task == 0) {
+		std::lock_guard lock{tasks_mutex};
+
+		if (task_count < MAX_TASKS) {
+			std::strncpy(task_names[task_count].data(), ::pcTaskGetName(nullptr),
+				task_names[task_count].size() - 1);
+			current_task = ++task_count;
+		} else {
+			current_task = MAX_TASKS + 1;
+		}
+	}
+
+	return current_task;
+}
+
+static inline void add_span(Phase phase, Category category, const char *name,
+		const char *detail) {
+	Event event;
+
+	event.time_us = ::esp_timer_get_time();
+	event.name = name;
+	event.detail = detail;
+	event.task = task_id();
+	event.phase = phase;
+	event.category = category;
+	buffer.add(event);
+}
+
+void init() {
+	static constexpr uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+	size_t count = SCALES_TRACE_EVENTS;
+
+	if (!count)
+		return;
+
+	void *memory = ::heap_caps_malloc(count * sizeof(Buffer::Slot), caps);
+
+	if (!memory) {
+		logger.crit(F("Unable to allocate buffer for %zu events"), count);
+		return;
+	}
+
+	Buffer::Slot *slots = static_cast<Buffer::Slot*>(memory);
+
+	for (size_t i = 0; i < count; i++)
+		new (&slots[i]) Buffer::Slot{};
+
+	buffer.init(slots, count);
+	enabled_ = true;
+
+	uint64_t start_us = ::esp_timer_get_time();
+
+	for (unsigned int i = 0; i < OVERHEAD_EVENTS / 2; i++) {
+		begin(Category::LOOP, "overhead");
+		end(Category::LOOP, "overhead");
+	}
+
+	overhead_ns_ = (::esp_timer_get_time() - start_us) * 1000 / OVERHEAD_EVENTS;
+	buffer.clear();
+
+	logger.info(F("Buffer for %zu events (%zuKB), %luns per event"), count,
+		count * sizeof(Buffer::Slot) / 1024, (unsigned long)overhead_ns_);
+}
+
+bool enabled() {
+	return enabled_.load(std::memory_order_relaxed);
+}
+
+void enabled(bool enabled) {
+	if (buffer.capacity())
+		enabled_ = enabled;
+}
+
+void clear() {
+	buffer.clear();
+}
+
+size_t capacity() {
+	return buffer.capacity();
+}
+
+uint32_t count() {
+	return buffer.count();
+}
+
+uint32_t overhead_ns() {
+	return overhead_ns_;
+}
+
+void begin(Category category, const char *name, const char *detail) {
+	if (enabled())
+		add_span(Phase::BEGIN, category, name, detail);
+}
+
+void end(Category category, const char *name, const char *detail) {
+	if (enabled())
+		add_span(Phase::END, category, name, detail);
+}
+
+void complete(Category category, const char *name, uint64_t start_us,
+		uint32_t min_duration_us) {
+	if (!enabled())
+		return;
+
+	uint64_t duration_us = ::esp_timer_get_time() - start_us;
+
+	if (duration_us < min_duration_us)
+		return;
+
+	Event event;
+
+	event.time_us = start_us;
+	event.name = name;
+	event.duration_us = std::min(duration_us, (uint64_t)UINT32_MAX);
+	event.task = task_id();
+	event.phase = Phase::COMPLETE;
+	event.category = category;
+	buffer.add(event);
+}
+
+void counter(Category category, const char *name, int32_t value) {
+	if (!enabled())
+		return;
+
+	Event event;
+
+	event.time_us = ::esp_timer_get_time();
+	event.name = name;
+	event.value = value;
+	event.task = task_id();
+	event.phase = Phase::COUNTER;
+	event.category = category;
+	buffer.add(event);
+}
+
+static void write_escaped(Print &output, const char *text) {
+	for (; *text; text++) {
+		if (*text == '"' || *text == '\\') {
+			output.write('\\');
+			output.write(*text);
+		} else if ((uint8_t)*text < 0x20) {
+			output.printf("\\u%04x", *text);
+		} else {
+			output.write(*text);
+		}
+	}
+}
+
+void write_json(Print &output) {
+	output.printf("{\"traceEvents\":[\n");
+	output.printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+		"\"args\":{\"name\":\"hx711-weigh-scales-logger\"}}");
+
+	{
+		std::lock_guard lock{tasks_mutex};
+
+		for (size_t i = 0; i < task_count; i++) {
+			output.printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,"
+				"\"args\":{\"name\":\"", i + 1);
+			write_escaped(output, task_names[i].data());
+			output.printf("\"}}");
+		}
+
+		if (task_count == MAX_TASKS) {
+			output.printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,"
+				"\"args\":{\"name\":\"other tasks\"}}", MAX_TASKS + 1);
+		}
+	}
+
+	buffer.for_each([&output] (const Event &event) {
+		output.printf(",\n{\"name\":\"");
+		write_escaped(output, event.name);
+
+		if ((event.phase == Phase::BEGIN || event.phase == Phase::END) && event.detail) {
+			output.write(' ');
+			write_escaped(output, event.detail);
+		}
+
+		output.printf("\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%u",
+			category_name(event.category), (char)event.phase, event.time_us, event.task);
+
+		if (event.phase == Phase::COMPLETE) {
+			output.printf(",\"dur\":%lu", (unsigned long)event.duration_us);
+		} else if (event.phase == Phase::COUNTER) {
+			output.printf(",\"args\":{\"");
+			write_escaped(output, event.name);
+			output.printf("\":%ld}", (long)event.value);
+		}
+
+		output.write('}');
+	});
+
+	output.printf("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"capacity\":%zu,"
+		"\"events\":%lu,\"event_overhead_ns\":%lu}}\n",
+		buffer.capacity(), (unsigned long)buffer.count(), (unsigned long)overhead_ns_);
+}
+
+} // namespace trace
+
+} // namespace scales
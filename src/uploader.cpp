@@ -0,0 +1,405 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "scales/uploader.h"
+
+#include <Arduino.h>
+
+#include <esp_http_client.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <strings.h>
+#include <vector>
+
+#include <uuid/log.h>
+
+#include "app/app.h"
+#include "app/fs.h"
+
+#ifndef PSTR_ALIGN
+# define PSTR_ALIGN 4
+#endif
+
+using app::FS;
+
+static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN))) PROGMEM = "uploader";
+
+namespace scales {
+
+uuid::log::Logger Uploader::logger_{FPSTR(__pstr__logger_name), uuid::log::Facility::DAEMON};
+
+Uploader::Uploader(HX711 &hx711) : hx711_(hx711) {
+}
+
+void Uploader::start() {
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+
+		if (FS.exists(URL_FILENAME)) {
+			auto file = FS.open(URL_FILENAME);
+
+			if (file) {
+				char buf[256];
+				size_t len = file.readBytes(buf, sizeof(buf));
+
+				while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+					len--;
+
+				std::lock_guard lock{mutex_};
+				url_.assign(buf, len);
+			}
+		}
+	}
+
+	load_index();
+
+	if (xTaskCreate(task, "uploader", STACK_SIZE, this, uxTaskPriorityGet(nullptr),
+			&task_) != pdPASS) {
+		logger_.crit(F("Failed to start task"));
+		task_ = nullptr;
+	}
+}
+
+std::string Uploader::url() const {
+	std::lock_guard lock{mutex_};
+	return url_;
+}
+
+void Uploader::url(const std::string &url) {
+	{
+		std::lock_guard lock{mutex_};
+		url_ = url;
+	}
+
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+
+		if (url.empty()) {
+			FS.remove(URL_FILENAME);
+		} else {
+			auto file = FS.open(URL_FILENAME, "w");
+
+			if (!file || file.printf("%s\n", url.c_str()) <= 0)
+				logger_.err(F("Unable to save URL"));
+		}
+	}
+
+	wake();
+}
+
+void Uploader::wake() {
+	if (task_)
+		xTaskNotifyGive(task_);
+}
+
+bool Uploader::uploaded(const std::string_view filename) const {
+	std::lock_guard lock{mutex_};
+	return uploaded_.find(std::string{filename}) != uploaded_.end();
+}
+
+size_t Uploader::pending() const {
+	return pending_files().size();
+}
+
+void Uploader::load_index() {
+	std::vector<std::string> filenames;
+
+	{
+		std::lock_guard lock{app::App::file_mutex()};
+
+		if (!FS.exists(INDEX_FILENAME))
+			return;
+
+		auto file = FS.open(INDEX_FILENAME);
+		std::string filename;
+
+		while (file && file.available() > 0) {
+			int c = file.read();
+
+			if (c < 0)
+				break;
+
+			if (c == '\n') {
+				if (!filename.empty())
+					filenames.push_back(std::move(filename));
+				filename.clear();
+			} else {
+				filename.push_back(c);
+			}
+		}
+	}
+
+	/* Forget recordings that have been deleted */
+	size_t count = filenames.size();
+
+	filenames.erase(std::remove_if(filenames.begin(), filenames.end(),
+		[this] (const std::string &filename) { return !hx711_.file_exists(filename); }),
+		filenames.end());
+
+	if (filenames.size() != count) {
+		std::lock_guard lock{app::App::file_mutex()};
+		auto file = FS.open(INDEX_FILENAME, "w");
+
+		for (const auto &filename : filenames)
+			file.printf("%s\n", filename.c_str());
+	}
+
+	std::lock_guard lock{mutex_};
+	uploaded_.insert(filenames.begin(), filenames.end());
+}
+
+void Uploader::add_index(const std::string &filename) {
+	{
+		std::lock_guard lock{mutex_};
+		uploaded_.insert(filename);
+	}
+
+	std::lock_guard lock{app::App::file_mutex()};
+	auto file = FS.open(INDEX_FILENAME, "a");
+
+	if (!file || file.printf("%s\n", filename.c_str()) <= 0)
+		logger_.err(F("Unable to add %s to the index"), filename.c_str());
+}
+
+std::vector<std::string> Uploader::pending_files() const {
+	std::vector<std::string> filenames;
+
+	hx711_.list_files([this, &filenames] (std::string_view filename,
+			std::string_view timestamp, bool resident,
+			const recording::Statistics *statistics) {
+		std::lock_guard lock{mutex_};
+
+		if (uploaded_.find(std::string{filename}) == uploaded_.end())
+			filenames.emplace_back(filename);
+	});
+
+	return filenames;
+}
+
+void Uploader::task(void *arg) {
+	static_cast<Uploader*>(arg)->run();
+}
+
+void Uploader::run() {
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INTERVAL_MS));
+
+		std::string base = url();
+
+		if (base.empty())
+			continue;
+
+		if (base.back() != '/')
+			base.push_back('/');
+
+		auto filenames = pending_files();
+		auto it = filenames.begin();
+
+		/* Upload in batches, with a new connection for each one */
+		while (it != filenames.end()) {
+			esp_http_client_config_t config{};
+
+			config.url = base.c_str();
+			config.timeout_ms = TIMEOUT_MS;
+			config.disable_auto_redirect = true;
+			config.event_handler = event_handler;
+			config.user_data = this;
+			config.keep_alive_enable = true;
+
+			esp_http_client_handle_t client = esp_http_client_init(&config);
+
+			if (!client) {
+				logger_.err(F("Unable to create HTTP client"));
+				stats_.errors.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+
+			stats_.connections.fetch_add(1, std::memory_order_relaxed);
+
+			bool ok = true;
+
+			for (size_t count = 0; ok && count < BATCH_FILES && it != filenames.end(); ++it) {
+				bool complete = false;
+
+				ok = upload(client, base, *it, complete);
+
+				if (complete) {
+					add_index(*it);
+					count++;
+				}
+			}
+
+			esp_http_client_cleanup(client);
+
+			if (!ok) {
+				/* Try again later */
+				stats_.errors.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+		}
+	}
+}
+
+esp_err_t Uploader::event_handler(esp_http_client_event_t *event) {
+	Uploader *self = static_cast<Uploader*>(event->user_data);
+
+	if (event->event_id == HTTP_EVENT_ON_HEADER
+			&& !::strcasecmp(event->header_key, "Upload-Offset")) {
+		self->response_.offset = std::strtol(event->header_value, nullptr, 10);
+	}
+
+	return ESP_OK;
+}
+
+long Uploader::remote_offset(esp_http_client_handle_t client, const std::string &url) {
+	esp_http_client_set_url(client, url.c_str());
+	esp_http_client_set_method(client, HTTP_METHOD_HEAD);
+	esp_http_client_delete_header(client, "Upload-Offset");
+	esp_http_client_delete_header(client, "Upload-Length");
+	response_ = {};
+
+	esp_err_t err = esp_http_client_open(client, 0);
+
+	if (err != ESP_OK) {
+		logger_.err(F("Unable to connect to %s: %s"), url.c_str(), esp_err_to_name(err));
+		return -1;
+	}
+
+	if (esp_http_client_fetch_headers(client) < 0) {
+		logger_.err(F("No response from %s"), url.c_str());
+		esp_http_client_close(client);
+		return -1;
+	}
+
+	int status = esp_http_client_get_status_code(client);
+
+	esp_http_client_flush_response(client, nullptr);
+
+	if (status == 404)
+		return 0;
+
+	if (status == 200 && response_.offset >= 0)
+		return response_.offset;
+
+	logger_.err(F("Unexpected status %d from HEAD %s"), status, url.c_str());
+	return -1;
+}
+
+bool Uploader::upload(esp_http_client_handle_t client, const std::string &base,
+		const std::string &filename, bool &complete) {
+	std::string url = base + filename + ".cbor";
+	size_t size;
+
+	complete = false;
+	hx711_.read_file(filename, 0, buffer_.data(), 0, size);
+
+	if (size == 0) {
+		/* Not saved yet */
+		return true;
+	}
+
+	long offset = remote_offset(client, url);
+
+	if (offset < 0)
+		return false;
+
+	if ((size_t)offset == size) {
+		complete = true;
+		return true;
+	}
+
+	if ((size_t)offset > size) {
+		logger_.warning(F("Collector has %ld bytes of %s but it is only %zu bytes"),
+			offset, filename.c_str(), size);
+		return true;
+	}
+
+	char header[HEADER_SIZE];
+
+	esp_http_client_set_url(client, url.c_str());
+	esp_http_client_set_method(client, HTTP_METHOD_POST);
+	esp_http_client_set_header(client, "Content-Type", "application/cbor");
+	::snprintf(header, sizeof(header), "%ld", offset);
+	esp_http_client_set_header(client, "Upload-Offset", header);
+	::snprintf(header, sizeof(header), "%zu", size);
+	esp_http_client_set_header(client, "Upload-Length", header);
+	response_ = {};
+
+	esp_err_t err = esp_http_client_open(client, size - offset);
+
+	if (err != ESP_OK) {
+		logger_.err(F("Unable to connect to %s: %s"), url.c_str(), esp_err_to_name(err));
+		return false;
+	}
+
+	if (offset > 0) {
+		logger_.info(F("Resuming upload of %s from %ld/%zu"), filename.c_str(), offset, size);
+		stats_.resumed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t pos = offset;
+
+	while (pos < size) {
+		size_t file_size;
+		size_t len = hx711_.read_file(filename, pos, buffer_.data(), buffer_.size(), file_size);
+
+		if (len == 0 || file_size != size) {
+			logger_.err(F("Unable to read %s"), filename.c_str());
+			esp_http_client_close(client);
+			return false;
+		}
+
+		if (esp_http_client_write(client, reinterpret_cast<const char*>(buffer_.data()), len) != (int)len) {
+			logger_.err(F("Failed to send %s"), filename.c_str());
+			esp_http_client_close(client);
+			return false;
+		}
+
+		pos += len;
+		stats_.bytes.fetch_add(len, std::memory_order_relaxed);
+	}
+
+	if (esp_http_client_fetch_headers(client) < 0) {
+		logger_.err(F("No response from %s"), url.c_str());
+		esp_http_client_close(client);
+		return false;
+	}
+
+	int status = esp_http_client_get_status_code(client);
+
+	esp_http_client_flush_response(client, nullptr);
+
+	if (status / 100 != 2 || response_.offset != (long)size) {
+		logger_.err(F("Failed to upload %s: status %d, offset %ld/%zu"),
+			filename.c_str(), status, response_.offset, size);
+		return false;
+	}
+
+	logger_.info(F("Uploaded %s (%zu bytes)"), filename.c_str(), size);
+	stats_.files.fetch_add(1, std::memory_order_relaxed);
+	complete = true;
+	return true;
+}
+
+} // namespace scales
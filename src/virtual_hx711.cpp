@@ -0,0 +1,291 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/virtual_hx711.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace scales {
+
+VirtualHX711::VirtualHX711(Clock clock, unsigned int rate_hz, float noise, uint32_t seed)
+		: clock_(clock), period_us_(1000000 / std::max(1U, rate_hz)),
+		noise_(noise), random_(seed) {
+}
+
+void VirtualHX711::init() {
+	uint64_t now = now_us();
+	std::lock_guard lock{mutex_};
+
+	next_conversion_us_ = now + period_us_;
+	profile_start_us_ = now;
+	ready_ = false;
+	pulses_ = 0;
+}
+
+uint64_t VirtualHX711::now_us() {
+	if (clock_ == Clock::VIRTUAL)
+		return virtual_us_;
+
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void VirtualHX711::delay_us(uint32_t us) {
+	if (clock_ == Clock::VIRTUAL) {
+		virtual_us_ += us;
+	} else {
+		uint64_t end = now_us() + us;
+
+		while (now_us() < end);
+	}
+}
+
+uint64_t VirtualHX711::ready_us() {
+	if (ready_ && pulses_ == 0)
+		return conversion_us_;
+
+	return now_us();
+}
+
+bool VirtualHX711::data() {
+	if (powered_down_)
+		return true;
+
+	if (pulses_ == 0) {
+		uint64_t now = now_us();
+
+		if (!ready_ && clock_ == Clock::VIRTUAL && now < next_conversion_us_) {
+			/* Skip ahead to the next conversion */
+			virtual_us_ = next_conversion_us_;
+			now = virtual_us_;
+		}
+
+		update(now);
+		return !ready_;
+	}
+
+	/* The most significant bit is output first */
+	if (ready_ && pulses_ <= 24)
+		return (conversion_ >> (24 - pulses_)) & 1;
+
+	return true;
+}
+
+void VirtualHX711::sck(bool level) {
+	if (level == sck_)
+		return;
+
+	sck_ = level;
+
+	if (level) {
+		sck_high_us_ = now_us();
+
+		if (!ready_)
+			return;
+
+		/*
+		 * The 25th pulse sets the gain to 128 for the next conversion and
+		 * the data pin goes high until the next conversion is ready.
+		 */
+		if (++pulses_ == 25)
+			ready_ = false;
+	} else {
+		if (now_us() - sck_high_us_ >= POWER_DOWN_US) {
+			/* Holding the clock high powers down and resets the HX711 */
+			powered_down_ = false;
+			init();
+			return;
+		}
+
+		if (!ready_)
+			pulses_ = 0;
+	}
+}
+
+void VirtualHX711::update(uint64_t now) {
+	if (sck_ && now - sck_high_us_ >= POWER_DOWN_US) {
+		powered_down_ = true;
+		return;
+	}
+
+	if (now < next_conversion_us_)
+		return;
+
+	std::lock_guard lock{mutex_};
+
+	/* Conversions that were never read are replaced by newer ones */
+	uint64_t missed = (now - next_conversion_us_) / period_us_;
+
+	if (ready_ || missed > 0)
+		overwritten_ += missed + (ready_ ? 1 : 0);
+
+	uint64_t time_us = next_conversion_us_ + missed * period_us_;
+	float value = value_at(time_us - profile_start_us_);
+
+	if (vibration_amplitude_ > 0) {
+		constexpr double pi = 3.14159265358979323846;
+		double phase = std::fmod((time_us - profile_start_us_) * 1e-6 * vibration_hz_, 1.0);
+
+		value += vibration_amplitude_ * std::sin(2 * pi * phase);
+	}
+
+	if (noise_ > 0)
+		value += distribution_(random_) * noise_;
+
+	value = std::max(-8388608.0f, std::min(8388607.0f, std::round(value)));
+
+	conversion_ = static_cast<int32_t>(value) & 0xFFFFFF;
+	conversion_us_ = time_us;
+	next_conversion_us_ = time_us + period_us_;
+	ready_ = true;
+}
+
+int32_t VirtualHX711::value_at(uint64_t time_us) const {
+	if (profile_.empty())
+		return 0;
+
+	auto next = std::upper_bound(profile_.begin(), profile_.end(), time_us,
+		[] (uint64_t time_us, const Point &point) { return time_us < point.time_us; });
+
+	if (next == profile_.begin())
+		return next->value;
+
+	if (next == profile_.end())
+		return profile_.back().value;
+
+	auto previous = next - 1;
+	double fraction = (double)(time_us - previous->time_us) / (next->time_us - previous->time_us);
+
+	return std::lround(previous->value + (next->value - previous->value) * fraction);
+}
+
+unsigned int VirtualHX711::rate() const {
+	std::lock_guard lock{mutex_};
+	return 1000000 / period_us_;
+}
+
+void VirtualHX711::rate(unsigned int rate_hz) {
+	std::lock_guard lock{mutex_};
+	period_us_ = 1000000 / std::max(1U, std::min(1000U, rate_hz));
+}
+
+bool VirtualHX711::select_rate(unsigned int rate_hz) {
+	rate(rate_hz);
+	return true;
+}
+
+float VirtualHX711::noise() const {
+	std::lock_guard lock{mutex_};
+	return noise_;
+}
+
+void VirtualHX711::noise(float stddev) {
+	std::lock_guard lock{mutex_};
+	noise_ = std::max(0.0f, stddev);
+}
+
+float VirtualHX711::vibration_hz() const {
+	std::lock_guard lock{mutex_};
+	return vibration_hz_;
+}
+
+float VirtualHX711::vibration_amplitude() const {
+	std::lock_guard lock{mutex_};
+	return vibration_amplitude_;
+}
+
+void VirtualHX711::vibration(float frequency_hz, float amplitude) {
+	std::lock_guard lock{mutex_};
+	vibration_hz_ = std::max(0.0f, frequency_hz);
+	vibration_amplitude_ = std::max(0.0f, amplitude);
+}
+
+std::string VirtualHX711::profile() const {
+	std::lock_guard lock{mutex_};
+	std::string script;
+
+	for (const auto &point : profile_) {
+		char buffer[32];
+
+		if (!script.empty())
+			script.append(" ");
+
+		std::snprintf(buffer, sizeof(buffer), "%.6g:%ld",
+			point.time_us / 1e6, (long)point.value);
+		script.append(buffer);
+	}
+
+	return script;
+}
+
+bool VirtualHX711::profile(std::string_view script) {
+	std::vector<Point> points;
+
+	while (!script.empty()) {
+		auto end = script.find_first_of(" ,");
+		std::string item{script.substr(0, end)};
+
+		script.remove_prefix(end == std::string_view::npos ? script.size() : end + 1);
+
+		if (item.empty())
+			continue;
+
+		auto colon = item.find(':');
+
+		if (colon == std::string::npos)
+			return false;
+
+		char *time_end;
+		char *value_end;
+		double time_s = std::strtod(item.c_str(), &time_end);
+		long value = std::strtol(item.c_str() + colon + 1, &value_end, 10);
+
+		if (time_end != item.c_str() + colon || *value_end != '\0'
+				|| !(time_s >= 0) || value < -8388608 || value > 8388607)
+			return false;
+
+		Point point{static_cast<uint64_t>(std::llround(time_s * 1e6)), static_cast<int32_t>(value)};
+
+		if (!points.empty() && point.time_us < points.back().time_us)
+			return false;
+
+		points.push_back(point);
+	}
+
+	profile(std::move(points));
+	return true;
+}
+
+void VirtualHX711::profile(std::vector<Point> points) {
+	uint64_t now = now_us();
+	std::lock_guard lock{mutex_};
+
+	profile_ = std::move(points);
+	profile_start_us_ = now;
+}
+
+} // namespace scales
@@ -18,24 +18,38 @@
 
 #include "scales/web_interface.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <time.h>
 #include <vector>
 
 #include "app/config.h"
+#include "app/fs.h"
+#include "scales/allocations.h"
 #include "scales/app.h"
+#include "scales/form.h"
+#include "scales/recording.h"
+#include "scales/spectrum.h"
+#include "scales/step_detector.h"
+#include "scales/tar.h"
+#include "scales/trace.h"
 #include "scales/web_server.h"
+#include "scales/xml_writer.h"
 #include "htdocs/files.xml.gz.h"
+#include "htdocs/spectrum.xml.gz.h"
 #include "htdocs/status.xml.gz.h"
 
 #ifndef PSTR_ALIGN
 # define PSTR_ALIGN 4
 #endif
 
-using uuid::log::format_timestamp_ms;
+using app::FS;
 
 static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN))) PROGMEM = "web-interface";
 
@@ -58,10 +72,31 @@ WebInterface::WebInterface(App &app) : app_(app) {
 		"application/xslt+xml", gzip_immutable_headers, htdocs_status_xml_gz);
 
 	server_.add_get_handler("/files", std::bind(&WebInterface::files, this, _1));
-	server_.add_get_handler("/download/*", std::bind(&WebInterface::access_file, this, _1));
+	server_.add_get_handler("/download/*", std::bind(&WebInterface::access_file, this, _1), true);
 	server_.add_get_handler("/delete/*", std::bind(&WebInterface::access_file, this, _1));
+	server_.add_get_handler("/archive", std::bind(&WebInterface::archive, this, _1), true);
+	server_.add_post_handler("/delete", std::bind(&WebInterface::delete_files, this, _1));
 	server_.add_static_content("/" + app_.immutable_id() + "/files.xml",
 		"application/xslt+xml", gzip_immutable_headers, htdocs_files_xml_gz);
+
+	server_.add_get_handler("/spectrum/*", std::bind(&WebInterface::spectrum, this, _1), true);
+	server_.add_static_content("/" + app_.immutable_id() + "/spectrum.xml",
+		"application/xslt+xml", gzip_immutable_headers, htdocs_spectrum_xml_gz);
+
+	server_.add_get_handler("/metrics", std::bind(&WebInterface::metrics, this, _1));
+	server_.add_get_handler("/trace", std::bind(&WebInterface::trace_events, this, _1), true);
+}
+
+static std::string_view format_timestamp_ms(uint64_t timestamp_ms, char *buffer, size_t size) {
+	unsigned long days = timestamp_ms / 86400000UL;
+	unsigned int hours = (timestamp_ms / 3600000UL) % 24;
+	unsigned int minutes = (timestamp_ms / 60000UL) % 60;
+	unsigned int seconds = (timestamp_ms / 1000UL) % 60;
+	unsigned int milliseconds = timestamp_ms % 1000;
+	int len = ::snprintf(buffer, size, "%lu+%02u:%02u:%02u.%03u",
+		days, hours, minutes, seconds, milliseconds);
+
+	return {buffer, len > 0 ? std::min((size_t)len, size - 1) : 0};
 }
 
 bool WebInterface::status(WebServer::Request &req) {
@@ -71,91 +106,151 @@ bool WebInterface::status(WebServer::Request &req) {
 
 	req.printf(
 			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-			"<?xml-stylesheet type=\"text/xsl\" href=\"/%s/status.xml\"?>"
-			"<r>", app_.immutable_id().c_str()
+			"<?xml-stylesheet type=\"text/xsl\" href=\"/%s/status.xml\"?>",
+			app_.immutable_id().c_str()
 	);
 
 	HX711 &hx711 = app_.hx711();
+	XmlWriter xml{req};
 
-	req.printf("<v>%d</v>", (int)hx711.reading());
+	xml.start("r");
+
+	xml.start("v");
+	xml.text((long)hx711.reading());
+	xml.end("v");
+
+	xml.start("h");
+	if (hx711.rate_selectable())
+		xml.attribute("s", 1L);
+	xml.text((long)hx711.rate());
+	xml.end("h");
 
 	if (hx711.start_us() > 0) {
-		std::vector<char> realtime(32);
+		char buffer[32];
 		time_t t = hx711.realtime_us().tv_sec;
 		struct tm tm{};
 
 		::localtime_r(&t, &tm);
-		::strftime(realtime.data(), realtime.size(), "%F %H:%M:%S", &tm);
+		size_t len = ::strftime(buffer, sizeof(buffer), "%F %H:%M:%S", &tm);
 
-		req.printf("<s t=\"%s\" u=\"%s\" d=\"%s\" c=\"%lu\" m=\"%lu\">",
-			realtime.data(),
-			format_timestamp_ms(hx711.start_us() / 1000).c_str(),
-			format_timestamp_ms(hx711.duration_us() / 1000).c_str(),
-			hx711.count(), hx711.max_count());
+		xml.start("s");
+		xml.attribute("t", std::string_view{buffer, len});
+		xml.attribute("u", format_timestamp_ms(hx711.start_us() / 1000, buffer, sizeof(buffer)));
+		xml.attribute("d", format_timestamp_ms(hx711.duration_us() / 1000, buffer, sizeof(buffer)));
+		xml.attribute("c", hx711.count());
+		xml.attribute("m", hx711.max_count());
+		if (hx711.max_duration_us())
+			xml.attribute("l", (unsigned long)(hx711.max_duration_us() / 60000000ULL));
 
 		if (hx711.running()) {
-			req.printf("<a/>");
+			xml.start("a");
+			xml.end("a");
 		}
 
 		if (hx711.has_tare()) {
-			req.printf("<z/>");
+			xml.start("z");
+			xml.end("z");
 		}
 
-		req.printf("</s>");
+		xml.end("s");
 	} else {
-		req.printf("<n/>");
+		xml.start("n");
+		if (hx711.max_duration_us())
+			xml.attribute("l", (unsigned long)(hx711.max_duration_us() / 60000000ULL));
+		xml.end("n");
 	}
 
-	req.print("</r>");
+	hx711.events([&xml] (const HX711::Event &event) {
+		char buffer[32];
+		time_t t = event.realtime.tv_sec;
+		struct tm tm{};
+
+		::localtime_r(&t, &tm);
+		size_t len = ::strftime(buffer, sizeof(buffer), "%H:%M:%S", &tm);
+
+		xml.start("e");
+		xml.attribute("k", recording::flag_name(event.type));
+		xml.attribute("t", std::string_view{buffer, len});
+		xml.attribute("l", (long)event.level);
+		if (event.type == StepDetector::SETTLED) {
+			xml.attribute("s", (long)event.step);
+			xml.attribute("m", (unsigned long)event.settling_ms);
+		}
+		xml.end("e");
+	});
+
+	xml.end("r");
 	return true;
 }
 
-bool WebInterface::action(WebServer::Request &req) {
-	if (req.get_header("Content-Type") != "application/x-www-form-urlencoded") {
+bool WebInterface::read_form(WebServer::Request &req, char *buffer, size_t size,
+		std::string_view &text) {
+	char content_type[48];
+
+	if (req.get_header("Content-Type", content_type, sizeof(content_type))
+			!= "application/x-www-form-urlencoded") {
 		req.set_status(400);
-		return true;
+		return false;
 	}
 
 	size_t len = req.available();
 
-	if (len > 256) {
+	if (len > size) {
 		req.set_status(413);
-		return true;
+		return false;
 	}
 
-	std::vector<char> buffer(len);
+	text = {buffer, req.readBytes(buffer, len)};
+	return true;
+}
+
+bool WebInterface::action(WebServer::Request &req) {
+	char buffer[256];
+	std::string_view text;
 
-	req.readBytes(buffer.data(), buffer.size());
+	if (!read_form(req, buffer, sizeof(buffer), text))
+		return true;
 
-	std::string_view text{buffer.data(), buffer.size()};
-	auto params = parse_form(text);
 	std::string_view action;
+	std::string_view rate;
 	const char *message = nullptr;
 
-	auto it = params.find("action");
-	if (it != params.end())
-		action = it->second;
+	parse_form(text, [&] (std::string_view name, std::string_view value) {
+		if (name == "action" && action.empty())
+			action = value;
+		else if (name == "rate" && rate.empty())
+			rate = value;
+	});
 
 	HX711 &hx711 = app_.hx711();
-	std::function func = []{};
+	void (HX711::*func)() = nullptr;
 
 	if (action == "start") {
 		message = "Started";
-		func = [&]{ hx711.start(); };
+		func = &HX711::start;
 	} else if (action == "tare") {
 		message = "Tare";
-		func = [&]{ hx711.tare(); };
+		func = &HX711::tare;
 	} else if (action == "stop") {
 		message = "Stopped";
-		func = [&]{ hx711.stop(); };
+		func = &HX711::stop;
+	} else if (action == "rate") {
+		unsigned int rate_hz = rate == "10" ? HX711::SLOW_RATE_HZ
+			: (rate == "80" ? HX711::FAST_RATE_HZ : 0);
+
+		logger_.info("Action \"%.*s\" %.*s by %s",
+			static_cast<int>(action.size()), action.begin(),
+			static_cast<int>(rate.size()), rate.begin(),
+			req.client_address().c_str());
+		message = hx711.rate(rate_hz) ? "Rate changed" : "Unable to change rate";
 	}
 
-	if (message) {
+	if (func) {
 		logger_.info("Action \"%.*s\" by %s",
 			static_cast<int>(action.size()), action.begin(),
 			req.client_address().c_str());
-		func();
-	} else {
+		(hx711.*func)();
+	} else if (!message) {
 		message = "Unknown action";
 	}
 
@@ -177,24 +272,57 @@ bool WebInterface::action(WebServer::Request &req) {
 	return true;
 }
 
+static std::string_view format_float(float value, int precision, char *buffer, size_t size) {
+	int len = ::snprintf(buffer, size, "%.*f", precision, (double)value);
+
+	return {buffer, len > 0 ? std::min((size_t)len, size - 1) : 0};
+}
+
 bool WebInterface::files(WebServer::Request &req) {
 	req.set_status(200);
 	req.set_type("application/xml");
 	req.add_header("Cache-Control", "no-cache");
+	req.compress();
 
 	req.printf(
 			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-			"<?xml-stylesheet type=\"text/xsl\" href=\"/%s/files.xml\"?>"
-			"<r>", app_.immutable_id().c_str()
+			"<?xml-stylesheet type=\"text/xsl\" href=\"/%s/files.xml\"?>",
+			app_.immutable_id().c_str()
 	);
 
 	HX711 &hx711 = app_.hx711();
+	XmlWriter xml{req};
+
+	xml.start("r");
+
+	Uploader &uploader = app_.uploader();
+
+	/* Opening each file to read its statistics allocates memory in the filesystem */
+	hx711.list_files([&xml, &uploader] (std::string_view filename, std::string_view timestamp,
+			bool resident, const recording::Statistics *statistics) {
+		xml.start("f");
+		xml.attribute("n", filename);
+		if (resident)
+			xml.attribute("m", 1L);
+		if (uploader.uploaded(filename))
+			xml.attribute("u", 1L);
+		if (statistics) {
+			char buffer[24];
+
+			xml.attribute("c", (unsigned long)statistics->count);
+			xml.attribute("t", (unsigned long)statistics->tares);
+			if (statistics->count) {
+				xml.attribute("l", (long)statistics->min);
+				xml.attribute("h", (long)statistics->max);
+				xml.attribute("a", format_float(statistics->mean, 1, buffer, sizeof(buffer)));
+				xml.attribute("s", format_float(statistics->stddev(), 1, buffer, sizeof(buffer)));
+			}
+		}
+		xml.text(timestamp);
+		xml.end("f");
+	}, true);
 
-	hx711.list_files([&] (const std::string &filename, const std::string &timestamp) {
-		req.printf("<f n=\"%s\">%s</f>", filename.c_str(), timestamp.c_str());
-	});
-
-	req.print("</r>");
+	xml.end("r");
 	return true;
 }
 
@@ -215,16 +343,37 @@ bool WebInterface::access_file(WebServer::Request &req) {
 		download = false;
 	}
 
-	if (exists) {
+	if (exists && download && !hx711.resident_file(filename) && hx711.file_pending(filename)) {
+		req.set_status(503);
+		req.set_type("text/plain");
+		req.add_header("Cache-Control", "no-cache");
+		req.add_header("Retry-After", "5");
+		req.printf("Not saved yet");
+	} else if (exists) {
 		req.set_status(200);
 
 		if (download) {
 			req.set_type("application/cbor");
 			req.add_header("Cache-Control", "no-cache");
-			req.add_header("Content-Disposition", "attachment; filename=\""
-				+ hx711.file_name(std::string{filename}, true) + ".cbor\"");
-
-			hx711.get_file(filename, req);
+			char name[32];
+			char disposition[64];
+			auto timestamp = hx711.file_name(filename, true, name, sizeof(name));
+
+			::snprintf(disposition, sizeof(disposition), "attachment; filename=\"%.*s.cbor\"",
+				(int)timestamp.size(), timestamp.data());
+			req.add_header("Content-Disposition", std::string_view{disposition});
+
+			auto session = hx711.resident_file(filename);
+
+			if (session) {
+				/* Send directly from memory instead of compressing it for every client */
+				session->for_each_encoded([&req] (const uint8_t *data, size_t size) {
+					req.write_memory(data, size);
+				});
+			} else {
+				req.compress();
+				hx711.get_file(filename, req);
+			}
 		} else {
 			hx711.delete_file(filename);
 
@@ -247,32 +396,351 @@ bool WebInterface::access_file(WebServer::Request &req) {
 	return true;
 }
 
-std::unordered_map<std::string_view,std::string_view>
-		WebInterface::parse_form(std::string_view text) {
-	std::unordered_map<std::string_view,std::string_view> params;
+bool WebInterface::spectrum(WebServer::Request &req) {
+	constexpr const char *spectrum_prefix = "/spectrum/";
+	auto filename = req.uri();
+	HX711 &hx711 = app_.hx711();
 
-	while (text.length() > 0) {
-		std::string_view value;
-		auto amp_pos = text.find('&');
+	if (filename.rfind(spectrum_prefix, 0) == 0)
+		filename.remove_prefix(::strlen(spectrum_prefix));
 
-		if (amp_pos != std::string_view::npos) {
-			value = text.substr(0, amp_pos);
-			text.remove_prefix(amp_pos + 1);
-		} else {
-			value = text;
-			text = {};
+	/* This is an async handler so the analysis doesn't delay the readings */
+	auto spectrum = std::make_unique<Spectrum>();
+
+	if (!hx711.read_readings(filename, [&spectrum] (uint64_t time_us, int32_t value, uint8_t) {
+				spectrum->add(time_us, value);
+			})) {
+		req.set_status(404);
+		req.set_type("text/plain");
+		req.add_header("Cache-Control", "no-cache");
+		req.printf("Not found");
+		return true;
+	}
+
+	std::array<Spectrum::Peak,SPECTRUM_PEAKS> peaks;
+	std::array<Spectrum::Peak,SPECTRUM_POINTS> points;
+	size_t found = spectrum->peaks(peaks.data(), peaks.size());
+	float max_amplitude = 0;
+	char buffer[32];
+
+	spectrum->decimate(points.data(), points.size());
+	for (const auto &point : points)
+		max_amplitude = std::max(max_amplitude, point.amplitude);
+
+	req.set_status(200);
+	req.set_type("application/xml");
+	req.add_header("Cache-Control", "no-cache");
+
+	req.printf(
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+			"<?xml-stylesheet type=\"text/xsl\" href=\"/%s/spectrum.xml\"?>",
+			app_.immutable_id().c_str()
+	);
+
+	XmlWriter xml{req};
+
+	xml.start("r");
+	xml.attribute("n", filename);
+	if (!filename.empty())
+		xml.attribute("t", hx711.file_name(filename, false, buffer, sizeof(buffer)));
+	xml.attribute("c", spectrum->count());
+	xml.attribute("w", spectrum->segments());
+	xml.attribute("h", format_float(spectrum->rate_hz(), 3, buffer, sizeof(buffer)));
+	xml.attribute("b", format_float(spectrum->resolution_hz(), 3, buffer, sizeof(buffer)));
+	xml.attribute("x", format_float(max_amplitude, 2, buffer, sizeof(buffer)));
+
+	for (size_t i = 0; i < found; i++) {
+		xml.start("p");
+		xml.attribute("f", format_float(peaks[i].frequency_hz, 3, buffer, sizeof(buffer)));
+		xml.attribute("a", format_float(peaks[i].amplitude, 2, buffer, sizeof(buffer)));
+		xml.end("p");
+	}
+
+	for (const auto &point : points) {
+		xml.start("m");
+		xml.attribute("f", format_float(point.frequency_hz, 3, buffer, sizeof(buffer)));
+		xml.attribute("a", format_float(point.amplitude, 2, buffer, sizeof(buffer)));
+		xml.end("m");
+	}
+
+	xml.end("r");
+	return true;
+}
+
+bool WebInterface::archive(WebServer::Request &req) {
+	HX711 &hx711 = app_.hx711();
+	std::vector<std::string> filenames;
+
+	parse_form(req.query(), [&filenames] (std::string_view name, std::string_view value) {
+		if (name == "f")
+			filenames.emplace_back(value);
+	});
+
+	if (filenames.empty()) {
+		hx711.list_files([&filenames] (std::string_view filename, std::string_view timestamp,
+				bool resident, const recording::Statistics *statistics) {
+			filenames.emplace_back(filename);
+		});
+	}
+
+	req.set_status(200);
+	req.set_type("application/x-tar");
+	req.add_header("Cache-Control", "no-cache");
+	req.add_header("Content-Disposition", "attachment; filename=\"readings.tar\"");
+	req.compress();
+
+	TarWriter tar{req};
+
+	for (const auto &filename : filenames) {
+		bool found = false;
+		size_t written = hx711.get_file(filename, req, [&] (size_t size) {
+			tar.begin_file(hx711.file_name(filename, true) + ".cbor", size,
+				::atol(filename.c_str()));
+			found = true;
+		});
+
+		if (found)
+			tar.end_file(written);
+	}
+
+	tar.finish();
+	return true;
+}
+
+bool WebInterface::delete_files(WebServer::Request &req) {
+	std::vector<char> buffer(4096);
+	std::string_view text;
+
+	if (!read_form(req, buffer.data(), buffer.size(), text))
+		return true;
+
+	HX711 &hx711 = app_.hx711();
+	std::vector<std::string_view> filenames;
+	bool all = false;
+	unsigned int count;
+
+	parse_form(text, [&] (std::string_view name, std::string_view value) {
+		if (name == "f") {
+			filenames.push_back(value);
+		} else if (name == "all") {
+			all = true;
 		}
+	});
+
+	if (all) {
+		count = hx711.delete_all_files();
+	} else {
+		count = hx711.delete_files(filenames);
+	}
 
-		auto eq_pos = value.find('=');
+	logger_.info("Deleted %u files by %s", count, req.client_address().c_str());
 
-		if (eq_pos != std::string_view::npos) {
-			params.emplace(value.substr(0, eq_pos), value.substr(eq_pos + 1));
-		} else {
-			params.emplace(value, "");
+	req.set_status(200);
+	req.set_type("text/html");
+	req.add_header("Cache-Control", "no-cache");
+	req.printf(
+		"<!DOCTYPE html><html><head>"
+		"<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
+		"<meta http-equiv=\"refresh\" content=\"0;URL=/files\">"
+		"<link rel=\"icon\" href=\"data:,\"/>"
+		"</head><body><p>%u deleted</p></body></html>", count);
+	return true;
+}
+
+bool WebInterface::trace_events(WebServer::Request &req) {
+	if (!trace::capacity()) {
+		req.set_status(404);
+		req.set_type("text/plain");
+		req.add_header("Cache-Control", "no-cache");
+		req.printf("Trace unavailable\n");
+		return true;
+	}
+
+	req.set_status(200);
+	req.set_type("application/json");
+	req.add_header("Cache-Control", "no-cache");
+	req.add_header("Content-Disposition", "attachment; filename=\"trace.json\"");
+	req.compress();
+
+	trace::write_json(req);
+	return true;
+}
+
+static void metric_header(WebServer::Request &out, const char *name, const char *type, const char *help) {
+	out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void metric(WebServer::Request &out, const char *name, const char *type, const char *help,
+		unsigned long value) {
+	metric_header(out, name, type, help);
+	out.printf("%s %lu\n", name, value);
+}
+
+bool WebInterface::metrics(WebServer::Request &req) {
+	HX711 &hx711 = app_.hx711();
+	const HX711::Stats &stats = hx711.stats();
+	uint32_t period_ns = stats.period_ns.load(std::memory_order_relaxed);
+
+	req.set_status(200);
+	req.set_type("text/plain; version=0.0.4");
+	req.add_header("Cache-Control", "no-cache");
+
+	metric(req, "hx711_samples_total", "counter", "Valid readings",
+		stats.samples.load(std::memory_order_relaxed));
+	metric_header(req, "hx711_sample_rate_hz", "gauge", "Estimated reading rate");
+	req.printf("hx711_sample_rate_hz %.3f\n", period_ns ? 1000000000.0 / period_ns : 0.0);
+	metric(req, "hx711_sample_jitter_ns", "gauge", "RMS error in measuring when readings were ready",
+		stats.jitter_ns.load(std::memory_order_relaxed));
+	metric(req, "hx711_invalid_reads_total", "counter", "Readings rejected as invalid",
+		stats.invalid_reads.load(std::memory_order_relaxed));
+	metric(req, "hx711_late_reads_total", "counter", "Readings more than 1.5 periods after the previous reading",
+		stats.late_reads.load(std::memory_order_relaxed));
+	metric(req, "hx711_dropped_readings_total", "counter", "Readings not recorded because the buffer is full",
+		stats.dropped_readings.load(std::memory_order_relaxed));
+	metric(req, "hx711_recording_readings", "gauge", "Readings in the current recording",
+		hx711.count());
+	metric(req, "hx711_recording_max_readings", "gauge", "Maximum readings in a recording",
+		hx711.max_count());
+	metric(req, "hx711_buffer_bytes", "gauge", "Size of the readings buffer",
+		hx711.buffer_bytes());
+	metric(req, "hx711_resident_recordings", "gauge", "Previous recordings held in the readings buffer",
+		hx711.resident_count());
+
+	metric(req, "hx711_saves_total", "counter", "Recordings saved",
+		stats.saves.load(std::memory_order_relaxed));
+	metric(req, "hx711_save_errors_total", "counter", "Recordings that failed to save",
+		stats.save_errors.load(std::memory_order_relaxed));
+	metric_header(req, "hx711_save_duration_seconds", "gauge", "Duration of the last save");
+	req.printf("hx711_save_duration_seconds %.6f\n",
+		stats.save_us.load(std::memory_order_relaxed) / 1000000.0);
+	metric_header(req, "hx711_save_duration_seconds_total", "counter", "Duration of all saves");
+	req.printf("hx711_save_duration_seconds_total %.3f\n",
+		stats.save_ms_total.load(std::memory_order_relaxed) / 1000.0);
+	metric(req, "hx711_save_bytes", "gauge", "Size of the last save",
+		stats.save_bytes.load(std::memory_order_relaxed));
+	metric(req, "hx711_save_bytes_total", "counter", "Size of all saves",
+		stats.save_bytes_total.load(std::memory_order_relaxed));
+	metric(req, "hx711_rotations_total", "counter", "Recordings continued in a new file",
+		stats.rotations.load(std::memory_order_relaxed));
+
+	const Uploader::Stats &upload_stats = app_.uploader().stats();
+
+	metric(req, "upload_files_total", "counter", "Recordings uploaded to the collector",
+		upload_stats.files.load(std::memory_order_relaxed));
+	metric(req, "upload_bytes_total", "counter", "Bytes uploaded to the collector",
+		upload_stats.bytes.load(std::memory_order_relaxed));
+	metric(req, "upload_resumed_total", "counter", "Uploads resumed from a partial upload",
+		upload_stats.resumed.load(std::memory_order_relaxed));
+	metric(req, "upload_connections_total", "counter", "Connections to the collector",
+		upload_stats.connections.load(std::memory_order_relaxed));
+	metric(req, "upload_errors_total", "counter", "Upload attempts that failed",
+		upload_stats.errors.load(std::memory_order_relaxed));
+
+	const TelemetrySender::Stats &telemetry_stats = app_.telemetry().stats();
+
+	metric(req, "telemetry_packets_total", "counter", "Telemetry packets sent",
+		telemetry_stats.packets.load(std::memory_order_relaxed));
+	metric(req, "telemetry_readings_total", "counter", "Readings sent as telemetry",
+		telemetry_stats.readings.load(std::memory_order_relaxed));
+	metric(req, "telemetry_overruns_total", "counter", "Readings replaced before they could be sent",
+		telemetry_stats.overruns.load(std::memory_order_relaxed));
+	metric(req, "telemetry_errors_total", "counter", "Telemetry packets that couldn't be sent",
+		telemetry_stats.errors.load(std::memory_order_relaxed));
+
+	metric(req, "trace_events_total", "counter", "Events added to the trace",
+		trace::count());
+	metric(req, "trace_event_overhead_ns", "gauge", "Time to add an event to the trace",
+		trace::overhead_ns());
+
+	metric_header(req, "http_requests_total", "counter", "HTTP requests handled");
+	server_.handler_stats([&] (const std::string &uri, const char *method,
+			const WebServer::HandlerStats &handler) {
+		req.printf("http_requests_total{handler=\"%s\",method=\"%s\"} %lu\n",
+			uri.c_str(), method, (unsigned long)handler.requests.load(std::memory_order_relaxed));
+	});
+
+	metric_header(req, "http_request_failures_total", "counter", "HTTP requests that failed");
+	server_.handler_stats([&] (const std::string &uri, const char *method,
+			const WebServer::HandlerStats &handler) {
+		req.printf("http_request_failures_total{handler=\"%s\",method=\"%s\"} %lu\n",
+			uri.c_str(), method, (unsigned long)handler.failures.load(std::memory_order_relaxed));
+	});
+
+	metric_header(req, "http_requests_rejected_total", "counter", "HTTP requests rejected because all workers were busy");
+	server_.handler_stats([&] (const std::string &uri, const char *method,
+			const WebServer::HandlerStats &handler) {
+		req.printf("http_requests_rejected_total{handler=\"%s\",method=\"%s\"} %lu\n",
+			uri.c_str(), method, (unsigned long)handler.rejected.load(std::memory_order_relaxed));
+	});
+
+	metric_header(req, "http_request_allocations_total", "counter", "Heap allocations while handling HTTP requests");
+	server_.handler_stats([&] (const std::string &uri, const char *method,
+			const WebServer::HandlerStats &handler) {
+		req.printf("http_request_allocations_total{handler=\"%s\",method=\"%s\"} %lu\n",
+			uri.c_str(), method, (unsigned long)handler.allocations.load(std::memory_order_relaxed));
+	});
+
+	metric(req, "http_async_stack_min_free_bytes", "gauge", "Minimum free stack of the async HTTP workers",
+		server_.async_stack_free());
+
+	const WebServer::GzipStats &gzip_stats = WebServer::gzip_stats();
+
+	metric(req, "http_gzip_responses_total", "counter", "HTTP responses compressed",
+		gzip_stats.responses.load(std::memory_order_relaxed));
+	metric(req, "http_gzip_input_bytes_total", "counter", "Bytes of HTTP responses before compression",
+		gzip_stats.input_bytes.load(std::memory_order_relaxed));
+	metric(req, "http_gzip_output_bytes_total", "counter", "Bytes of HTTP responses after compression",
+		gzip_stats.output_bytes.load(std::memory_order_relaxed));
+	metric_header(req, "http_gzip_cpu_seconds_total", "counter", "Time spent compressing HTTP responses");
+	req.printf("http_gzip_cpu_seconds_total %.3f\n",
+		gzip_stats.cpu_ms_total.load(std::memory_order_relaxed) / 1000.0);
+
+	metric_header(req, "http_request_duration_seconds", "histogram", "HTTP request latency");
+	server_.handler_stats([&] (const std::string &uri, const char *method,
+			const WebServer::HandlerStats &handler) {
+		unsigned long count = 0;
+
+		for (size_t i = 0; i < handler.buckets.size(); i++) {
+			count += handler.buckets[i].load(std::memory_order_relaxed);
+
+			if (i < handler.BUCKETS_MS.size()) {
+				req.printf("http_request_duration_seconds_bucket{handler=\"%s\",method=\"%s\",le=\"%.3f\"} %lu\n",
+					uri.c_str(), method, handler.BUCKETS_MS[i] / 1000.0, count);
+			} else {
+				req.printf("http_request_duration_seconds_bucket{handler=\"%s\",method=\"%s\",le=\"+Inf\"} %lu\n",
+					uri.c_str(), method, count);
+			}
 		}
+
+		req.printf("http_request_duration_seconds_sum{handler=\"%s\",method=\"%s\"} %.3f\n",
+			uri.c_str(), method, handler.duration_ms_total.load(std::memory_order_relaxed) / 1000.0);
+		req.printf("http_request_duration_seconds_count{handler=\"%s\",method=\"%s\"} %lu\n",
+			uri.c_str(), method, count);
+	});
+
+	metric(req, "heap_allocations_total", "counter", "Heap allocations", allocation_count());
+	metric(req, "heap_free_bytes", "gauge", "Free internal heap",
+		::heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+	metric(req, "heap_min_free_bytes", "gauge", "Minimum free internal heap",
+		::heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+	metric(req, "psram_free_bytes", "gauge", "Free PSRAM",
+		::heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+	metric(req, "psram_min_free_bytes", "gauge", "Minimum free PSRAM",
+		::heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+
+	unsigned long fs_total;
+	unsigned long fs_used;
+
+	{
+		std::lock_guard lock{App::file_mutex()};
+
+		fs_total = FS.totalBytes();
+		fs_used = FS.usedBytes();
 	}
 
-	return params;
+	metric(req, "filesystem_size_bytes", "gauge", "Filesystem size", fs_total);
+	metric(req, "filesystem_used_bytes", "gauge", "Filesystem used", fs_used);
+	return true;
 }
 
 } // namespace scales
@@ -23,14 +23,24 @@
 #include <arpa/inet.h>
 #include <esp_http_server.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstdarg>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <string>
 #include <vector>
 
+#include "scales/allocations.h"
+#include "scales/buffered_write.h"
+#include "scales/trace.h"
+
 #ifndef PSTR_ALIGN
 # define PSTR_ALIGN 4
 #endif
@@ -40,8 +50,10 @@ static const char __pstr__logger_name[] __attribute__((__aligned__(PSTR_ALIGN)))
 namespace scales {
 
 uuid::log::Logger WebServer::logger_{FPSTR(__pstr__logger_name), uuid::log::Facility::DAEMON};
+WebServer::GzipStats WebServer::gzip_stats_;
 
-WebServer::WebServer(uint16_t port) {
+WebServer::WebServer(uint16_t port, size_t async_workers)
+		: request_contexts_(1 + async_workers) {
 	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 	httpd_handle_t server = nullptr;
 	esp_err_t err;
@@ -49,12 +61,40 @@ WebServer::WebServer(uint16_t port) {
 	config.task_priority = uxTaskPriorityGet(nullptr);
 	config.server_port = port;
 	config.uri_match_fn = httpd_uri_match_wildcard;
+	/*
+	 * Async requests keep their socket open while they run on a worker, but
+	 * httpd needs 3 of the LWIP sockets for itself. With the default of 10
+	 * sockets there's no room for more than the default 7 connections.
+	 *
+	 * Instead of httpd's LRU purge (which would close the socket of an
+	 * async request that has been running for a while) the least recently
+	 * used socket that isn't being used by an async request is closed when
+	 * all of them are in use. If all of the other sockets are in use by
+	 * async requests then new connections wait until one finishes.
+	 */
+	size_t max_open_sockets = config.max_open_sockets + async_workers;
+
+	sockets_.max_open(std::min(CONFIG_LWIP_MAX_SOCKETS - 3, (int)max_open_sockets));
+	config.max_open_sockets = sockets_.max_open();
+	config.lru_purge_enable = false;
+	config.global_user_ctx = &sockets_;
+	config.global_user_ctx_free_fn = [] (void*) {};
+	config.open_fn = Sockets::open;
+	config.close_fn = Sockets::close;
+
+	if (config.max_open_sockets < max_open_sockets) {
+		logger_.warning("Limited to %u open sockets instead of %zu by CONFIG_LWIP_MAX_SOCKETS=%d",
+			config.max_open_sockets, max_open_sockets, CONFIG_LWIP_MAX_SOCKETS);
+	}
 
 	err = httpd_start(&server, &config);
 
 	if (err == ESP_OK) {
 		handle_ = std::unique_ptr<void,HandleDeleter>{server};
 		logger_.debug("Started HTTP server");
+
+		if (async_workers > 0)
+			async_workers_ = std::make_unique<AsyncWorkers>(async_workers);
 	} else {
 		logger_.crit("Failed to start HTTP server: %d", err);
 	}
@@ -68,11 +108,12 @@ WebServer::~WebServer() {
 		uri_handler->server_unregister(handle_.get());
 }
 
-bool WebServer::add_get_handler(const std::string &uri, get_function handler) {
+bool WebServer::add_get_handler(const std::string &uri, get_function handler, bool async) {
 	if (!handle_)
 		return false;
 
-	uri_handlers_.push_back(std::make_unique<GetURIHandler>(uri, std::move(handler)));
+	uri_handlers_.push_back(std::make_unique<GetURIHandler>(uri, std::move(handler),
+		request_contexts_, async ? async_workers_.get() : nullptr));
 
 	if (uri_handlers_.back()->server_register(handle_.get()))
 		return true;
@@ -83,11 +124,12 @@ bool WebServer::add_get_handler(const std::string &uri, get_function handler) {
 	return false;
 }
 
-bool WebServer::add_post_handler(const std::string &uri, get_function handler) {
+bool WebServer::add_post_handler(const std::string &uri, post_function handler, bool async) {
 	if (!handle_)
 		return false;
 
-	uri_handlers_.push_back(std::make_unique<PostURIHandler>(uri, std::move(handler)));
+	uri_handlers_.push_back(std::make_unique<PostURIHandler>(uri, std::move(handler),
+		request_contexts_, async ? async_workers_.get() : nullptr));
 
 	if (uri_handlers_.back()->server_register(handle_.get()))
 		return true;
@@ -115,7 +157,258 @@ bool WebServer::add_static_content(const std::string &uri, const char *content_t
 	return false;
 }
 
-WebServer::URIHandler::URIHandler(const std::string &uri) : uri_(uri) {
+void WebServer::handler_stats(stats_function func) const {
+	for (auto &uri_handler : uri_handlers_) {
+		func(uri_handler->uri(), uri_handler->method() == HTTP_POST ? "POST" : "GET",
+			uri_handler->stats());
+	}
+}
+
+size_t WebServer::async_stack_free() const {
+	return async_workers_ ? async_workers_->stack_free() : 0;
+}
+
+void WebServer::Sockets::max_open(size_t count) {
+	std::lock_guard lock{mutex_};
+
+	max_open_ = count;
+	sockets_.reserve(count);
+}
+
+WebServer::Sockets& WebServer::Sockets::get(httpd_handle_t server) {
+	return *reinterpret_cast<Sockets*>(httpd_get_global_user_ctx(server));
+}
+
+esp_err_t WebServer::Sockets::open(httpd_handle_t server, int sockfd) {
+	Sockets &sockets = get(server);
+	std::lock_guard lock{sockets.mutex_};
+	uint64_t now_us = ::esp_timer_get_time();
+
+	sockets.sockets_.push_back({sockfd, now_us, false});
+
+	/* Keep a socket available for the next connection */
+	if (sockets.sockets_.size() < sockets.max_open_)
+		return ESP_OK;
+
+	auto lru = sockets.sockets_.end();
+
+	for (auto it = sockets.sockets_.begin(); it != sockets.sockets_.end(); ++it) {
+		if (it->fd != sockfd && !it->async
+				&& (lru == sockets.sockets_.end() || it->used_us < lru->used_us))
+			lru = it;
+	}
+
+	if (lru != sockets.sockets_.end()) {
+		logger_.trace("Closing least recently used socket %d", lru->fd);
+		httpd_sess_trigger_close(server, lru->fd);
+		sockets.sockets_.erase(lru);
+	} else {
+		logger_.debug("All other sockets are in use by async requests");
+	}
+
+	return ESP_OK;
+}
+
+void WebServer::Sockets::close(httpd_handle_t server, int sockfd) {
+	Sockets &sockets = get(server);
+
+	{
+		std::lock_guard lock{sockets.mutex_};
+
+		sockets.sockets_.erase(std::remove_if(sockets.sockets_.begin(), sockets.sockets_.end(),
+			[sockfd] (const Socket &socket) { return socket.fd == sockfd; }),
+			sockets.sockets_.end());
+	}
+
+	::close(sockfd);
+}
+
+void WebServer::Sockets::used(httpd_req_t *req) {
+	Sockets &sockets = get(req->handle);
+	std::lock_guard lock{sockets.mutex_};
+	int sockfd = httpd_req_to_sockfd(req);
+
+	for (auto &socket : sockets.sockets_) {
+		if (socket.fd == sockfd)
+			socket.used_us = ::esp_timer_get_time();
+	}
+}
+
+void WebServer::Sockets::async(httpd_handle_t server, int sockfd, bool async) {
+	Sockets &sockets = get(server);
+	std::lock_guard lock{sockets.mutex_};
+
+	for (auto &socket : sockets.sockets_) {
+		if (socket.fd == sockfd) {
+			socket.async = async;
+			socket.used_us = ::esp_timer_get_time();
+		}
+	}
+}
+
+void WebServer::HandlerStats::record(uint32_t duration_us, uint32_t allocations_,
+		bool success) {
+	uint32_t duration_ms = duration_us / 1000;
+	size_t bucket = 0;
+
+	while (bucket < BUCKETS_MS.size() && duration_us > BUCKETS_MS[bucket] * 1000)
+		bucket++;
+
+	requests.fetch_add(1, std::memory_order_relaxed);
+	if (!success)
+		failures.fetch_add(1, std::memory_order_relaxed);
+	duration_ms_total.fetch_add(duration_ms, std::memory_order_relaxed);
+	allocations.fetch_add(allocations_, std::memory_order_relaxed);
+	buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+WebServer::RequestContexts::RequestContexts(size_t count) {
+	/*
+	 * Only one request can be handled at a time by the httpd task and by
+	 * each async worker, so this is enough to avoid allocating later.
+	 */
+	contexts_.reserve(count);
+	available_.reserve(count);
+
+	for (size_t i = 0; i < count; i++) {
+		contexts_.push_back(std::make_unique<Request::Context>());
+		available_.push_back(contexts_.back().get());
+	}
+}
+
+WebServer::Request::Context* WebServer::RequestContexts::acquire() {
+	std::lock_guard lock{mutex_};
+
+	if (available_.empty()) {
+		logger_.warning("Allocating additional request context");
+		contexts_.push_back(std::make_unique<Request::Context>());
+		available_.reserve(contexts_.size());
+		return contexts_.back().get();
+	}
+
+	auto *context = available_.back();
+	available_.pop_back();
+	return context;
+}
+
+void WebServer::RequestContexts::release(Request::Context *context) {
+	std::lock_guard lock{mutex_};
+
+	available_.push_back(context);
+}
+
+WebServer::RequestContexts::Lease::Lease(RequestContexts &contexts)
+		: contexts_(contexts), context_(contexts.acquire()) {
+}
+
+WebServer::RequestContexts::Lease::~Lease() {
+	contexts_.release(context_);
+}
+
+WebServer::AsyncWorkers::AsyncWorkers(size_t count)
+		: queue_(xQueueCreate(count, sizeof(Job))),
+		idle_(xSemaphoreCreateCounting(count, 0)),
+		stopped_(xSemaphoreCreateCounting(count, 0)) {
+	if (!queue_ || !idle_ || !stopped_) {
+		logger_.crit("Failed to allocate async workers");
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (xTaskCreate(worker_task, "httpd_async", STACK_SIZE, this,
+				uxTaskPriorityGet(nullptr), nullptr) != pdPASS) {
+			logger_.crit("Failed to start async worker %u", i);
+			break;
+		}
+
+		count_++;
+	}
+
+	logger_.debug("Started %u async workers", count_);
+}
+
+WebServer::AsyncWorkers::~AsyncWorkers() {
+	Job stop{nullptr, nullptr};
+
+	for (size_t i = 0; i < count_; i++)
+		xQueueSend(queue_, &stop, portMAX_DELAY);
+
+	for (size_t i = 0; i < count_; i++)
+		xSemaphoreTake(stopped_, portMAX_DELAY);
+
+	if (stopped_)
+		vSemaphoreDelete(stopped_);
+
+	if (idle_)
+		vSemaphoreDelete(idle_);
+
+	if (queue_)
+		vQueueDelete(queue_);
+}
+
+esp_err_t WebServer::AsyncWorkers::submit(httpd_req_t *req, URIHandler *handler,
+		uint64_t start_us) {
+	Job job{nullptr, handler, start_us};
+
+	if (!count_ || xSemaphoreTake(idle_, 0) != pdTRUE) {
+		logger_.warning("No async workers available for %s", req->uri);
+		handler->stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+		httpd_resp_set_status(req, "503 Service Unavailable");
+		httpd_resp_set_hdr(req, "Retry-After", "5");
+		httpd_resp_set_type(req, "text/plain");
+		return httpd_resp_sendstr(req, "Busy");
+	}
+
+	if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+		xSemaphoreGive(idle_);
+		return ESP_FAIL;
+	}
+
+	Sockets::async(req->handle, httpd_req_to_sockfd(req), true);
+
+	/* There is always space because a worker was idle */
+	xQueueSend(queue_, &job, portMAX_DELAY);
+	return ESP_OK;
+}
+
+void WebServer::AsyncWorkers::worker_task(void *arg) {
+	AsyncWorkers &workers = *reinterpret_cast<AsyncWorkers*>(arg);
+
+	while (true) {
+		Job job;
+
+		xSemaphoreGive(workers.idle_);
+
+		if (xQueueReceive(workers.queue_, &job, portMAX_DELAY) != pdTRUE)
+			continue;
+
+		if (!job.req)
+			break;
+
+		trace::complete(trace::Category::HTTP, "queued", job.start_us);
+
+		httpd_handle_t server = job.req->handle;
+		int sockfd = httpd_req_to_sockfd(job.req);
+
+		if (job.handler->run(job.req, job.start_us) != ESP_OK)
+			httpd_sess_trigger_close(server, sockfd);
+
+		httpd_req_async_handler_complete(job.req);
+		Sockets::async(server, sockfd, false);
+
+		/* Measured in bytes on the ESP32 */
+		size_t stack_free = uxTaskGetStackHighWaterMark(nullptr);
+
+		if (stack_free < workers.stack_free_)
+			workers.stack_free_ = stack_free;
+	}
+
+	xSemaphoreGive(workers.stopped_);
+	vTaskDelete(nullptr);
+}
+
+WebServer::URIHandler::URIHandler(const std::string &uri, AsyncWorkers *workers)
+		: uri_(uri), workers_(workers) {
 }
 
 bool WebServer::URIHandler::server_register(httpd_handle_t server) {
@@ -125,22 +418,42 @@ bool WebServer::URIHandler::server_register(httpd_handle_t server) {
 	httpd_handler.uri = uri_.c_str();
 	httpd_handler.user_ctx = this;
 	httpd_handler.handler = [] (httpd_req_t *req) -> esp_err_t {
-		return reinterpret_cast<WebServer::URIHandler*>(req->user_ctx)->handler_function(req);
+		auto *handler = reinterpret_cast<WebServer::URIHandler*>(req->user_ctx);
+		uint64_t start_us = ::esp_timer_get_time();
+
+		Sockets::used(req);
+
+		if (handler->workers_)
+			return handler->workers_->submit(req, handler, start_us);
+
+		return handler->run(req, start_us);
 	};
 
 	return httpd_register_uri_handler(server, &httpd_handler) == ESP_OK;
 }
 
+esp_err_t WebServer::URIHandler::run(httpd_req_t *req, uint64_t start_us) {
+	trace::Span span{trace::Category::HTTP, method() == HTTP_POST ? "POST" : "GET", uri_.c_str()};
+	TaskAllocations allocations;
+	esp_err_t ret = handler_function(req);
+
+	stats_.record(std::min(::esp_timer_get_time() - start_us, (uint64_t)UINT32_MAX),
+		allocations.count(), ret == ESP_OK);
+	return ret;
+}
+
 void WebServer::URIHandler::server_unregister(httpd_handle_t server) {
 	httpd_unregister_uri_handler(server, uri_.c_str(), method());
 }
 
-WebServer::GetURIHandler::GetURIHandler(const std::string &uri, get_function handler)
-		: URIHandler(uri), function_(handler) {
+WebServer::GetURIHandler::GetURIHandler(const std::string &uri, get_function handler,
+		RequestContexts &contexts, AsyncWorkers *workers)
+		: URIHandler(uri, workers), contexts_(contexts), function_(handler) {
 }
 
-WebServer::PostURIHandler::PostURIHandler(const std::string &uri, post_function handler)
-		: URIHandler(uri), function_(handler) {
+WebServer::PostURIHandler::PostURIHandler(const std::string &uri, post_function handler,
+		RequestContexts &contexts, AsyncWorkers *workers)
+		: URIHandler(uri, workers), contexts_(contexts), function_(handler) {
 }
 
 WebServer::StaticContentURIHandler::StaticContentURIHandler(const std::string &uri,
@@ -155,7 +468,8 @@ httpd_method_t WebServer::GetURIHandler::method() {
 }
 
 esp_err_t WebServer::GetURIHandler::handler_function(httpd_req_t *req) {
-	Request ws_req{req};
+	RequestContexts::Lease context{contexts_};
+	Request ws_req{req, *context};
 
 	if (function_(ws_req)) {
 		ws_req.finish();
@@ -170,7 +484,8 @@ httpd_method_t WebServer::PostURIHandler::method() {
 }
 
 esp_err_t WebServer::PostURIHandler::handler_function(httpd_req_t *req) {
-	Request ws_req{req};
+	RequestContexts::Lease context{contexts_};
+	Request ws_req{req, *context};
 
 	if (function_(ws_req)) {
 		ws_req.finish();
@@ -200,8 +515,8 @@ esp_err_t WebServer::StaticContentURIHandler::handler_function(httpd_req_t *req)
 	return httpd_resp_send(req, data_.begin(), data_.length());
 }
 
-WebServer::Request::Request(httpd_req_t *req) : req_(req),
-	content_len_(req_->content_len), buffer_(1436 - 7) {
+WebServer::Request::Request(httpd_req_t *req, Context &context) : req_(req),
+	context_(context), content_len_(req_->content_len) {
 }
 
 int WebServer::Request::available() {
@@ -228,44 +543,149 @@ size_t WebServer::Request::readBytes(char *buffer, size_t length) {
 }
 
 size_t WebServer::Request::write(uint8_t c) {
-	buffer_[buffer_len_] = (char)c;
+	if (gzip_)
+		return write(&c, 1);
+
+	context_.buffer[buffer_len_] = (char)c;
 	buffer_len_++;
 
-	if (buffer_len_ == buffer_.size())
+	if (buffer_len_ == context_.buffer.size())
 		send();
 
 	return 1;
 }
 
 size_t WebServer::Request::write(const uint8_t *buffer, size_t size) {
-	size_t written = 0;
+	if (gzip_) {
+		gzip_write(buffer, size);
+	} else {
+		buffer_write(buffer, size);
+	}
+
+	return size;
+}
 
-	while (size > 0) {
-		auto remaining = std::min(size, buffer_.size() - buffer_len_);
+size_t WebServer::Request::write_memory(const uint8_t *buffer, size_t size) {
+	if (gzip_ || size <= context_.buffer.size() - buffer_len_)
+		return write(buffer, size);
 
-		std::memcpy(&buffer_[buffer_len_], buffer + written, remaining);
-		buffer_len_ += remaining;
+	send();
+
+	if (send_err_ == ESP_OK)
+		send_err_ = httpd_resp_send_chunk(req_, reinterpret_cast<const char*>(buffer), size);
+	sent_ = true;
+	return size;
+}
 
-		size -= remaining;
-		written += remaining;
+void WebServer::Request::gzip_write(const uint8_t *buffer, size_t size) {
+	uint64_t start_us = ::esp_timer_get_time();
+	uint64_t send_us = send_us_;
 
-		if (buffer_len_ == buffer_.size())
+	gzip_->write(buffer, size);
+
+	/* Exclude the time spent sending compressed output */
+	gzip_us_ += ::esp_timer_get_time() - start_us - (send_us_ - send_us);
+}
+
+void WebServer::Request::buffer_write(const uint8_t *buffer, size_t size) {
+	buffered_write(context_.buffer.data(), context_.buffer.size(), buffer_len_,
+		buffer, size, [this] { send(); });
+}
+
+size_t WebServer::Request::printf(const char *format, ...) {
+	va_list ap;
+
+	va_start(ap, format);
+	size_t len = vprintf(format, ap);
+	va_end(ap);
+
+	return len;
+}
+
+size_t WebServer::Request::vprintf(const char *format, va_list ap) {
+	va_list copy_ap;
+	char *buffer;
+	size_t size;
+	int len;
+
+	if (gzip_) {
+		buffer = context_.scratch.data();
+		size = context_.scratch.size();
+	} else {
+		if (buffer_len_ == context_.buffer.size())
 			send();
+
+		buffer = &context_.buffer[buffer_len_];
+		size = context_.buffer.size() - buffer_len_;
+	}
+
+	va_copy(copy_ap, ap);
+	len = ::vsnprintf(buffer, size, format, copy_ap);
+	va_end(copy_ap);
+
+	if (len < 0)
+		return 0;
+
+	if ((size_t)len < size) {
+		if (gzip_) {
+			gzip_write(reinterpret_cast<uint8_t*>(buffer), len);
+		} else {
+			buffer_len_ += len;
+		}
+		return len;
+	}
+
+	if (!gzip_ && buffer_len_ > 0 && (size_t)len < context_.buffer.size()) {
+		/* Send what's already buffered and format at the start of the buffer */
+		send();
+
+		va_copy(copy_ap, ap);
+		::vsnprintf(context_.buffer.data(), context_.buffer.size(), format, copy_ap);
+		va_end(copy_ap);
+
+		buffer_len_ = len;
+		return len;
 	}
 
-	return written;
+	/* Too long for any of the buffers */
+	std::vector<char> tmp(len + 1);
+
+	va_copy(copy_ap, ap);
+	::vsnprintf(tmp.data(), tmp.size(), format, copy_ap);
+	va_end(copy_ap);
+
+	return write(reinterpret_cast<uint8_t*>(tmp.data()), len);
 }
 
 void WebServer::Request::send() {
 	if (buffer_len_ > 0) {
+		uint64_t start_us = ::esp_timer_get_time();
+
 		if (send_err_ == ESP_OK)
-			send_err_ = httpd_resp_send_chunk(req_, buffer_.data(), buffer_len_);
+			send_err_ = httpd_resp_send_chunk(req_, context_.buffer.data(), buffer_len_);
 		buffer_len_ = 0;
 		sent_ = true;
+		send_us_ += ::esp_timer_get_time() - start_us;
 	}
 }
 
 void WebServer::Request::finish() {
+	if (gzip_) {
+		uint64_t start_us = ::esp_timer_get_time();
+		uint64_t send_us = send_us_;
+
+		gzip_->finish();
+		gzip_us_ += ::esp_timer_get_time() - start_us - (send_us_ - send_us);
+
+		gzip_stats_.responses.fetch_add(1, std::memory_order_relaxed);
+		gzip_stats_.input_bytes.fetch_add(gzip_->input_bytes(), std::memory_order_relaxed);
+		gzip_stats_.output_bytes.fetch_add(gzip_->output_bytes(), std::memory_order_relaxed);
+		gzip_stats_.cpu_ms_total.fetch_add(gzip_us_ / 1000, std::memory_order_relaxed);
+
+		logger_.debug("Compressed %s from %zu to %zu bytes using %" PRIu64 "us of CPU time",
+			req_->uri, gzip_->input_bytes(), gzip_->output_bytes(), gzip_us_);
+	}
+
 	if (sent_) {
 		send();
 		httpd_resp_send_chunk(req_, nullptr, 0);
@@ -273,7 +693,7 @@ void WebServer::Request::finish() {
 		if (!status_)
 			httpd_resp_set_status(req_, HTTPD_204);
 
-		httpd_resp_send(req_, buffer_.data(), buffer_len_);
+		httpd_resp_send(req_, context_.buffer.data(), buffer_len_);
 	}
 }
 
@@ -281,6 +701,16 @@ const std::string_view WebServer::Request::uri() const {
 	return req_->uri;
 }
 
+const std::string_view WebServer::Request::query() const {
+	std::string_view uri = req_->uri;
+	auto pos = uri.find('?');
+
+	if (pos == std::string_view::npos)
+		return {};
+
+	return uri.substr(pos + 1);
+}
+
 void WebServer::Request::set_status(unsigned int status) {
 	if (status == 200) {
 		httpd_resp_set_status(req_, HTTPD_200);
@@ -292,6 +722,8 @@ void WebServer::Request::set_status(unsigned int status) {
 		httpd_resp_set_status(req_, HTTPD_404);
 	} else if (status == 413) {
 		httpd_resp_set_status(req_, "413 Request Entity Too Large");
+	} else if (status == 503) {
+		httpd_resp_set_status(req_, "503 Service Unavailable");
 	} else {
 		httpd_resp_set_status(req_, HTTPD_500);
 	}
@@ -306,9 +738,64 @@ void WebServer::Request::add_header(const char *name, const char *value) {
 	httpd_resp_set_hdr(req_, name, value);
 }
 
-void WebServer::Request::add_header(const char *name, const std::string &value) {
-	resp_headers_.emplace_back(strdup(value.c_str()));
-	add_header(name, resp_headers_.back().get());
+void WebServer::Request::add_header(const char *name, std::string_view value) {
+	/* httpd keeps a pointer to the value until the response is sent */
+	if (headers_len_ + value.size() + 1 > context_.headers.size()) {
+		logger_.err("No space for header %s in response to %s", name, req_->uri);
+		return;
+	}
+
+	char *copy = &context_.headers[headers_len_];
+
+	std::memcpy(copy, value.data(), value.size());
+	copy[value.size()] = '\0';
+	headers_len_ += value.size() + 1;
+
+	add_header(name, const_cast<const char*>(copy));
+}
+
+bool WebServer::Request::compress() {
+	if (gzip_)
+		return true;
+
+	if (sent_ || buffer_len_ > 0)
+		return false;
+
+	char accept_encoding[128];
+
+	if (!GzipEncoder::accepted(get_header("Accept-Encoding",
+			accept_encoding, sizeof(accept_encoding))))
+		return false;
+
+	auto output = [this] (const uint8_t *data, size_t length) {
+		buffer_write(data, length);
+	};
+
+	if (context_.gzip) {
+		context_.gzip->reset(output);
+	} else {
+		/* The encoder is too large to keep one in internal RAM for every context */
+		static constexpr uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+		void *memory = ::heap_caps_malloc(sizeof(GzipEncoder), caps);
+
+		if (!memory) {
+			logger_.warning("Not enough PSRAM to compress %s", req_->uri);
+			return false;
+		}
+
+		context_.gzip.reset(new (memory) GzipEncoder{output});
+	}
+
+	add_header("Content-Encoding", "gzip");
+	add_header("Vary", "Accept-Encoding");
+
+	gzip_ = context_.gzip.get();
+	return true;
+}
+
+void WebServer::Request::GzipDeleter::operator()(GzipEncoder *gzip) {
+	gzip->~GzipEncoder();
+	::free(gzip);
 }
 
 std::string WebServer::Request::client_address() {
@@ -373,4 +860,20 @@ std::string WebServer::Request::get_header(const char *name) {
 	return buffer.data();
 }
 
+std::string_view WebServer::Request::get_header(const char *name, char *buffer, size_t size) {
+	if (size == 0)
+		return {};
+
+	buffer[0] = '\0';
+
+	switch (httpd_req_get_hdr_value_str(req_, name, buffer, size)) {
+	case ESP_OK:
+	case ESP_ERR_HTTPD_RESULT_TRUNC:
+		return buffer;
+
+	default:
+		return {};
+	}
+}
+
 } // namespace scales
@@ -0,0 +1,127 @@
+/*
+ * hx711-weigh-scales-logger - HX711 weigh scales data logger
+ * Copyright 2025  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scales/xml_writer.h"
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace scales {
+
+XmlWriter::XmlWriter(Print &output) : output_(output) {
+}
+
+void XmlWriter::start(const char *name) {
+	close_tag();
+	output_.write('<');
+	output_.write(name, std::strlen(name));
+	open_ = true;
+}
+
+void XmlWriter::attribute(const char *name, std::string_view value) {
+	output_.write(' ');
+	output_.write(name, std::strlen(name));
+	output_.write("=\"", 2);
+	escape(value);
+	output_.write('"');
+}
+
+void XmlWriter::attribute(const char *name, long value) {
+	char buffer[24];
+	int len = ::snprintf(buffer, sizeof(buffer), "%ld", value);
+
+	attribute(name, std::string_view{buffer, (size_t)len});
+}
+
+void XmlWriter::attribute(const char *name, unsigned long value) {
+	char buffer[24];
+	int len = ::snprintf(buffer, sizeof(buffer), "%lu", value);
+
+	attribute(name, std::string_view{buffer, (size_t)len});
+}
+
+void XmlWriter::text(std::string_view value) {
+	close_tag();
+	escape(value);
+}
+
+void XmlWriter::text(long value) {
+	char buffer[24];
+	int len = ::snprintf(buffer, sizeof(buffer), "%ld", value);
+
+	text(std::string_view{buffer, (size_t)len});
+}
+
+void XmlWriter::end(const char *name) {
+	if (open_) {
+		output_.write("/>", 2);
+		open_ = false;
+	} else {
+		output_.write("</", 2);
+		output_.write(name, std::strlen(name));
+		output_.write('>');
+	}
+}
+
+void XmlWriter::close_tag() {
+	if (open_) {
+		output_.write('>');
+		open_ = false;
+	}
+}
+
+void XmlWriter::escape(std::string_view value) {
+	while (!value.empty()) {
+		auto pos = value.find_first_of("&<>\"'");
+
+		output_.write(value.data(), std::min(pos, value.size()));
+
+		if (pos == std::string_view::npos)
+			break;
+
+		switch (value[pos]) {
+		case '&':
+			output_.write("&amp;", 5);
+			break;
+
+		case '<':
+			output_.write("&lt;", 4);
+			break;
+
+		case '>':
+			output_.write("&gt;", 4);
+			break;
+
+		case '"':
+			output_.write("&quot;", 6);
+			break;
+
+		case '\'':
+			output_.write("&apos;", 6);
+			break;
+		}
+
+		value.remove_prefix(pos + 1);
+	}
+}
+
+} // namespace scales
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# hx711-weigh-scales-logger - HX711 weigh scales data logger
+# Copyright 2025  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Measure /action latency while several slow clients download recordings.
+#
+# Usage: async-download-test.py <host[:port]> [--downloads 3] [--file <name>]
+#
+# The action posted is unknown to the device so it has no side effects. With
+# async download handlers the latency should stay close to the idle latency
+# instead of waiting for the downloads to complete.
+
+import argparse
+import http.client
+import re
+import statistics
+import sys
+import threading
+import time
+
+
+def download(host, path, rate, stop, results):
+	conn = http.client.HTTPConnection(host, timeout=60)
+	conn.request("GET", path)
+	resp = conn.getresponse()
+	length = 0
+	start = time.monotonic()
+
+	while not stop.is_set():
+		data = resp.read(512)
+		if not data:
+			break
+		length += len(data)
+		if rate:
+			# Emulate a slow client
+			delay = length / rate - (time.monotonic() - start)
+			if delay > 0:
+				time.sleep(delay)
+
+	conn.close()
+	results.append((resp.status, length, time.monotonic() - start))
+
+
+def action(host):
+	conn = http.client.HTTPConnection(host, timeout=60)
+	start = time.monotonic()
+	conn.request("POST", "/action", "action=none",
+		{"Content-Type": "application/x-www-form-urlencoded"})
+	resp = conn.getresponse()
+	resp.read()
+	conn.close()
+	return resp.status, time.monotonic() - start
+
+
+def latencies(host, count, interval):
+	values = []
+	for i in range(count):
+		status, elapsed = action(host)
+		if status != 200:
+			print(f"/action returned {status}", file=sys.stderr)
+		values.append(elapsed * 1000)
+		time.sleep(interval)
+	return values
+
+
+def summary(name, values):
+	values = sorted(values)
+	p99 = values[min(len(values) - 1, int(len(values) * 0.99))]
+	print(f"{name}: n={len(values)} p50={statistics.median(values):.1f}ms p99={p99:.1f}ms max={values[-1]:.1f}ms")
+	return p99
+
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Async download handler load test")
+	parser.add_argument("host", help="Device host[:port]")
+	parser.add_argument("--downloads", type=int, default=3, help="Concurrent downloads")
+	parser.add_argument("--file", help="Recording to download (default: first in /files)")
+	parser.add_argument("--rate", type=int, default=8192, help="Download rate per client (bytes/s, 0 for unlimited)")
+	parser.add_argument("--requests", type=int, default=50, help="Number of /action requests")
+	parser.add_argument("--interval", type=float, default=0.1, help="Interval between /action requests (s)")
+	parser.add_argument("--max-p99", type=float, default=500, help="Fail if /action p99 latency is above this (ms)")
+	args = parser.parse_args()
+
+	filename = args.file
+	if filename is None:
+		conn = http.client.HTTPConnection(args.host, timeout=60)
+		conn.request("GET", "/files")
+		match = re.search(r'<f n="([^"]+)"', conn.getresponse().read().decode("utf-8"))
+		conn.close()
+		if not match:
+			print("No recordings to download", file=sys.stderr)
+			sys.exit(1)
+		filename = match.group(1)
+
+	idle = latencies(args.host, args.requests, args.interval)
+
+	stop = threading.Event()
+	results = []
+	threads = [threading.Thread(target=download,
+			args=(args.host, "/download/" + filename, args.rate, stop, results))
+		for i in range(args.downloads)]
+	for thread in threads:
+		thread.start()
+
+	# Give the downloads time to start
+	time.sleep(1)
+	busy = latencies(args.host, args.requests, args.interval)
+
+	stop.set()
+	for thread in threads:
+		thread.join()
+
+	summary("/action idle", idle)
+	p99 = summary(f"/action with {args.downloads} downloads", busy)
+	for status, length, elapsed in results:
+		print(f"download: status={status} bytes={length} time={elapsed:.1f}s")
+
+	if p99 > args.max_p99:
+		print(f"/action p99 latency {p99:.1f}ms exceeds {args.max_p99:.1f}ms", file=sys.stderr)
+		sys.exit(1)
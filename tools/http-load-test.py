@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+# hx711-weigh-scales-logger - HX711 weigh scales data logger
+# Copyright 2025  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Load test the web interface with a mix of concurrent clients.
+#
+# Usage: http-load-test.py <host[:port]> [--scenario lab] [--duration 60]
+#        http-load-test.py --stand-in [--scenario lab]
+#
+# Clients:
+#   pollers     GET / repeatedly (like the status page)
+#   scrapers    GET /metrics repeatedly
+#   downloaders GET /download/<file> repeatedly, optionally rate limited
+#   actions     POST /action occasionally (an unknown action with no effect)
+#
+# Latency percentiles and throughput are reported per endpoint. With
+# --stand-in a local server with the same endpoints is used instead of a
+# device, which is only useful for checking the load generator itself.
+
+import argparse
+import http.client
+import http.server
+import json
+import random
+import re
+import sys
+import threading
+import time
+
+SCENARIOS = {
+	# One person watching the status page
+	"idle": dict(pollers=1, poll_interval=1.0, scrapers=0, downloaders=0, action_interval=0),
+	# Several people and two scrapers at once
+	"lab": dict(pollers=4, poll_interval=1.0, scrapers=2, scrape_interval=5.0,
+		downloaders=1, action_interval=5.0),
+	# Downloads competing with the status page
+	"downloads": dict(pollers=2, poll_interval=0.5, scrapers=0, downloaders=3, action_interval=2.0),
+	# As many status requests as possible
+	"flood": dict(pollers=8, poll_interval=0, scrapers=0, downloaders=0, action_interval=0),
+}
+
+
+class Stats:
+	def __init__(self):
+		self.lock = threading.Lock()
+		self.endpoints = {}
+
+	def record(self, endpoint, latency, length, ok):
+		with self.lock:
+			entry = self.endpoints.setdefault(endpoint,
+				{"latencies": [], "bytes": 0, "errors": 0})
+			if ok:
+				entry["latencies"].append(latency)
+				entry["bytes"] += length
+			else:
+				entry["errors"] += 1
+
+	def summary(self, duration):
+		result = {}
+		with self.lock:
+			for endpoint, entry in sorted(self.endpoints.items()):
+				values = sorted(entry["latencies"])
+				result[endpoint] = {
+					"requests": len(values),
+					"errors": entry["errors"],
+					"p50_ms": percentile(values, 0.50) * 1000,
+					"p99_ms": percentile(values, 0.99) * 1000,
+					"max_ms": (values[-1] if values else 0) * 1000,
+					"requests_per_s": len(values) / duration,
+					"bytes_per_s": entry["bytes"] / duration,
+				}
+		return result
+
+
+def percentile(values, fraction):
+	if not values:
+		return 0
+	return values[min(len(values) - 1, int(len(values) * fraction))]
+
+
+class Client:
+	def __init__(self, host, keep_alive, timeout):
+		self.host = host
+		self.keep_alive = keep_alive
+		self.timeout = timeout
+		self.conn = None
+
+	def request(self, method, path, body=None, headers={}, rate=0, stop=None):
+		if self.conn is None:
+			self.conn = http.client.HTTPConnection(self.host, timeout=self.timeout)
+
+		start = time.monotonic()
+		try:
+			self.conn.request(method, path, body, headers)
+			resp = self.conn.getresponse()
+			length = 0
+			while True:
+				data = resp.read(4096)
+				if not data:
+					break
+				length += len(data)
+				if rate:
+					delay = length / rate - (time.monotonic() - start)
+					if delay > 0:
+						time.sleep(delay)
+				if stop is not None and stop.is_set():
+					self.close()
+					return resp.status, length, time.monotonic() - start, False
+			ok = 200 <= resp.status < 300
+			if not self.keep_alive or resp.will_close:
+				self.close()
+			return resp.status, length, time.monotonic() - start, ok
+		except (OSError, http.client.HTTPException):
+			self.close()
+			return 0, 0, time.monotonic() - start, False
+
+	def close(self):
+		if self.conn is not None:
+			self.conn.close()
+			self.conn = None
+
+
+def endpoint_name(path):
+	if path.startswith("/download/"):
+		return "/download/*"
+	return path
+
+
+def repeat(args, stats, stop, method, path, interval, body=None, headers={}, rate=0):
+	client = Client(args.host, args.keep_alive, args.timeout)
+	# Spread out the clients
+	stop.wait(random.uniform(0, interval))
+	while not stop.is_set():
+		start = time.monotonic()
+		status, length, latency, ok = client.request(method, path, body, headers, rate,
+			stop if rate else None)
+		if not stop.is_set():
+			stats.record(endpoint_name(path), latency, length, ok)
+		stop.wait(max(0, interval - (time.monotonic() - start)))
+	client.close()
+
+
+def find_file(host, timeout):
+	conn = http.client.HTTPConnection(host, timeout=timeout)
+	conn.request("GET", "/files")
+	match = re.search(r'<f n="([^"]+)"', conn.getresponse().read().decode("utf-8"))
+	conn.close()
+	return match.group(1) if match else None
+
+
+class StandInHandler(http.server.BaseHTTPRequestHandler):
+	protocol_version = "HTTP/1.1"
+	disable_nagle_algorithm = True
+	download = bytes(random.Random(0).getrandbits(8) for i in range(256 * 1024))
+
+	def send(self, status, content_type, data):
+		self.send_response(status)
+		self.send_header("Content-Type", content_type)
+		self.send_header("Content-Length", str(len(data)))
+		self.end_headers()
+		self.wfile.write(data)
+
+	def do_GET(self):
+		if self.path == "/":
+			self.send(200, "application/xml", b'<?xml version="1.0" encoding="UTF-8"?><r><v>1234</v><n/></r>')
+		elif self.path == "/files":
+			self.send(200, "application/xml", b'<?xml version="1.0" encoding="UTF-8"?><r><f n="1735689600.cbor" s="262144"/></r>')
+		elif self.path.startswith("/download/"):
+			self.send(200, "application/cbor", self.download)
+		elif self.path == "/metrics":
+			self.send(200, "text/plain; version=0.0.4", b"hx711_readings_total 0\n" * 40)
+		else:
+			self.send(404, "text/plain", b"Not Found")
+
+	def do_POST(self):
+		self.rfile.read(int(self.headers.get("Content-Length", 0)))
+		if self.path == "/action":
+			self.send(200, "text/html", b"<!DOCTYPE html><html><body><p>Unknown action</p></body></html>")
+		else:
+			self.send(404, "text/plain", b"Not Found")
+
+	def log_message(self, format, *args):
+		pass
+
+
+class StandInServer(http.server.ThreadingHTTPServer):
+	def handle_error(self, request, client_address):
+		# Downloads are disconnected when the test stops
+		pass
+
+
+def stand_in():
+	server = StandInServer(("127.0.0.1", 0), StandInHandler)
+	server.daemon_threads = True
+	threading.Thread(target=server.serve_forever, daemon=True).start()
+	return server, f"127.0.0.1:{server.server_address[1]}"
+
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Web interface load test")
+	parser.add_argument("host", nargs="?", help="Device host[:port]")
+	parser.add_argument("--stand-in", action="store_true", help="Run against a local stand-in server")
+	parser.add_argument("--scenario", choices=SCENARIOS.keys(), default="lab", help="Client mix")
+	parser.add_argument("--duration", type=float, default=60, help="Test duration (s)")
+	parser.add_argument("--pollers", type=int, help="Clients polling /")
+	parser.add_argument("--poll-interval", type=float, help="Interval between polls (s)")
+	parser.add_argument("--scrapers", type=int, help="Clients scraping /metrics")
+	parser.add_argument("--scrape-interval", type=float, help="Interval between scrapes (s)")
+	parser.add_argument("--downloaders", type=int, help="Clients downloading a recording")
+	parser.add_argument("--rate", type=int, default=0, help="Download rate per client (bytes/s, 0 for unlimited)")
+	parser.add_argument("--file", help="Recording to download (default: first in /files)")
+	parser.add_argument("--action-interval", type=float, help="Interval between /action posts (s, 0 for none)")
+	parser.add_argument("--keep-alive", action="store_true", help="Reuse connections")
+	parser.add_argument("--timeout", type=float, default=30, help="Request timeout (s)")
+	parser.add_argument("--json", action="store_true", help="Output results as JSON")
+	args = parser.parse_args()
+
+	scenario = {"scrape_interval": 15.0, **SCENARIOS[args.scenario]}
+	for key in scenario:
+		if getattr(args, key) is None:
+			setattr(args, key, scenario[key])
+
+	server = None
+	if args.stand_in:
+		server, args.host = stand_in()
+	elif args.host is None:
+		parser.error("host is required unless using --stand-in")
+
+	filename = args.file
+	if args.downloaders and filename is None:
+		filename = find_file(args.host, args.timeout)
+		if filename is None:
+			print("No recordings to download", file=sys.stderr)
+			sys.exit(1)
+
+	stats = Stats()
+	stop = threading.Event()
+	threads = []
+
+	for i in range(args.pollers):
+		threads.append(threading.Thread(target=repeat,
+			args=(args, stats, stop, "GET", "/", args.poll_interval)))
+	for i in range(args.scrapers):
+		threads.append(threading.Thread(target=repeat,
+			args=(args, stats, stop, "GET", "/metrics", args.scrape_interval)))
+	for i in range(args.downloaders):
+		threads.append(threading.Thread(target=repeat,
+			args=(args, stats, stop, "GET", "/download/" + filename, 0),
+			kwargs=dict(rate=args.rate)))
+	if args.action_interval:
+		threads.append(threading.Thread(target=repeat,
+			args=(args, stats, stop, "POST", "/action", args.action_interval),
+			kwargs=dict(body="action=none",
+				headers={"Content-Type": "application/x-www-form-urlencoded"})))
+
+	start = time.monotonic()
+	for thread in threads:
+		thread.start()
+
+	try:
+		stop.wait(args.duration)
+	except KeyboardInterrupt:
+		pass
+
+	stop.set()
+	for thread in threads:
+		thread.join()
+	duration = time.monotonic() - start
+
+	if server is not None:
+		server.shutdown()
+
+	result = stats.summary(duration)
+	if args.json:
+		print(json.dumps({"scenario": args.scenario, "duration_s": duration, "endpoints": result}, indent=2))
+	else:
+		print(f"Scenario {args.scenario}: {args.pollers} pollers, {args.scrapers} scrapers, "
+			f"{args.downloaders} downloaders, {duration:.1f}s")
+		print(f"{'Endpoint':<14} {'Requests':>8} {'Errors':>6} {'p50 ms':>8} {'p99 ms':>8} {'max ms':>8} {'req/s':>7} {'KB/s':>8}")
+		for endpoint, entry in result.items():
+			print(f"{endpoint:<14} {entry['requests']:>8} {entry['errors']:>6} {entry['p50_ms']:>8.1f} "
+				f"{entry['p99_ms']:>8.1f} {entry['max_ms']:>8.1f} {entry['requests_per_s']:>7.1f} "
+				f"{entry['bytes_per_s'] / 1024:>8.1f}")
+
+	if any(entry["errors"] for entry in result.values()):
+		sys.exit(1)
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+# hx711-weigh-scales-logger - HX711 weigh scales data logger
+# Copyright 2025  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Stand-in collector for recordings uploaded by devices.
+#
+# Usage: upload-server.py [--port 8080] [--directory uploads] [--drop-after <bytes>]
+#        upload-server.py --self-test
+#
+# Configure the device with "upload url http://<host>:<port>/<device name>"
+# and recordings are stored in <directory>/<device name>/.
+#
+# Protocol, for each recording at <url>/<filename>.cbor:
+#   HEAD returns 200 with the number of bytes received in Upload-Offset (or
+#        404 if there are none)
+#   POST with Upload-Offset (which must match) and Upload-Length appends the
+#        body and returns 204 with the new Upload-Offset
+#
+# Partial uploads are kept as <filename>.cbor.part until they're complete.
+# With --drop-after the connection is closed after receiving that many bytes
+# of each recording, so that the device has to resume the upload. Requests
+# on each connection are logged so that batching can be checked. With
+# --self-test the server is checked by a client that behaves like a device.
+
+import argparse
+import http.client
+import http.server
+import os
+import random
+import shutil
+import sys
+import tempfile
+import threading
+
+
+class Collector(http.server.ThreadingHTTPServer):
+	daemon_threads = True
+
+	def __init__(self, address, directory, drop_after):
+		super().__init__(address, UploadHandler)
+		self.directory = os.path.abspath(directory)
+		self.drop_after = drop_after
+		self.dropped = set()
+		self.lock = threading.Lock()
+
+
+class UploadHandler(http.server.BaseHTTPRequestHandler):
+	protocol_version = "HTTP/1.1"
+
+	def setup(self):
+		super().setup()
+		self.requests = 0
+
+	def log_message(self, format, *args):
+		print(f"{self.client_address[0]}:{self.client_address[1]} #{self.requests} {format % args}",
+			file=sys.stderr)
+
+	def paths(self):
+		parts = [part for part in self.path.split("?")[0].split("/") if part]
+		if not parts or not parts[-1].endswith(".cbor") or any(part in (".", "..") for part in parts):
+			return None, None
+		path = os.path.join(self.server.directory, *parts)
+		return path, path + ".part"
+
+	def reply(self, status, offset=None):
+		self.send_response(status)
+		if offset is not None:
+			self.send_header("Upload-Offset", str(offset))
+		self.send_header("Content-Length", "0")
+		self.end_headers()
+
+	def offset(self, path, part):
+		if os.path.exists(path):
+			return os.path.getsize(path)
+		if os.path.exists(part):
+			return os.path.getsize(part)
+		return None
+
+	def do_HEAD(self):
+		self.requests += 1
+		path, part = self.paths()
+		if path is None:
+			self.reply(400)
+			return
+
+		with self.server.lock:
+			offset = self.offset(path, part)
+		if offset is None:
+			self.reply(404)
+		else:
+			self.reply(200, offset)
+
+	def do_POST(self):
+		self.requests += 1
+		path, part = self.paths()
+		try:
+			offset = int(self.headers["Upload-Offset"])
+			total = int(self.headers["Upload-Length"])
+			length = int(self.headers["Content-Length"])
+		except (TypeError, ValueError):
+			self.reply(400)
+			self.close_connection = True
+			return
+
+		if path is None or offset + length != total:
+			self.reply(400)
+			self.close_connection = True
+			return
+
+		with self.server.lock:
+			current = self.offset(path, part) or 0
+			if os.path.exists(path) or current != offset:
+				self.reply(409, current)
+				self.close_connection = True
+				return
+
+			drop = None
+			if self.server.drop_after and path not in self.server.dropped:
+				self.server.dropped.add(path)
+				drop = self.server.drop_after
+
+			os.makedirs(os.path.dirname(part), exist_ok=True)
+			with open(part, "ab") as f:
+				remaining = length
+				while remaining > 0:
+					data = self.rfile.read(min(remaining, 4096 if drop is None else min(4096, drop)))
+					if not data:
+						break
+					f.write(data)
+					remaining -= len(data)
+					if drop is not None:
+						drop -= len(data)
+						if drop <= 0:
+							self.log_message("Dropped connection at %d/%d", total - remaining, total)
+							self.close_connection = True
+							return
+
+			offset = os.path.getsize(part)
+			if offset == total:
+				os.rename(part, path)
+
+		self.reply(204, offset)
+
+
+def upload(conn, url_path, data):
+	"""Upload data in the same way as a device, returning True when complete"""
+	conn.request("HEAD", url_path)
+	resp = conn.getresponse()
+	resp.read()
+	if resp.status == 404:
+		offset = 0
+	elif resp.status == 200:
+		offset = int(resp.getheader("Upload-Offset"))
+	else:
+		raise RuntimeError(f"HEAD {url_path}: {resp.status}")
+
+	if offset == len(data):
+		return True
+
+	conn.request("POST", url_path, data[offset:], {
+		"Content-Type": "application/cbor",
+		"Upload-Offset": str(offset),
+		"Upload-Length": str(len(data)),
+	})
+	resp = conn.getresponse()
+	resp.read()
+	return resp.status // 100 == 2 and int(resp.getheader("Upload-Offset")) == len(data)
+
+
+def self_test():
+	directory = tempfile.mkdtemp()
+	server = Collector(("127.0.0.1", 0), directory, 10000)
+	threading.Thread(target=server.serve_forever, daemon=True).start()
+	host = f"127.0.0.1:{server.server_address[1]}"
+	files = {f"{1760000000 + i}": random.randbytes(size)
+		for i, size in enumerate([100, 5000, 25000, 60000])}
+	connections = 0
+
+	try:
+		pending = list(files)
+		while pending and connections < 10:
+			conn = http.client.HTTPConnection(host, timeout=10)
+			connections += 1
+			try:
+				while pending:
+					if not upload(conn, f"/test/{pending[0]}.cbor", files[pending[0]]):
+						break
+					pending.pop(0)
+			except (http.client.HTTPException, ConnectionError):
+				pass
+			conn.close()
+
+		for name, data in files.items():
+			with open(os.path.join(directory, "test", name + ".cbor"), "rb") as f:
+				if f.read() != data:
+					raise RuntimeError(f"{name}: contents differ")
+	finally:
+		server.shutdown()
+		shutil.rmtree(directory)
+
+	print(f"{len(files)} files uploaded on {connections} connections")
+	# The two files larger than --drop-after must each have been resumed once
+	return 0 if not pending and connections == 3 else 1
+
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Stand-in collector for uploaded recordings")
+	parser.add_argument("--port", type=int, default=8080, help="Port to listen on")
+	parser.add_argument("--directory", default="uploads", help="Directory to store recordings in")
+	parser.add_argument("--drop-after", type=int, default=0, help="Close the connection after receiving this many bytes of each recording")
+	parser.add_argument("--self-test", action="store_true", help="Check the server with a local client")
+	args = parser.parse_args()
+
+	if args.self_test:
+		sys.exit(self_test())
+
+	server = Collector(("", args.port), args.directory, args.drop_after)
+	print(f"Storing uploads in {server.directory}", file=sys.stderr)
+	server.serve_forever()